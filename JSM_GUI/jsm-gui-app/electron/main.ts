@@ -277,6 +277,87 @@ async function saveWindowState(bounds: Electron.Rectangle) {
   }
 }
 
+// Binary telemetry layout (protocol v3), see JoyShockMapper/include/Telemetry.h
+const TELEMETRY_MAGIC = 0x544d534a // "JSMT"
+const TELEMETRY_PACKET_SAMPLE = 1
+const TELEMETRY_PACKET_ROSTER = 2
+const TELEMETRY_SAMPLE_SIZE = 72
+const TELEMETRY_ROSTER_DEVICES_OFFSET = 12
+const TELEMETRY_DEVICE_SIZE = 20
+
+type TelemetryDevice = { handle: number; type: number; split: number; vid: number; pid: number }
+
+// The device roster is only sent when controllers change, so remember it and attach it to each sample
+let telemetryDevices: TelemetryDevice[] = []
+
+function decodeBinarySample(msg: Buffer): Record<string, unknown> | null {
+  if (msg.length < TELEMETRY_SAMPLE_SIZE) {
+    return null
+  }
+  const curveBytes = msg.subarray(56, 72)
+  const curveEnd = curveBytes.indexOf(0)
+  return {
+    protoVer: msg.readUInt16LE(4),
+    ts: Number(msg.readBigUInt64LE(8)),
+    omega: msg.readFloatLE(16),
+    t: msg.readFloatLE(20),
+    sensX: msg.readFloatLE(24),
+    sensY: msg.readFloatLE(28),
+    minThr: msg.readFloatLE(32),
+    maxThr: msg.readFloatLE(36),
+    SminX: msg.readFloatLE(40),
+    SmaxX: msg.readFloatLE(44),
+    SminY: msg.readFloatLE(48),
+    SmaxY: msg.readFloatLE(52),
+    curve: curveBytes.subarray(0, curveEnd < 0 ? curveBytes.length : curveEnd).toString('ascii'),
+  }
+}
+
+function decodeBinaryRoster(msg: Buffer): TelemetryDevice[] {
+  const devices: TelemetryDevice[] = []
+  if (msg.length < TELEMETRY_ROSTER_DEVICES_OFFSET) {
+    return devices
+  }
+  const deviceCount = msg.readUInt32LE(8)
+  for (let i = 0; i < deviceCount; i++) {
+    const offset = TELEMETRY_ROSTER_DEVICES_OFFSET + i * TELEMETRY_DEVICE_SIZE
+    if (offset + TELEMETRY_DEVICE_SIZE > msg.length) {
+      break
+    }
+    devices.push({
+      handle: msg.readInt32LE(offset),
+      type: msg.readInt32LE(offset + 4),
+      split: msg.readInt32LE(offset + 8),
+      vid: msg.readInt32LE(offset + 12),
+      pid: msg.readInt32LE(offset + 16),
+    })
+  }
+  return devices
+}
+
+// Returns a sample to forward to the renderer, or null for roster and unknown packets
+function decodeTelemetryPacket(msg: Buffer): Record<string, unknown> | null {
+  if (msg.length >= 8 && msg.readUInt32LE(0) === TELEMETRY_MAGIC) {
+    const type = msg.readUInt16LE(6)
+    if (type === TELEMETRY_PACKET_ROSTER) {
+      telemetryDevices = decodeBinaryRoster(msg)
+      return null
+    }
+    if (type === TELEMETRY_PACKET_SAMPLE) {
+      const sample = decodeBinarySample(msg)
+      return sample && { ...sample, devices: telemetryDevices }
+    }
+    return null
+  }
+  // Legacy JSON payload (TELEMETRY_FORMAT = JSON)
+  const payload = JSON.parse(msg.toString('utf8'))
+  if (payload?.type === 'roster') {
+    telemetryDevices = Array.isArray(payload.devices) ? payload.devices : []
+    return null
+  }
+  return { ...payload, devices: payload.devices ?? telemetryDevices }
+}
+
 function startTelemetryListener() {
   if (telemetrySocket) {
     return
@@ -287,7 +368,11 @@ function startTelemetryListener() {
   })
   telemetrySocket.on('message', msg => {
     try {
-      latestTelemetryPacket = JSON.parse(msg.toString('utf8'))
+      const packet = decodeTelemetryPacket(msg)
+      if (!packet) {
+        return
+      }
+      latestTelemetryPacket = packet
       if (win && !win.isDestroyed()) {
         win.webContents.send('telemetry-sample', latestTelemetryPacket)
       }
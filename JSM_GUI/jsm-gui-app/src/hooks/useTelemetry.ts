@@ -1,6 +1,8 @@
 import { useEffect, useState } from 'react'
 
 export type TelemetrySample = {
+  protoVer?: number
+  ts?: number
   omega?: number
   t?: number
   u?: number
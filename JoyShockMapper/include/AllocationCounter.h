@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+// Number of times operator new has been called so far in the process, by any thread. Counting replaces the global
+// operator new, so it's only built in with the JSM_COUNT_ALLOCATIONS option, and this is nullopt otherwise.
+std::optional<size_t> AllocationCount();
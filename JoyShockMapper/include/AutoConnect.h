@@ -9,12 +9,13 @@ namespace JSM
 class AutoConnect : public PollingThread
 {
 public:
-	AutoConnect(shared_ptr<JslWrapper> joyshock, bool start);
+	// Reads the backend on each check, so that it follows REPLAY switching backends
+	AutoConnect(const atomic<shared_ptr<JslWrapper>> &joyshock, bool start);
 	virtual ~AutoConnect() = default;
 
 private:
 	bool AutoConnectPoll(void* param);
-	shared_ptr<JslWrapper> jsl;
+	const atomic<shared_ptr<JslWrapper>> &jsl;
 	int lastSize = 0;
 };
 
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Values of a variable by chord button. A variable has a handful of chords at most, so they're kept in a vector
+// sorted by key, the order a map would keep them in. A bitmap of the buttons present answers the lookups for chords
+// that aren't there without searching. Keys from 0 to KeyCount - 1 use the bitmap, others are always searched.
+// Values stay at the same address until they're erased.
+template<typename Key, typename Value, std::size_t KeyCount>
+class ChordTable
+{
+public:
+	using Entry = std::pair<const Key, Value>;
+
+	const Entry *entry(Key key) const
+	{
+		if (inRange(key) && !_present.test(std::size_t(key)))
+		{
+			return nullptr;
+		}
+		auto found = lowerBound(key);
+		return found != _entries.end() && (*found)->first == key ? found->get() : nullptr;
+	}
+
+	Entry *entry(Key key)
+	{
+		return const_cast<Entry *>(std::as_const(*this).entry(key));
+	}
+
+	const Value *find(Key key) const
+	{
+		auto found = entry(key);
+		return found ? &found->second : nullptr;
+	}
+
+	Value *find(Key key)
+	{
+		auto found = entry(key);
+		return found ? &found->second : nullptr;
+	}
+
+	// Construct the value of a key that isn't in the table yet. Returns the value in the table either way.
+	template<typename... Args>
+	Value &emplace(Key key, Args &&...args)
+	{
+		if (auto existing = find(key))
+		{
+			return *existing;
+		}
+		auto added = _entries.insert(lowerBound(key), std::make_unique<Entry>(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)));
+		if (inRange(key))
+		{
+			_present.set(std::size_t(key));
+		}
+		return (*added)->second;
+	}
+
+	bool erase(Key key)
+	{
+		auto found = lowerBound(key);
+		if (found == _entries.end() || (*found)->first != key)
+		{
+			return false;
+		}
+		_entries.erase(found);
+		if (inRange(key))
+		{
+			_present.reset(std::size_t(key));
+		}
+		return true;
+	}
+
+	// The entries in key order
+	auto entries() const
+	{
+		return _entries | std::views::transform([](const std::unique_ptr<Entry> &entry) -> const Entry &
+		                    { return *entry; });
+	}
+
+	void clear()
+	{
+		_entries.clear();
+		_present.reset();
+	}
+
+	bool empty() const
+	{
+		return _entries.empty();
+	}
+
+	std::size_t size() const
+	{
+		return _entries.size();
+	}
+
+private:
+	// Negative keys wrap around to large values
+	static bool inRange(Key key)
+	{
+		return std::size_t(key) < KeyCount;
+	}
+
+	auto lowerBound(Key key) const
+	{
+		return std::ranges::lower_bound(_entries, key, {}, [](const std::unique_ptr<Entry> &entry)
+		  { return entry->first; });
+	}
+
+	std::vector<std::unique_ptr<Entry>> _entries;
+	std::bitset<KeyCount> _present;
+};
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "JoyShockMapper.h"
+#include "ProfileCache.h"
 
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string_view>
 
 // This is a base class for any Command line operation. It binds a command name to a parser function
@@ -21,6 +23,10 @@ public:
 	// themselves from their host variable when assigned NONE
 	typedef function<void(JSMCommand& me)> TaskOnDestruction;
 
+	// Arguments read ahead of time by compileData(). It applies them to a command of the same kind without
+	// parsing them again, reporting errors itself, and returns false only for a command of another kind.
+	typedef function<bool(JSMCommand& cmd)> CompiledData;
+
 protected:
 	// Parse functor to be assigned by derived class or overwritten
 	// Use setter to assign
@@ -67,11 +73,15 @@ public:
 
 	// Request this command to parse the command arguments. Returns true if the command was processed.
 	virtual bool parseData(string_view arguments, string_view label);
+
+	// Read the arguments ahead of time, for profiles that are loaded again. Returns an empty function when
+	// the arguments have to go through parseData() each time, which is the default.
+	virtual CompiledData compileData(string_view arguments, string_view label);
 };
 
 // The command registry holds all JSMCommands object and should not care what the derived type is.
 // It's capable of recognizing a command and requesting it to process arguments. That's it.
-// It uses regular expression to breakup a command string in its various components.
+// It uses ConfigParser to breakup a command string in its various components.
 // Currently it refuses to accept different commands with the same name but there's an
 // argument to be made to use the return value of JSMCommand::parseData() to attempt multiple
 // commands until one returns true. This can enable multiple parsers for the same command.
@@ -80,16 +90,32 @@ class CmdRegistry
 private:
 	typedef multimap<string_view, unique_ptr<JSMCommand>> CmdMap;
 
+	// A command line split in its parts. Its arguments are compiled the first time the line is run.
+	struct CommandLine
+	{
+		string line, combo, name, arguments, label;
+		char op = '\0';
+		optional<JSMCommand::CompiledData> compiled;
+	};
+
 	// multimap allows multiple entries with the same keys
 	CmdMap _registry;
 
+	// Profiles that were loaded before, and the one being loaded for the first time if any.
+	ProfileCache _profiles;
+	ProfileCache::Profile* _recording = nullptr;
+
 	static string_view strtrim(string_view str);
 
-	static bool findCommandWithName(string_view name, const CmdMap::value_type& pair);
+	void runLine(CommandLine& command);
+
+	bool runCommand(JSMCommand& cmd, CommandLine& command, bool compile);
 
 public:
 	CmdRegistry();
 
+	// Run the commands of a file. The file is compiled the first time and the compiled profile is replayed
+	// afterwards, until the file changes.
 	// Not string_view because the string is modified inside
 	bool loadConfigFile(string fileName);
 
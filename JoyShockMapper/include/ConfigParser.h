@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string_view>
+
+// Splits the text of the JSM config language into its parts: command lines, assignments and mapping values.
+// The Tokenizer reads the characters once, left to right. The Regex versions are the regular expressions it
+// replaces, kept while it proves itself: configure with JSM_REGEX_CONFIG_PARSER to use them again. Both give
+// the same parts for the same text.
+namespace ConfigParser
+{
+// [combo op] name arguments [# label]
+struct Line
+{
+	std::string_view combo; // The chord, sim press or diagonal press button, if any
+	char op = '\0';         // What combines combo and name: one of the ops given to parseLine
+	std::string_view name;  // Of the command
+	std::string_view arguments;
+	std::string_view label; // Comment after the #
+};
+
+// [action] key [event] rest
+struct MappingToken
+{
+	char action = '\0'; // ! ^ -
+	std::string_view key;
+	char event = '\0'; // \ / + ' _
+	std::string_view rest;
+};
+
+namespace Tokenizer
+{
+// ops are the characters that can join a combo to the name, like ",+*". Returns false for text that isn't a
+// line, and then all parts are empty.
+bool parseLine(std::string_view line, std::string_view ops, Line &out);
+
+// "= value", with any spaces around the =
+bool parseAssignment(std::string_view arguments, std::string_view &value);
+
+// Reads the first key of a mapping value, with its modifiers. Returns false when there is none left.
+bool nextMappingToken(std::string_view value, MappingToken &out);
+
+// + - or a word
+bool isCommandName(std::string_view name);
+} // namespace Tokenizer
+
+namespace Regex
+{
+bool parseLine(std::string_view line, std::string_view ops, Line &out);
+bool parseAssignment(std::string_view arguments, std::string_view &value);
+bool nextMappingToken(std::string_view value, MappingToken &out);
+bool isCommandName(std::string_view name);
+} // namespace Regex
+
+#ifdef JSM_REGEX_CONFIG_PARSER
+namespace Active = Regex;
+#else
+namespace Active = Tokenizer;
+#endif
+} // namespace ConfigParser
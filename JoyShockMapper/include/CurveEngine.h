@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// Same values as AccelCurve (minus INVALID). Kept separate so that the engine, like the curve
+// functions, doesn't depend on the rest of JSM.
+enum class CurveShape
+{
+    LINEAR,
+    NATURAL,
+    POWER,
+    QUADRATIC,
+    SIGMOID,
+    JUMP,
+};
+
+struct CurveParams
+{
+    CurveShape shape = CurveShape::LINEAR;
+    float minThreshold = 0.0f;
+    float maxThreshold = 0.0f;
+    float naturalVHalf = 0.0f;
+    float powerVRef = 0.0f;
+    float powerExponent = 0.0f;
+    float sigmoidMid = 0.0f;
+    float sigmoidWidth = 0.0f;
+    float jumpTau = 0.0f;
+
+    bool operator==(const CurveParams &) const = default;
+};
+
+// Evaluates the acceleration curves with everything that only depends on the curve settings computed ahead of time.
+// Every curve has the form S = sMin + (sMax - sMin) * t(omega), so the shape t is evaluated once for both axes.
+// Matches NaturalSensitivity, PowerSensitivity, QuadraticSensitivity, SigmoidSensitivity, JumpSensitivity and the
+// linear interpolation in joyShockPollCallback.
+class CurveEngine
+{
+public:
+    static constexpr size_t TABLE_SIZE = 1024;
+
+    // Cheap when nothing changed. With useTable, the curves that need exp or pow are sampled into a table
+    // and interpolated linearly, falling back to the exact shape beyond the table.
+    void configure(const CurveParams &params, bool useTable);
+
+    // omegaAdjusted is the input speed minus MIN_GYRO_THRESHOLD, floored at 0
+    float shape(float omegaAdjusted) const;
+
+    void evaluate(float omegaAdjusted, float sMinX, float sMaxX, float sMinY, float sMaxY, float &sensX, float &sensY) const
+    {
+        const float t = shape(omegaAdjusted);
+        sensX = sMinX + (sMaxX - sMinX) * t;
+        sensY = sMinY + (sMaxY - sMinY) * t;
+    }
+
+private:
+    float exactShape(float omegaAdjusted) const;
+    float tableRange() const;
+
+    CurveParams _params;
+    bool _configured = false;
+    bool _useTable = false;
+
+    // Precomputed from _params
+    float _linearScale = 0.0f;  // 1 / (maxThreshold - minThreshold), or 0 for a step
+    float _naturalK = 0.0f;     // ln(2) / vHalf
+    float _powerInvVRef = 0.0f;
+    float _quadraticInvCap = 0.0f;
+    float _sigmoidInvWidth = 0.0f;
+    float _sigmoidRaw0 = 0.0f;
+    float _sigmoidInvDenom = 0.0f; // 0 when the curve is flat
+    float _jumpInvTau = 0.0f;
+    float _jumpRaw0 = 0.0f;
+    float _jumpInvDenom = 0.0f;
+
+    // Table of the shape over [0, _tableEnd]
+    std::array<float, TABLE_SIZE + 1> _table{};
+    float _tableEnd = 0.0f;
+    float _tableScale = 0.0f; // TABLE_SIZE / _tableEnd
+};
@@ -4,6 +4,7 @@
 #include "JoyShockMapper.h"
 #include "Gamepad.h"
 #include "MotionIf.h"
+#include "PendingChanges.h"
 #include <chrono>
 #include <deque>
 #include <mutex>
@@ -123,11 +124,14 @@ public:
 		deque<pair<ButtonID, KeyCode>> gyroActionQueue; // Queue of gyro control actions currently in effect
 		deque<pair<ButtonID, KeyCode>> activeTogglesQueue;
 		deque<ButtonID> chordStack; // Represents the current active _buttons in order from most recent to latest
+		unsigned int chordStackVersion = 0; // Incremented whenever chordStack changes
 		unique_ptr<Gamepad> _vigemController;
+		ControllerScheme virtualScheme = ControllerScheme::NONE; // Of _vigemController once the published changes are applied. Only for the threads that change it.
 		function<DigitalButton *(ButtonID)> _getMatchingSimBtn; // A functor to JoyShock::getMatchingSimBtn
 		function<DigitalButton *(ButtonID, optional<MapIterator>&)> _getMatchingDiagBtn; // A functor to JoyShock::getMatchingDiagBtn
 		function<void(int small, int big)> _rumble;             // A functor to JoyShock::sendRumble
-		mutex callback_lock;                                    // Needs to be in the common struct for both joycons to use the same
+		mutex callback_lock;                                    // Held by the input threads for a tick. Needs to be in the common struct for both joycons to use the same
+		PendingChanges pendingChanges;                          // How other threads change the context, applied at the start of a tick
 		shared_ptr<MotionIf> rightMainMotion = nullptr;
 		shared_ptr<MotionIf> leftMotion = nullptr;
 		int nn = 0;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+// The camera rotation of one flick over time. It eases out towards the flick angle over FLICK_TIME, which
+// FLICK_TIME_EXPONENT stretches or shrinks with the size of the flick. Read at any time, so the rotation of
+// a flick doesn't depend on when it is sampled: the sum of the steps between any samples is the same.
+class FlickCurve
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// A curve that is already done, with no rotation
+	FlickCurve() = default;
+
+	// angle in radians, flickTime in seconds
+	FlickCurve(Clock::time_point start, float angle, float flickTime, float timeExponent);
+
+	// Share of the time of the flick that has passed, from 0 to 1
+	float percentDone(Clock::time_point now) const;
+
+	// Rotation covered at that time, from 0 to the angle
+	float rotation(Clock::time_point now) const;
+
+	Clock::time_point end() const
+	{
+		return _end;
+	}
+
+	float angle() const
+	{
+		return _angle;
+	}
+
+private:
+	Clock::time_point _start;
+	Clock::time_point _end;
+	float _angle = 0.f;
+};
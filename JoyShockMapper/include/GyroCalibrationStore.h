@@ -0,0 +1,49 @@
+#pragma once
+
+#include <compare>
+#include <map>
+#include <optional>
+#include <string>
+
+// Gyro calibration offsets of the controllers, kept between sessions so that a controller calibrated before has
+// usable gyro as soon as it's connected. The file has one line per controller:
+//   <vendor id> <product id> <serial, or - without one> <x offset> <y offset> <z offset>
+class GyroCalibrationStore
+{
+public:
+	struct Key
+	{
+		int vendorId = 0;
+		int productId = 0;
+		std::string serial; // Controllers of the same model without a serial share their offsets
+
+		auto operator<=>(const Key &) const = default;
+	};
+
+	struct Offset
+	{
+		float x = 0.f;
+		float y = 0.f;
+		float z = 0.f;
+	};
+
+	explicit GyroCalibrationStore(std::string path);
+
+	// Replace the offsets with the ones in the file. A missing file is empty, and lines that can't be read are
+	// skipped. Returns false if the file exists but can't be opened.
+	bool load();
+	// Write the file in one go, so that it's never left half written
+	bool save() const;
+
+	std::optional<Offset> find(const Key &key) const;
+	void set(const Key &key, const Offset &offset);
+
+	const std::string &path() const
+	{
+		return _path;
+	}
+
+private:
+	std::string _path;
+	std::map<Key, Offset> _offsets;
+};
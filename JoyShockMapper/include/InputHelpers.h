@@ -2,6 +2,7 @@
 
 #include "JoyShockMapper.h"
 #include "PlatformDefinitions.h"
+#include "MouseScheduler.h"
 
 #include <functional>
 #include <string>
@@ -43,16 +44,88 @@ int pressMouse(KeyCode vkKey, bool isPressed);
 // send key press
 int pressKey(KeyCode vkKey, bool pressed);
 
-void moveMouse(float x, float y);
+// Movement too small to make a whole mouse count yet, carried over to the next move. Each controller keeps its own.
+struct MouseRemainder
+{
+	float x = 0.f;
+	float y = 0.f;
+	// Scrolling, in steps of high resolution wheels
+	float wheelX = 0.f;
+	float wheelY = 0.f;
+};
+
+// High resolution wheels report 120 steps per notch, on Windows and Linux alike
+constexpr int WHEEL_HI_RES_PER_NOTCH = 120;
+
+// Output is scaled by MOUSE_DPI_MULTIPLIER
+void moveMouse(float x, float y, MouseRemainder &remainder);
+
+// Sends whole mouse counts to the OS right away. Each platform has its own; moveMouse and the output thread of
+// MOUSE_OUTPUT_RATE end up here.
+void sendMouseMove(int x, int y);
+
+// Scrolls by fractions of a wheel notch, up and right being positive. It isn't scaled by MOUSE_DPI_MULTIPLIER.
+void scrollMouse(float notchesX, float notchesY, MouseRemainder &remainder);
+
+// Sends high resolution wheel steps to the OS right away. Each platform has its own.
+void sendMouseScroll(int hiResX, int hiResY);
+
+// Sends per second of a thread that spreads each tick's mouse movement until the next tick. 0 sends on the tick.
+void setMouseOutputRate(float hz);
+
+// Plays a path of mouse movement, before MOUSE_DPI_MULTIPLIER, on the thread of MOUSE_OUTPUT_RATE.
+// Returns false when that thread isn't running: the caller then samples the path on its own ticks.
+bool playMousePath(const void *source, MouseScheduler::Path path, MouseScheduler::Clock::time_point until);
 
 void setMouseNorm(float x, float y);
 
+class Gamepad;
+
+// Takes the keyboard, mouse and virtual controller output in place of the OS, to render a replay offline
+class OutputSink
+{
+public:
+	virtual ~OutputSink() = default;
+
+	// Keys and mouse buttons, by KeyCode::code
+	virtual void key(uint16_t code, bool pressed) = 0;
+	// In mouse counts, after MOUSE_DPI_MULTIPLIER
+	virtual void mouseMove(int x, int y) = 0;
+	// In high resolution wheel steps, from scrollMouse
+	virtual void mouseScroll(int hiResX, int hiResY) = 0;
+	virtual void mouseAbsolute(float x, float y) = 0;
+	// Stands in for Gamepad::getNew
+	virtual Gamepad *newGamepad(ControllerScheme scheme) = 0;
+};
+
+// nullptr sends the output to the OS again
+void setOutputSink(OutputSink *sink);
+OutputSink *getOutputSink();
+
+// Output sent by the calling thread between these two calls is delivered together when the outermost frame ends.
+// Only Linux batches; elsewhere each call is still sent right away.
+void beginOutputFrame();
+void endOutputFrame();
+
+struct OutputFrame
+{
+	OutputFrame()
+	{
+		beginOutputFrame();
+	}
+
+	~OutputFrame()
+	{
+		endOutputFrame();
+	}
+};
+
 // delta time will apply to shaped movement, but the extra (velocity parameters after deltaTime) is
 // applied as given
-inline void shapedSensitivityMoveMouse(float x, float y, float deltaTime, float extraVelocityX, float extraVelocityY)
+inline void shapedSensitivityMoveMouse(float x, float y, float deltaTime, float extraVelocityX, float extraVelocityY, MouseRemainder &remainder)
 {
 	// apply all values
-	moveMouse(x * deltaTime + extraVelocityX, y * deltaTime + extraVelocityY);
+	moveMouse(x * deltaTime + extraVelocityX, y * deltaTime + extraVelocityY, remainder);
 }
 
 BOOL WriteToConsole(string_view command);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "JslWrapper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Recording of what the controllers sent, one record per device per tick, and a JslWrapper that plays it back.
+namespace InputRecording
+{
+
+struct DeviceInfo
+{
+	int handle = 0;
+	int controllerType = 0;
+	int splitType = 0;
+	int vendorId = 0;
+	int productId = 0;
+};
+
+// File format, all fields little endian: a header followed by records until the end of the file.
+// Each record is a Frame followed by frame.imuReportCount Reports.
+namespace File
+{
+
+constexpr uint32_t kMagic = 0x524D534A; // "JSMR"
+constexpr uint16_t kVersion = 1;
+
+#pragma pack(push, 1)
+struct Header
+{
+	uint32_t magic = kMagic;
+	uint16_t version = kVersion;
+	uint16_t frameSize = 0;  // sizeof(Frame), so that older readers can skip fields they don't know
+	uint16_t reportSize = 0; // sizeof(Report)
+	uint16_t reserved = 0;
+};
+
+struct Frame
+{
+	uint64_t tickNs;          // since the start of the recording
+	uint64_t sensorTimestamp; // DeviceFrame::timestamp
+	float deltaTime;          // as measured by the poll callback, in seconds
+	int32_t handle;
+	uint8_t controllerType;
+	uint8_t splitType;
+	uint16_t vendorId;
+	uint16_t productId;
+	int32_t buttons;
+	float leftX;
+	float leftY;
+	float rightX;
+	float rightY;
+	float leftTrigger;
+	float rightTrigger;
+	float accel[3];
+	float gyro[3];
+	uint8_t touchDown; // bit 0 for the first touch, bit 1 for the second
+	float touch[4];    // x and y of both touches
+	int16_t imuReportCount; // -1 when the backend only exposed the latest IMU state
+};
+
+struct Report
+{
+	float accel[3];
+	float gyro[3];
+	float deltaTime;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Header) == 12);
+static_assert(sizeof(Frame) == 101);
+static_assert(sizeof(Report) == 28);
+
+} // namespace File
+
+// Returns false with a reason in error if the file can't be created. Stops any recording in progress.
+bool Start(const std::string &path, std::string &error);
+// Returns the number of records written
+size_t Stop();
+bool IsRecording();
+
+// Called by the poll callback. Thread safe, and only costs an atomic load when not recording.
+void Record(const DeviceInfo &device, const DeviceFrame &frame, float deltaTime, const TimedImuState *reports, int numReports);
+
+class Replay : public JslWrapper
+{
+public:
+	// Seconds into the recording of the tick being played
+	virtual double position() const = 0;
+	// Every tick has been played
+	virtual bool finished() const = 0;
+};
+
+// Plays a recording back as if the recorded devices were connected. With realTime the ticks keep their recorded
+// spacing, otherwise they run back to back. Returns nullptr with a reason in error if the file isn't a valid recording.
+Replay *OpenReplay(const std::string &path, bool realTime, std::string &error);
+
+} // namespace InputRecording
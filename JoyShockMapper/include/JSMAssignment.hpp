@@ -4,9 +4,9 @@
 #include "CmdRegistry.h" // for JSMCommand
 #include "JSMVariable.hpp"
 #include "PlatformDefinitions.h"
+#include "ConfigParser.h"
 
 #include <iostream>
-#include <regex>
 
 // This class handles any kind of assignment command by binding to a JSM variable
 // of the parameterized type T. If T is not a base type, implement the following
@@ -27,9 +27,8 @@ protected:
 
 	virtual bool parseData(string_view arguments, string_view label) override
 	{
-		smatch results;
 		_ASSERT_EXPR(_parse, L"There is no function defined to parse this command.");
-		const string argStr(arguments);
+		string_view value;
 		if (arguments.empty())
 		{
 			displayCurrentValue();
@@ -39,23 +38,16 @@ protected:
 			// Show help.
 			COUT << _help << '\n';
 		}
-		else if (regex_match(argStr, results, regex(R"(\s*=\s*(.*))")))
+		else if (ConfigParser::Active::parseAssignment(arguments, value))
 		{
-			string assignment(results.empty() ? arguments : results[1].str());
+			string assignment(value);
 			if (assignment.rfind("DEFAULT", 0) == 0)
 			{
 				_var.reset();
 			}
 			else if (!_parse(this, assignment, label))
 			{
-				CERR << "Error assigning ";
-				COUT_INFO << assignment;
-				CERR << " to " << _displayName << '\n';
-				CERR << "See ";
-				COUT_INFO << "HELP";
-				CERR << " and ";
-				COUT_INFO << "README";
-				CERR << " commands for further details.\n";
+				displayAssignmentError(assignment);
 			}
 		}
 		else if (!_help.empty())
@@ -91,24 +83,76 @@ protected:
 		T value(inst->readValue(ss));
 		if (!ss.fail())
 		{
-			T oldVal = inst->_var;
-			inst->_var.set(value);
-			inst->_var.updateLabel(label);
+			return inst->assign(value, label);
+		}
+		// Couldn't read the value
+		return false;
+	}
+
+	bool assign(const T& value, string_view label)
+	{
+		T oldVal = _var;
+		_var.set(value);
+		_var.updateLabel(label);
+
+		// The assignment won't trigger my listener displayNewValue if
+		// the new value after filtering is the same as the old.
+		if (oldVal == _var.value())
+		{
+			// So I want to do it myself.
+			displayNewValue(_var);
+		}
+
+		// Command succeeded if the value requested was the current one
+		// or if the new value is different from the old.
+		return value == oldVal || _var.value() != oldVal; // Command processed successfully
+	}
 
-			// The assignment won't trigger my listener displayNewValue if
-			// the new value after filtering is the same as the old.
-			if (oldVal == inst->_var.value())
+	// Values are read ahead of time only with the default parser, since custom parsers do more than reading.
+	virtual CompiledData compileData(string_view arguments, string_view label) override
+	{
+		auto parser = _parse.template target<bool (*)(JSMCommand*, string_view, string_view)>();
+		string_view assignment;
+		if (!parser || *parser != &JSMAssignment::defaultParser || !ConfigParser::Active::parseAssignment(arguments, assignment) || assignment.rfind("DEFAULT", 0) == 0)
+		{
+			return nullptr;
+		}
+		stringstream ss{ string(assignment) };
+		T value(readValue(ss));
+		if (ss.fail())
+		{
+			return nullptr;
+		}
+		// A refused value has still been applied, so it's reported here rather than by parsing the arguments again
+		return [value, label = string(label), assignment = string(assignment)](JSMCommand& cmd)
+		{
+			auto inst = dynamic_cast<JSMAssignment<T>*>(&cmd);
+			if (!inst)
+			{
+				return false;
+			}
+			if (!inst->assign(value, label))
+			{
+				inst->displayAssignmentError(assignment);
+			}
+			if constexpr (is_same_v<T, Mapping>)
 			{
-				// So I want to do it myself.
-				inst->displayNewValue(inst->_var);
+				value.flagGyroOnAll();
 			}
+			return true;
+		};
+	}
 
-			// Command succeeded if the value requested was the current one
-			// or if the new value is different from the old.
-			return value == oldVal || inst->_var.value() != oldVal; // Command processed successfully
-		}
-		// Couldn't read the value
-		return false;
+	void displayAssignmentError(string_view assignment)
+	{
+		CERR << "Error assigning ";
+		COUT_INFO << assignment;
+		CERR << " to " << _displayName << '\n';
+		CERR << "See ";
+		COUT_INFO << "HELP";
+		CERR << " and ";
+		COUT_INFO << "README";
+		CERR << " commands for further details.\n";
 	}
 
 	virtual void displayNewValue(const T& newValue)
@@ -132,7 +176,7 @@ protected:
 
 	virtual unique_ptr<JSMCommand> getModifiedCmd(char op, string_view chord) override
 	{
-		stringstream ss(chord.data());
+		stringstream ss{ string(chord) };
 		ButtonID btn;
 		ss >> btn;
 		if (btn > ButtonID::NONE)
@@ -203,8 +247,7 @@ public:
 	{
 		// Child Classes assign their own parser. Use bind to convert instance function call
 		// into a static function call.
-		using namespace placeholders;
-		setParser(bind(&JSMAssignment::defaultParser, _1, _2, _3));
+		setParser(&JSMAssignment::defaultParser);
 		if (!inNoListener)
 		{
 			_listenerId = _var.addOnChangeListener(bind(&JSMAssignment::displayNewValue, this, placeholders::_1));
@@ -2,7 +2,10 @@
 
 #include "JoyShockMapper.h"
 #include "Mapping.h"
+#include "SettingsTransaction.h"
+#include "ChordTable.h"
 #include <sstream>
+#include <atomic>
 
 // Global ID generator
 static unsigned int _delegateID = 1;
@@ -10,7 +13,10 @@ static unsigned int _delegateID = 1;
 class JSMVariableBase
 {
 public:
-	virtual ~JSMVariableBase() = default;
+	virtual ~JSMVariableBase()
+	{
+		SettingsTransaction::forget(this);
+	}
 
 	string_view label() const
 	{
@@ -24,9 +30,39 @@ public:
 
 	virtual JSMVariableBase *reset() = 0;
 
+	// Incremented whenever any variable changes value or gains or loses a chord. Hot paths
+	// can cache resolved values and only refresh them when this changes.
+	static unsigned int generation()
+	{
+		return _generation.load(memory_order_relaxed);
+	}
+
+	// The generation this variable last changed value in, and the one it was last set in, even to the same value.
+	// A commit listener that sets another variable leaves it alone if it was set since the change it follows.
+	unsigned int changedAt() const
+	{
+		return _changedAt;
+	}
+
+	unsigned int setAt() const
+	{
+		return _setAt;
+	}
+
+protected:
+	static void bumpGeneration()
+	{
+		_generation.fetch_add(1, memory_order_relaxed);
+	}
+
+	unsigned int _changedAt = 0;
+	unsigned int _setAt = 0;
+
 private:
 	// a user provided label
 	string _label;
+
+	static inline atomic<unsigned int> _generation = 0;
 };
 
 // JSMVariable is a wrapper class for an underlying variable of type T.
@@ -52,6 +88,9 @@ protected:
 	// Parts of the code can be notified of when _value changes.
 	map<unsigned int, OnChangeDelegate> _onChangeListeners;
 
+	// Parts of the code that only need the value a SettingsTransaction ends with.
+	map<unsigned int, OnChangeDelegate> _onCommitListeners;
+
 	// The filtering function of the variable.
 	FilterDelegate _filter;
 
@@ -68,6 +107,7 @@ public:
 	JSMVariable(T defaultValue = T())
 	  : _value(defaultValue)
 	  , _onChangeListeners()
+	  , _onCommitListeners()
 	  , _filter(&noFiltering) // _filter is always valid
 	  , _defVal(defaultValue)
 	{
@@ -77,6 +117,7 @@ public:
 	JSMVariable(const JSMVariable &copy, T defaultValue)
 	  : _value(defaultValue)
 	  , _onChangeListeners() // Don't copy listeners. This is a different variable!
+	  , _onCommitListeners()
 	  , _filter(copy._filter)
 	  , _defVal(defaultValue)
 	{
@@ -85,6 +126,7 @@ public:
 	virtual ~JSMVariable()
 	{
 		_onChangeListeners.clear();
+		_onCommitListeners.clear();
 	}
 
 	// Sets the filtering function for this variable. Also applies
@@ -107,16 +149,23 @@ public:
 		return _delegateID++;
 	}
 
-	// Remove the listener from list
-	virtual bool removeOnChangeListener(unsigned int id)
+	// Remember to call this listener when the value changes, or once with the final value if it changes during a
+	// transaction. Listeners that later commands rely on can't wait for that, and ones that set other variables should
+	// check changedAt() against their setAt().
+	virtual unsigned int addOnCommitListener(OnChangeDelegate listener, bool callListener = false)
 	{
-		auto found = _onChangeListeners.find(id);
-		if (found != _onChangeListeners.end())
+		_onCommitListeners[_delegateID] = listener;
+		if (callListener)
 		{
-			_onChangeListeners.erase(found);
-			return true;
+			_onCommitListeners[_delegateID](_value);
 		}
-		return false;
+		return _delegateID++;
+	}
+
+	// Remove the listener from list
+	virtual bool removeOnChangeListener(unsigned int id)
+	{
+		return _onChangeListeners.erase(id) > 0 || _onCommitListeners.erase(id) > 0;
 	}
 
 	// reset the variable by assigning it its default value.
@@ -153,10 +202,24 @@ public:
 		_value = _filter(oldValue, newValue); // Pass new value through filtering
 		if (_value != oldValue)
 		{
+			JSMVariableBase::bumpGeneration();
+			this->_changedAt = JSMVariableBase::generation();
 			// Notify listeners of the change if there's a change
 			for (auto listener : _onChangeListeners)
 				listener.second(_value);
+			if (!_onCommitListeners.empty())
+			{
+				SettingsTransaction::notify(this, [this, oldValue]()
+				  {
+					  if (_value != oldValue)
+					  {
+						  for (auto listener : _onCommitListeners)
+							  listener.second(_value);
+					  }
+				  });
+			}
 		}
+		this->_setAt = JSMVariableBase::generation();
 		return _value; // Return actual value assign. Can be different from newValue because of filtering.
 	}
 };
@@ -169,7 +232,7 @@ class ChordedVariable : public JSMVariable<T>
 
 protected:
 	// Each chord is a separate variable with its own listeners, but will use the same filtering and parsing.
-	map<ButtonID, JSMVariable<T>> _chordedVariables;
+	ChordTable<ButtonID, JSMVariable<T>, magic_enum::enum_count<ButtonID>()> _chordedVariables;
 
 public:
 	ChordedVariable(T defval)
@@ -182,18 +245,18 @@ public:
 	JSMVariable<T> *atChord(ButtonID chord)
 	{
 		auto existingChord = _chordedVariables.find(chord);
-		if (existingChord == _chordedVariables.end())
+		if (!existingChord)
 		{
 			// Create the chord when requested, using the copy constructor.
-			_chordedVariables.emplace(chord, JSMVariable<T>(*this, Base::_defVal));
+			existingChord = &_chordedVariables.emplace(chord, *this, Base::_defVal);
+			JSMVariableBase::bumpGeneration();
 		}
-		return &_chordedVariables[chord];
+		return existingChord;
 	}
 
 	const JSMVariable<T> *atChord(ButtonID chord) const
 	{
-		auto existingChord = _chordedVariables.find(chord);
-		return existingChord != _chordedVariables.end() ? &existingChord->second : nullptr;
+		return _chordedVariables.find(chord);
 	}
 
 	// Obtain the value with provided chord if any.
@@ -202,7 +265,7 @@ public:
 		if (chord > ButtonID::NONE)
 		{
 			auto existingChord = _chordedVariables.find(chord);
-			return existingChord != _chordedVariables.end() ? optional<T>(T(existingChord->second)) : nullopt;
+			return existingChord ? optional<T>(T(*existingChord)) : nullopt;
 		}
 		return chord != ButtonID::INVALID ? optional(Base::_value) : nullopt;
 	}
@@ -221,6 +284,7 @@ public:
 	{
 		JSMVariable<T>::reset();
 		_chordedVariables.clear();
+		JSMVariableBase::bumpGeneration();
 		return this;
 	}
 };
@@ -259,11 +323,10 @@ public:
 	{
 		if (_chordToRemove == modeshift)
 		{
-			auto modeshiftVar = Base::_chordedVariables.find(modeshift);
-			if (modeshiftVar != Base::_chordedVariables.end())
+			if (Base::_chordedVariables.erase(modeshift))
 			{
-				Base::_chordedVariables.erase(modeshiftVar);
 				_chordToRemove = ButtonID::NONE;
+				JSMVariableBase::bumpGeneration();
 			}
 		}
 	}
@@ -351,8 +414,7 @@ public:
 	// Double Press mappings are stored in the chorded variables
 	const ComboMap *getDblPressMap() const
 	{
-		auto existingChord = _chordedVariables.find(_id);
-		return existingChord != _chordedVariables.end() ? &*existingChord : nullptr;
+		return _chordedVariables.entry(_id);
 	}
 
 	// Indicate whether any sim press mappings are present
@@ -479,11 +541,7 @@ public:
 	{
 		if (value && value->value() == Mapping::NO_MAPPING)
 		{
-			auto chordVar = _chordedVariables.find(chord);
-			if (chordVar != _chordedVariables.end())
-			{
-				_chordedVariables.erase(chordVar);
-			}
+			_chordedVariables.erase(chord);
 		}
 	}
 
@@ -6,7 +6,11 @@
 #include "Stick.h"
 #include "JslWrapper.h"
 #include "SettingsManager.h"
+#include "InputHelpers.h"
+#include "Smoothing.h"
+#include "CurveEngine.h"
 #include "../src/quatMaths.cpp"
+#include <bitset>
 
 // An instance of this class represents a single controller device that JSM is listening to.
 class JoyShock
@@ -45,7 +49,8 @@ public:
 	template<>
 	AxisSignPair getSetting<AxisSignPair>(SettingID index);
 
-	void getSmoothedGyro(float x, float y, float length, float bottomThreshold, float topThreshold, int maxSamples, float &outX, float &outY);
+	// smoothTime and deltaTime are in seconds. beta only applies to the ONE_EURO kernel.
+	void getSmoothedGyro(float x, float y, float length, float bottomThreshold, float topThreshold, GyroSmoothKernel kernel, float smoothTime, float beta, float deltaTime, float &outX, float &outY);
 
 	void handleButtonChange(ButtonID id, bool pressed, int touchpadID = -1);
 
@@ -56,7 +61,8 @@ public:
 	// return true if it hits the outer deadzone
 	bool processDeadZones(float &x, float &y, float innerDeadzone, float outerDeadzone);
 
-	void updateGridSize();
+	// Keeps a button for each of the first count grid_mappings
+	void updateGridSize(size_t count);
 
 	bool processGyroStick(float stickX, float stickY, float stickLength, StickMode stickMode, bool forceOutput);
 
@@ -64,7 +70,8 @@ public:
 	vector<DigitalButton> _buttons;
 	vector<DigitalButton> _gridButtons;
 	vector<TouchStick> _touchpads;
-	chrono::steady_clock::time_point _timeNow;
+	chrono::steady_clock::time_point _timeNow = chrono::steady_clock::now();
+	bool _timedMotion = false; // The backend gave timed motion reports for this device
 	shared_ptr<MotionIf> _motion;
 	int _handle;
 	int _controllerType;
@@ -72,6 +79,9 @@ public:
 	int _vendorId = 0;
 	int _productId = 0;
 	bool _ignoreGyro = false;
+	bool _micLight = false; // Mic toggle state last pushed to the controllers
+	MouseRemainder _mouseRemainder;
+	CurveEngine _accelCurve;
 
 
 	float neutralQuatW = 1.0f;
@@ -122,17 +132,38 @@ private:
 
 	float getSmoothedStickRotation(float value, float bottomThreshold, float topThreshold, int maxSamples);
 
+	// Drop the resolved settings if the chord stack or any setting changed since they were filled
+	void validateResolvedSettings();
+
 	static constexpr int MAX_GYRO_SAMPLES = 256;
 	static constexpr int NUM_SAMPLES = 256;
 
-	array<float, NUM_SAMPLES> _flickSamples;
-	int _frontSample = 0;
+	RunningWindow<NUM_SAMPLES> _flickSamples;
 
-	array<FloatXY, MAX_GYRO_SAMPLES> _gyroSamples;
-	int _frontGyroSample = 0;
+	GyroSmoothKernel _gyroKernel = GyroSmoothKernel::WINDOW;
+	RunningWindow<MAX_GYRO_SAMPLES> _gyroSamplesX;
+	RunningWindow<MAX_GYRO_SAMPLES> _gyroSamplesY;
+	ExponentialFilter _gyroExponentialX;
+	ExponentialFilter _gyroExponentialY;
+	OneEuroFilter _gyroOneEuroX;
+	OneEuroFilter _gyroOneEuroY;
 
 	Vec _lastGrav = Vec(0.f, -1.f, 0.f);
 
+	// Settings resolved against the current chord stack, indexed by SettingID. Entries are filled
+	// on first read so the poll loop doesn't walk the chord stack and settings map every tick.
+	struct alignas(64) ResolvedSettings
+	{
+		unsigned int settingsGeneration = 0;
+		unsigned int chordStackVersion = 0;
+		bitset<SETTINGS_COUNT> hasFloat;
+		bitset<SETTINGS_COUNT> hasEnum;
+		bitset<SETTINGS_COUNT> hasFloatXY;
+		array<float, SETTINGS_COUNT> floats;
+		array<int, SETTINGS_COUNT> enums;
+		array<FloatXY, SETTINGS_COUNT> floatXYs;
+	} _resolved;
+
 	float _windingAngleLeft = 0.f;
 	float _windingAngleRight = 0.f;
 
@@ -159,6 +190,14 @@ template<typename E>
 E JoyShock::getSetting(SettingID index)
 {
 	static_assert(is_enum<E>::value, "Parameter of JoyShock::getSetting<E> has to be an enum type");
+	// Stick modes depend on the flick state of the stick and can't be cached
+	constexpr bool cacheable = !is_same_v<E, StickMode>;
+	if constexpr (cacheable)
+	{
+		validateResolvedSettings();
+		if (size_t(index) < SETTINGS_COUNT && _resolved.hasEnum[size_t(index)])
+			return static_cast<E>(_resolved.enums[size_t(index)]);
+	}
 	// Look at active chord mappings starting with the latest activates chord
 	for (auto activeChord = _context->chordStack.begin(); activeChord != _context->chordStack.end(); activeChord++)
 	{
@@ -214,7 +253,17 @@ E JoyShock::getSetting(SettingID index)
 			}
 		}
 		if (opt)
+		{
+			if constexpr (cacheable)
+			{
+				if (size_t(index) < SETTINGS_COUNT)
+				{
+					_resolved.enums[size_t(index)] = int(*opt);
+					_resolved.hasEnum.set(size_t(index));
+				}
+			}
 			return *opt;
+		}
 	}
 	stringstream ss;
 	ss << "Index " << index << " is not a valid enum setting";
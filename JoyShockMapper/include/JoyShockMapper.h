@@ -250,6 +250,17 @@ enum class SettingID
 	RETURN_DEADZONE_ANGLE_CUTOFF,
 	TELEMETRY_ENABLED,
 	TELEMETRY_PORT,
+	TELEMETRY_FORMAT,
+	SENSOR_EVENTS,
+	PER_DEVICE_POLLING,
+	REALTIME_POLLING,
+	GYRO_SMOOTH_KERNEL,
+	GYRO_SMOOTH_BETA,
+	MOUSE_DPI_MULTIPLIER,
+	ACCEL_CURVE_TABLE,
+	RUMBLE_KEEP_ALIVE,
+	MOUSE_OUTPUT_RATE,
+	HI_RES_SCROLL,
 };
 
 // constexpr are like #define but with respect to typeness
@@ -259,6 +270,7 @@ constexpr int FIRST_ANALOG_TRIGGER = int(ButtonID::ZLF);
 constexpr int LAST_ANALOG_TRIGGER = int(ButtonID::ZRF);
 constexpr int FIRST_TOUCH_BUTTON = MAPPING_SIZE + 1;
 constexpr int NUM_ANALOG_TRIGGERS = int(LAST_ANALOG_TRIGGER) - int(FIRST_ANALOG_TRIGGER) + 1;
+constexpr size_t SETTINGS_COUNT = magic_enum::enum_count<SettingID>() - 1; // Excludes INVALID
 constexpr float MAGIC_TAP_DURATION = 40.0f;           // in milliseconds.
 constexpr float MAGIC_INSTANT_DURATION = 40.0f;       // in milliseconds
 constexpr float MAGIC_EXTENDED_TAP_DURATION = 500.0f; // in milliseconds
@@ -424,6 +436,21 @@ enum class ControllerScheme
 	INVALID
 };
 
+enum class GyroSmoothKernel
+{
+	WINDOW,
+	EXPONENTIAL,
+	ONE_EURO,
+	INVALID
+};
+
+enum class TelemetryFormat
+{
+	BINARY,
+	JSON,
+	INVALID
+};
+
 enum class TouchpadMode
 {
 	GRID_AND_STICK, // Grid and Stick
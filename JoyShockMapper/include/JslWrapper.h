@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <iostream>
+#include <string>
 
 enum class AdaptiveTriggerMode : unsigned char
 {
@@ -174,6 +175,35 @@ typedef struct TOUCH_STATE
 
 #endif
 
+// An IMU report along with the time elapsed since the previous report of the same device
+struct TimedImuState
+{
+	IMU_STATE imu;
+	float deltaTime; // in seconds
+};
+
+// Motion reports of a device that never arrived, or arrived more than once, as told by their timestamps
+struct ImuReportStats
+{
+	uint64_t dropped = 0;
+	uint64_t duplicated = 0;
+};
+
+// Everything the callbacks read from a device in one tick, read together so that the values are consistent
+struct DeviceFrame
+{
+	int buttons;
+	float leftX;
+	float leftY;
+	float rightX;
+	float rightY;
+	float leftTrigger;
+	float rightTrigger;
+	IMU_STATE imu;
+	TOUCH_STATE touch;
+	uint64_t timestamp; // in nanoseconds, of the latest sensor report when the backend has one
+};
+
 class JslWrapper
 {
 protected:
@@ -191,8 +221,34 @@ public:
 	virtual int GetDeviceCount() = 0;
 	virtual int GetConnectedDeviceHandles(int* deviceHandleArray, int size) = 0;
 	virtual void DisconnectAndDisposeAll() = 0;
+	// Backends that know when the reports were made, like replays or the evdev backend, give the callbacks the
+	// time step to use rather than the time between callbacks
+	virtual bool ProvidesTimeStep()
+	{
+		return false;
+	}
+	// False for the backends that make the input up or play it back, which have no real controllers to hotplug
+	// or calibrate
+	virtual bool IsLive()
+	{
+		return true;
+	}
 	virtual JOY_SHOCK_STATE GetSimpleState(int deviceId) = 0;
 	virtual IMU_STATE GetIMUState(int deviceId) = 0;
+	// Copy the IMU reports received since the last call, oldest first, and return how many were written.
+	// Returns -1 when the backend only exposes the latest report, which is then read with GetIMUState.
+	virtual int GetIMUReports(int deviceId, TimedImuState *reports, int maxReports)
+	{
+		return -1;
+	}
+	// Only the backends that return the IMU reports count them
+	virtual ImuReportStats GetIMUReportStats(int deviceId)
+	{
+		return ImuReportStats();
+	}
+	// Read the whole input state of the device at once. Backends that run the callbacks themselves return the
+	// frame taken for the current tick. Returns false if the device is unknown.
+	virtual bool GetDeviceFrame(int deviceId, DeviceFrame &frame) = 0;
 	virtual MOTION_STATE GetMotionState(int deviceId) = 0;
 	virtual TOUCH_STATE GetTouchState(int deviceId, bool previous = false) = 0;
 	virtual bool GetTouchpadDimension(int deviceId, int& sizeX, int& sizeY) = 0;
@@ -227,6 +283,11 @@ public:
 	virtual int GetControllerSplitType(int deviceId) = 0;
 	virtual int GetControllerVendor(int deviceId) = 0;
 	virtual int GetControllerProduct(int deviceId) = 0;
+	// Empty when the backend or the device doesn't have one
+	virtual std::string GetControllerSerial(int deviceId)
+	{
+		return std::string();
+	}
 	virtual int GetControllerColour(int deviceId) = 0;
 	virtual void SetLightColour(int deviceId, int colour) = 0;
 	virtual void SetRumble(int deviceId, int smallRumble, int bigRumble) = 0;
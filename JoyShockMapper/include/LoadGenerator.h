@@ -0,0 +1,61 @@
+#pragma once
+
+#include "JslWrapper.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A JslWrapper that makes up any number of controllers, to measure how many devices JSM can drive:
+//   JoyShockMapper --synthetic <count> [TYPE=MIXED] [RATE=1000] [NOISE=0.5] [STICKS=CIRCLE] [BUTTONS=0] [SEED=1]
+// All devices are polled by one thread, like the SDL backend, and a pass over the devices that takes longer than
+// a report period is an overrun.
+namespace LoadGenerator
+{
+
+constexpr std::string_view USAGE = "Usage: JoyShockMapper --synthetic <count> [TYPE=DS4|DS|JOYCON|MIXED] [RATE=<reports per second>] "
+                                   "[NOISE=<gyro noise in degrees per second>] [STICKS=NONE|CIRCLE|SWEEP|RANDOM] "
+                                   "[BUTTONS=<button changes per second per device>] [SEED=<number>]\n";
+
+enum class StickPattern
+{
+	NONE,
+	CIRCLE, // Left stick clockwise at 1 Hz, right stick counter clockwise at 0.5 Hz
+	SWEEP,  // Both sticks and triggers go end to end at 1 Hz
+	RANDOM, // Random walk
+};
+
+struct Config
+{
+	int devices = 0;
+	int controllerType = 0; // JS_TYPE_DS4, JS_TYPE_DS or JS_TYPE_JOYCON_LEFT for Joy-Con pairs. 0 cycles through the three.
+	float rate = 1000.f;    // Reports per second of every device
+	float gyroNoise = 0.5f; // Standard deviation in degrees per second, added on top of a slow sweep
+	StickPattern sticks = StickPattern::CIRCLE;
+	float buttonRate = 0.f; // Button presses and releases per second per device
+	uint32_t seed = 1;      // The same seed makes the same input
+};
+
+// Every second of polling
+struct Stats
+{
+	uint64_t ticks = 0;      // Passes over all the devices
+	uint64_t overruns = 0;   // Passes that finished after the next one was due. The late reports are skipped.
+	double meanTickMs = 0.0; // Time spent in the callbacks per pass
+	double worstTickMs = 0.0;
+};
+
+// nullopt when the arguments don't ask for synthetic devices, and a config without devices when they do but are invalid
+std::optional<Config> ParseArguments(const std::vector<std::string> &arguments);
+
+// Polling starts with SetCallback. report is called from the polling thread once per second.
+JslWrapper *New(const Config &config, std::function<void(const Stats &)> report = nullptr);
+
+// Moves the devices of a generator made by New to tick, as polling does, without calling back. For tests, while
+// the generator isn't polling. The input at a tick is the same whichever ticks were skipped on the way.
+void Generate(JslWrapper *generator, uint64_t tick);
+
+} // namespace LoadGenerator
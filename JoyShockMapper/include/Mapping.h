@@ -62,6 +62,8 @@ private:
 	map<BtnEvent, EventActionIf::Callback> _eventMapping;
 	float _tapDurationMs = MAGIC_TAP_DURATION;
 	bool _hasViGEmBtn = false;
+	int _wheelNotch = 0;
+	bool _hasGyroOnAll = false;
 
 	void InsertEventMapping(BtnEvent evt, EventActionIf::Callback action);
 	static void RunBothActions(EventActionIf *btn, EventActionIf::Callback action1, EventActionIf::Callback action2);
@@ -107,12 +109,25 @@ public:
 		_description.clear();
 		_tapDurationMs = MAGIC_TAP_DURATION;
 		_hasViGEmBtn = false;
+		_wheelNotch = 0;
+		_hasGyroOnAll = false;
 	}
 
 	inline bool hasViGEmBtn() const
 	{
 		return _hasViGEmBtn;
 	}
+
+	// 1 when the mapping is nothing but a press of SCROLLUP, -1 for SCROLLDOWN and 0 otherwise.
+	// Scroll wheel sticks scroll smoothly instead of pressing these.
+	inline int wheelNotch() const
+	{
+		return _wheelNotch;
+	}
+
+	// Parsing a GYRO_ON_ALL binding lets the poll callback know there is one. This lets it know again for a
+	// mapping assigned without being parsed, like by a compiled profile after RESET_MAPPINGS.
+	void flagGyroOnAll() const;
 };
 
 bool operator==(const Mapping &lhs, const Mapping &rhs);
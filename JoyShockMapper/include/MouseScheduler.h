@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Spreads the mouse movement of each poll tick evenly over the time until the next tick, and sends it from a
+// thread of its own at a fixed rate. Games that sample the mouse at their frame rate then see even steps
+// instead of one burst per tick. Each source, a controller, keeps its own sub-pixel remainder. Movement that is
+// known ahead of time, like a flick, can be played as a path instead and is read on every step.
+class MouseScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	// Whole mouse counts, called from the output thread
+	using Send = std::function<void(int x, int y)>;
+	// Movement so far, in mouse counts, at a time
+	using Path = std::function<std::pair<float, float>(Clock::time_point)>;
+
+	explicit MouseScheduler(Send send);
+	~MouseScheduler();
+
+	// Sends per second. 0 stops the thread, and what is still pending is sent right away.
+	void setRate(float hz);
+
+	bool running() const
+	{
+		return _rate.load() > 0.f;
+	}
+
+	// Movement in mouse counts of one tick of the source
+	void submit(const void *source, float x, float y, Clock::time_point now = Clock::now());
+
+	// Follows the path on every step until the given time, in place of the path the source was playing.
+	// The movement is read straight from the path, instead of being spread between ticks.
+	void play(const void *source, Path path, Clock::time_point until);
+
+	// The whole counts due at that time, from all the sources
+	std::pair<int, int> step(Clock::time_point now);
+
+private:
+	struct Source
+	{
+		float pendingX = 0.f;
+		float pendingY = 0.f;
+		float remainderX = 0.f;
+		float remainderY = 0.f;
+		Clock::time_point spreadFrom;  // Pending movement is spread from here...
+		Clock::time_point spreadUntil; // ...to here
+		Clock::time_point lastSubmit;
+		Clock::duration interval{}; // Usual time between the ticks of the source
+		int ticks = 0;              // Since it started moving
+		Path path;
+		Clock::time_point pathUntil;
+		float pathX = 0.f; // Movement of the path sent so far
+		float pathY = 0.f;
+	};
+
+	void run();
+	Clock::duration period() const;
+
+	Send _send;
+	std::mutex _lock;
+	std::map<const void *, Source> _sources;
+	std::atomic<float> _rate = 0.f;
+	std::condition_variable _wake;
+	std::thread _thread;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "InputHelpers.h"
+#include "InputRecording.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Headless rendering of a RECORD file through configs, writing out what JSM would have sent to the OS:
+//   JoyShockMapper --render <recording> <output folder> <config> [<config> ...]
+// Settings are global to the process, so each config is rendered by its own JoyShockMapper process,
+// as many at a time as there are cores.
+//
+// The same replay times the whole per tick pipeline, poll callback included, and throws the output away:
+//   JoyShockMapper --benchmark <recording> <config>
+namespace OfflineRender
+{
+
+constexpr std::string_view USAGE = "Usage: JoyShockMapper --render <recording> <output folder> <config> [<config> ...]\n"
+                                   "       JoyShockMapper --benchmark <recording> <config>\n";
+
+struct Job
+{
+	std::string recording;
+	std::string outputFolder; // Empty for a benchmark
+	std::vector<std::string> configs;
+	bool benchmark = false;
+};
+
+// nullopt when the arguments ask for neither a render nor a benchmark, and a job without configs when they do but are incomplete
+std::optional<Job> ParseArguments(const std::vector<std::string> &arguments);
+
+// Where the output of config goes: the output folder, and the config's file name with a .txt extension
+std::string OutputPath(const Job &job, const std::string &config);
+
+// Render each config of the job in a child process. Returns the number of configs that failed.
+int RunBatch(const Job &job);
+
+// Writes the output as text, one event per line, stamped with the position in the replay:
+//   <seconds> KEY <key code> <1 for pressed, 0 for released>
+//   <seconds> MOVE <x counts> <y counts>
+//   <seconds> SCROLL <x steps> <y steps>, in 1/120 of a wheel notch
+//   <seconds> ABSOLUTE <x> <y>
+//   <seconds> PAD_BUTTON <key code> <1|0>
+//   <seconds> PAD <left x> <left y> <right x> <right y> <left trigger> <right trigger>
+// Virtual controller motion and touch are left out.
+class Sink : public OutputSink
+{
+public:
+	// An empty path discards the output
+	Sink(const std::string &path, const InputRecording::Replay &replay);
+
+	bool isOpen() const
+	{
+		return _out.is_open();
+	}
+
+	void key(uint16_t code, bool pressed) override;
+	void mouseMove(int x, int y) override;
+	void mouseScroll(int hiResX, int hiResY) override;
+	void mouseAbsolute(float x, float y) override;
+	Gamepad *newGamepad(ControllerScheme scheme) override;
+
+	// For the virtual controllers
+	void write(std::string_view event, std::initializer_list<float> values);
+
+private:
+	std::mutex _lock;
+	std::ofstream _out;
+	const InputRecording::Replay &_replay;
+};
+
+// Time and heap allocations of each poll callback, which begin() and end() surround
+class Benchmark
+{
+public:
+	void begin();
+	void end();
+
+	// Number of ticks, time per tick, and allocations per tick when the build counts them, as lines of text
+	std::string report() const;
+
+private:
+	std::chrono::steady_clock::time_point _start;
+	std::optional<size_t> _allocationsAtStart;
+	std::vector<int64_t> _durationsNs;
+	size_t _allocations = 0;
+	size_t _allocatingTicks = 0;
+};
+
+} // namespace OfflineRender
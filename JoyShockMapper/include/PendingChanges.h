@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+// Changes that other threads make to a controller, applied by its input thread at the start of its next tick.
+// Publishing doesn't wait for the tick, and applying doesn't wait for the publishers: a console command or a
+// profile load never stalls input.
+class PendingChanges
+{
+public:
+	using Change = std::move_only_function<void()>;
+
+	PendingChanges() = default;
+	PendingChanges(const PendingChanges &) = delete;
+	PendingChanges &operator=(const PendingChanges &) = delete;
+	// Changes that were never applied are dropped
+	~PendingChanges();
+
+	// From any thread
+	void publish(Change change);
+
+	// From the input thread. Runs the changes in the order they were published and returns how many ran.
+	size_t apply();
+
+private:
+	struct Node
+	{
+		Change change;
+		Node *next = nullptr;
+	};
+
+	static void release(Node *node);
+
+	std::atomic<Node *> _latest = nullptr; // Linked to the ones published before it
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Profiles are compiled the first time they are loaded in a session: each line is split once and assigned values
+// are read once, and the steps that apply them are kept here, in memory only. Loading the profile again replays
+// these steps as long as its file hasn't changed, without reading or parsing the text. Each step still assigns
+// through its command, one setting at a time, and the first load of a file costs as much as it did without the
+// cache, at startup too. Only used by the thread processing commands.
+class ProfileCache
+{
+public:
+	// Identifies the content of a file. The modification time and size are checked first, and the hash of the
+	// content settles it when only the modification time differs, like after saving an unchanged file.
+	struct FileStamp
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type modified;
+		std::uintmax_t size = 0;
+		std::uint64_t hash = 0;
+	};
+
+	struct Profile
+	{
+		FileStamp file;
+		std::vector<std::function<void()>> steps;
+	};
+
+	// Stamp a file with the content that was read from it. The modification time should be taken before reading.
+	static FileStamp stamp(const std::filesystem::path &path, std::filesystem::file_time_type modified, std::string_view content);
+
+	// Whether the file still has the stamped content. A matching hash refreshes the stamped modification time.
+	static bool unchanged(FileStamp &stamp);
+
+	// 64 bit FNV-1a
+	static std::uint64_t hash(std::string_view content);
+
+	// The compiled profile of this file, or nullptr if there is none or if the file changed since. Changed
+	// profiles are dropped.
+	std::shared_ptr<const Profile> find(const std::filesystem::path &path);
+
+	void store(std::shared_ptr<Profile> profile);
+
+	void clear()
+	{
+		_profiles.clear();
+	}
+
+	size_t size() const
+	{
+		return _profiles.size();
+	}
+
+private:
+	std::map<std::filesystem::path, std::shared_ptr<Profile>> _profiles;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "JslWrapper.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Turns the timestamps of the motion reports of a device into time steps, and counts the reports that went
+// missing or came twice on the way. A report is missing when the gap before it is well over the usual interval,
+// unless the gaps stay that long, in which case the device reports at a slower rate now.
+class SensorClock
+{
+public:
+	// Returns false for a report that isn't newer than the previous one, which should be ignored.
+	// deltaTime is in seconds, and 0 for the first report.
+	bool step(uint64_t timestampNs, float &deltaTime);
+
+	void reset();
+
+	// Can be called from any thread while another one steps the clock
+	ImuReportStats stats() const
+	{
+		return { _dropped.load(std::memory_order_relaxed), _duplicated.load(std::memory_order_relaxed) };
+	}
+
+private:
+	uint64_t _lastNs = 0;
+	bool _started = false;
+	double _intervalNs = 0.0; // Usual time between reports
+	// The gaps over the usual interval in a row, and the reports counted as dropped in them
+	int _longGaps = 0;
+	double _longGapsNs = 0.0;
+	uint64_t _longGapsDropped = 0;
+	std::atomic<uint64_t> _dropped = 0;
+	std::atomic<uint64_t> _duplicated = 0;
+};
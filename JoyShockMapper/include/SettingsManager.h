@@ -2,17 +2,25 @@
 
 #include "JoyShockMapper.h"
 #include "JSMVariable.hpp"
-#include <unordered_map>
+#include <array>
 
+// The settings by SettingID. Each setting is registered with its value type, so that looking one up is an index
+// and a comparison of that type, without any dynamic_cast. Looking up a setting with another type, or as a
+// chorded JSMSetting when it's a plain JSMVariable, returns nullptr.
 class SettingsManager
 {
 public:
 	SettingsManager() = delete;
 
-	static bool add(SettingID id, JSMVariableBase *setting);
+	template<typename T>
+	static bool add(SettingID id, JSMVariable<T> *setting)
+	{
+		// The only cast happens here, once per setting
+		return add(id, { unique_ptr<JSMVariableBase>(setting), &typeTag<T>, setting, dynamic_cast<JSMSetting<T> *>(setting) });
+	}
 
-	template <typename T>
-	static constexpr bool add(JSMSetting<T> *setting)
+	template<typename T>
+	static bool add(JSMSetting<T> *setting)
 	{
 		return add(setting->_id, setting);
 	}
@@ -20,30 +28,40 @@ public:
 	template<typename T>
 	static JSMSetting<T> *get(SettingID id)
 	{
-		auto base = _settings.find(id);
-		if (base != _settings.end())
-		{
-			return dynamic_cast<JSMSetting<T> *>(base->second.get());
-		}
-		return nullptr;
+		auto entry = find(id);
+		return entry && entry->type == &typeTag<T> ? static_cast<JSMSetting<T> *>(entry->setting) : nullptr;
 	}
 
 	template<typename T>
 	static JSMVariable<T> *getV(SettingID id)
 	{
-		auto base = _settings.find(id);
-		if (base != _settings.end())
-		{
-			return dynamic_cast<JSMVariable<T> *>(base->second.get());
-		}
-		return nullptr;
+		auto entry = find(id);
+		return entry && entry->type == &typeTag<T> ? static_cast<JSMVariable<T> *>(entry->variable) : nullptr;
 	}
 
 	static void resetAllSettings();
 
 private:
-	using SettingsMap = unordered_map<SettingID, shared_ptr<JSMVariableBase>>;
-	static SettingsMap _settings;
+	// One address per value type
+	template<typename T>
+	static constexpr char typeTag = 0;
+
+	struct Entry
+	{
+		unique_ptr<JSMVariableBase> base;
+		const char *type = nullptr;
+		void *variable = nullptr; // JSMVariable<type>
+		void *setting = nullptr;  // JSMSetting<type>, if the variable is one
+	};
+
+	static bool add(SettingID id, Entry entry);
+
+	static Entry *find(SettingID id)
+	{
+		return size_t(id) < SETTINGS_COUNT && _settings[size_t(id)].base ? &_settings[size_t(id)] : nullptr;
+	}
+
+	static array<Entry, SETTINGS_COUNT> _settings;
 };
 
-extern map<int, ButtonID> nnm;
\ No newline at end of file
+extern map<int, ButtonID> nnm;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <functional>
+
+// While a settings transaction is open, variables hold back the notifications of their commit listeners. When the
+// outermost transaction ends, each variable that changed notifies once, with its final value, in the order they
+// first changed. Transactions are per thread and are opened for the lifetime of this object.
+class SettingsTransaction
+{
+public:
+	SettingsTransaction();
+	~SettingsTransaction();
+
+	SettingsTransaction(const SettingsTransaction &) = delete;
+	SettingsTransaction &operator=(const SettingsTransaction &) = delete;
+
+	// Run notify now, or when the transaction ends if one is open. Only the first notify of an owner is kept until
+	// then, so it should compare the final value with the one it captured.
+	static void notify(const void *owner, std::function<void()> notify);
+
+	// Drop the notification of an owner that is going away
+	static void forget(const void *owner);
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Mean of the last windowSize samples, maintained as a running sum so each push costs the same
+// regardless of the window size. Samples that were never pushed count as 0.
+template<size_t Capacity>
+class RunningWindow
+{
+public:
+	float push(float value, int windowSize)
+	{
+		size_t size = size_t(std::clamp(windowSize, 1, int(Capacity)));
+		_front = _front == 0 ? Capacity - 1 : _front - 1;
+		float leaving = _samples[(_front + size) % Capacity]; // Same slot as _front when the window is full
+		_samples[_front] = value;
+		if (size != _windowSize || ++_pushesSinceResum >= Capacity)
+		{
+			// Window changed, or it's time to flush whatever error the running sum picked up
+			_windowSize = size;
+			resum();
+		}
+		else
+		{
+			add(value - leaving);
+		}
+		return _sum / float(_windowSize);
+	}
+
+	void reset()
+	{
+		_samples.fill(0.f);
+		_front = 0;
+		_sum = 0.f;
+		_compensation = 0.f;
+	}
+
+private:
+	// Kahan summation keeps the rounding error of the incremental updates from accumulating
+	void add(float value)
+	{
+		float y = value - _compensation;
+		float t = _sum + y;
+		_compensation = (t - _sum) - y;
+		_sum = t;
+	}
+
+	void resum()
+	{
+		_sum = 0.f;
+		_compensation = 0.f;
+		for (size_t i = 0; i < _windowSize; ++i)
+		{
+			add(_samples[(_front + i) % Capacity]);
+		}
+		_pushesSinceResum = 0;
+	}
+
+	std::array<float, Capacity> _samples{};
+	size_t _front = 0;
+	size_t _windowSize = 0;
+	size_t _pushesSinceResum = 0;
+	float _sum = 0.f;
+	float _compensation = 0.f;
+};
+
+// First order low pass. timeConstant and deltaTime are in seconds.
+class ExponentialFilter
+{
+public:
+	float apply(float value, float timeConstant, float deltaTime);
+
+	void reset();
+
+private:
+	float _value = 0.f;
+	bool _primed = false;
+};
+
+// One Euro filter (Casiez et al. 2012): a low pass whose cutoff rises with the speed of change of the input,
+// so slow movement is smoothed heavily and fast movement lags little. Cutoffs are in Hz, deltaTime in seconds.
+class OneEuroFilter
+{
+public:
+	float apply(float value, float minCutoff, float beta, float deltaTime);
+
+	void reset();
+
+private:
+	static constexpr float DERIVATIVE_CUTOFF = 1.f;
+
+	float _value = 0.f;
+	float _derivative = 0.f;
+	bool _primed = false;
+};
@@ -2,9 +2,11 @@
 
 #include "JoyShockMapper.h"
 #include "DigitalButton.h"
+#include "FlickCurve.h"
 #include <chrono>
 
 class JoyShock;
+struct MouseRemainder;
 
 class ScrollAxis
 {
@@ -33,7 +35,9 @@ public:
 		return _negativeButton && _positiveButton;
 	}
 
-	void processScroll(float distance, float sens, chrono::steady_clock::time_point now);
+	// With hiRes, when both buttons are bound to nothing but opposite wheel notches under the active chords, the
+	// distance scrolls by fractions of a notch instead of pressing them
+	void processScroll(float distance, float sens, bool hiRes, chrono::steady_clock::time_point now, const deque<ButtonID> &chordStack, MouseRemainder &remainder);
 
 	void reset(chrono::steady_clock::time_point now);
 };
@@ -77,6 +81,9 @@ struct Stick
 	bool is_flicking = false;
 	float delta_flick = 0.0;
 	float flick_percent_done = 0.0;
+	FlickCurve flick;                     // Mouse output of the flick
+	float flick_rotation_sent = 0.0;     // Part of the flick's rotation that is already out
+	bool flick_on_output_thread = false; // Sent by the thread of MOUSE_OUTPUT_RATE instead of on the ticks
 	float flick_rotation_counter = 0.0;
 	ScrollAxis scroll;
 	float acceleration = 1.0;
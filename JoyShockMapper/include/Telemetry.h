@@ -1,8 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <string>
-#include <vector>
 
 struct TelemetryDevice
 {
@@ -13,6 +13,16 @@ struct TelemetryDevice
 	int productId = 0;
 };
 
+// The connected devices. Sent on its own whenever it changes rather than with every sample.
+struct TelemetryRoster
+{
+	static constexpr size_t kMaxDevices = 8;
+
+	uint32_t deviceCount = 0;
+	std::array<TelemetryDevice, kMaxDevices> devices{};
+};
+
+// Plain data so that it can be copied into the send ring without touching the heap
 struct TelemetrySample
 {
 	uint64_t timestampMs = 0;
@@ -26,20 +36,88 @@ struct TelemetrySample
 	float sMaxX = 0.0f;
 	float sMinY = 0.0f;
 	float sMaxY = 0.0f;
-	std::string curve = "LINEAR";
-	std::string paramsJson = "{}";
-	std::vector<TelemetryDevice> devices;
+	const char *curve = "LINEAR"; // Must point to static storage
 };
 
 namespace Telemetry
 {
 
-constexpr int kProtoVersion = 2;
+constexpr int kProtoVersion = 3;
 constexpr int kDefaultPort = 8974;
 constexpr int kMaxRateHz = 120;
+constexpr int kRosterRefreshMs = 1000; // Resend the roster periodically for late listeners
+
+// Binary wire format, all fields little endian. Every packet starts with the header.
+namespace Wire
+{
+
+constexpr uint32_t kMagic = 0x544D534A; // "JSMT"
+
+enum class PacketType : uint16_t
+{
+	SAMPLE = 1,
+	ROSTER = 2,
+};
+
+#pragma pack(push, 1)
+struct Header
+{
+	uint32_t magic = kMagic;
+	uint16_t protoVersion = kProtoVersion;
+	uint16_t type = 0;
+};
 
-void Configure(bool enabled, uint16_t port);
+struct Device
+{
+	int32_t handle;
+	int32_t controllerType;
+	int32_t splitType;
+	int32_t vendorId;
+	int32_t productId;
+};
+
+struct Sample
+{
+	Header header;
+	uint64_t timestampMs;
+	float omega;
+	float normalized;
+	float sensX;
+	float sensY;
+	float minThreshold;
+	float maxThreshold;
+	float sMinX;
+	float sMaxX;
+	float sMinY;
+	float sMaxY;
+	char curve[16];
+};
+
+struct Roster
+{
+	Header header;
+	uint32_t deviceCount;
+	Device devices[TelemetryRoster::kMaxDevices]; // Only deviceCount entries are sent
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Header) == 8);
+static_assert(sizeof(Device) == 20);
+static_assert(offsetof(Sample, timestampMs) == 8);
+static_assert(sizeof(Sample) == 72);
+static_assert(offsetof(Roster, devices) == 12);
+
+} // namespace Wire
+
+// The JSON format is the legacy text payload. Binary is the default.
+void Configure(bool enabled, uint16_t port, bool jsonFormat = false);
 void Shutdown();
+
+// Cheap check to skip assembling a sample that would be dropped by the rate limit
+bool IsSendDue();
 void MaybeSend(const TelemetrySample &sample);
 
+// Call whenever the set of connected devices changes
+void SetRoster(const TelemetryRoster &roster);
+
 } // namespace Telemetry
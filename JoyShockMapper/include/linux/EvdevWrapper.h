@@ -0,0 +1,110 @@
+#pragma once
+
+#include "JslWrapper.h"
+#include "SensorClock.h"
+
+#include <array>
+#include <cstdint>
+#include <linux/input.h>
+#include <string>
+#include <vector>
+
+// A JslWrapper that reads the controllers' evdev nodes directly and runs the callbacks as soon as a report
+// arrives, rather than on a TICK_TIME timer. hid-playstation and hid-nintendo expose the motion sensors of a
+// controller as a node of their own, next to the gamepad node (and the touchpad node of PlayStation controllers).
+// Time steps come from the kernel event timestamps, or from the sensor's own MSC_TIMESTAMP when it has one.
+namespace Evdev
+{
+
+enum class NodeRole
+{
+	GAMEPAD,
+	MOTION,
+	TOUCHPAD,
+};
+
+// JS_TYPE_* of the controllers with a kernel driver, or 0
+int ControllerType(int vendorId, int productId);
+
+// Turns the events of the nodes of one controller into its DeviceFrame and IMU reports
+class Decoder
+{
+public:
+	static constexpr size_t kMaxReports = 32;
+
+	explicit Decoder(int controllerType);
+
+	// From EVIOCGABS, before any event of that axis
+	void setRange(NodeRole role, int code, const input_absinfo &info);
+
+	// Returns true when the event ends a report of the node. After a SYN_DROPPED the events are ignored until
+	// the next SYN_REPORT, and needsResync() tells that the state of the node should be read again.
+	bool feed(NodeRole role, const input_event &event);
+	bool needsResync(NodeRole role) const;
+	void resynced(NodeRole role);
+
+	const DeviceFrame &frame() const
+	{
+		return _frame;
+	}
+
+	// Copy the motion reports since the last call, oldest first
+	int takeReports(TimedImuState *reports, int maxReports);
+
+	// Events the kernel couldn't queue, seen as SYN_DROPPED
+	uint64_t droppedReports() const
+	{
+		return _dropped;
+	}
+
+	// Motion reports missing or repeated, seen in their timestamps
+	ImuReportStats reportStats() const
+	{
+		return _clock.stats();
+	}
+
+private:
+	struct Range
+	{
+		int min = -32768;
+		int max = 32767;
+		float resolution = 0.f; // Units per g or per degree per second on the motion node
+	};
+
+	static constexpr size_t kRoles = 3;
+	static constexpr size_t kAxes = ABS_CNT;
+
+	float normalized(NodeRole role, int code, int value) const;
+	void feedKey(NodeRole role, int code, bool pressed);
+	void feedAbs(NodeRole role, int code, int value);
+	void endMotionReport(uint64_t eventNs);
+
+	int _controllerType;
+	bool _analogTriggers = false;
+	std::array<std::array<Range, kAxes>, kRoles> _ranges{};
+	std::array<bool, kRoles> _dropping{};
+	std::array<bool, kRoles> _resync{};
+	int _slot = 0;
+	DeviceFrame _frame{};
+
+	uint32_t _sensorTime = 0; // MSC_TIMESTAMP of the current motion report, in microseconds
+	bool _hasSensorTime = false;
+	uint32_t _lastSensorTime = 0;
+	bool _hasLastSensorTime = false;
+	uint64_t _lastMotionNs = 0;
+	uint64_t _motionTimeNs = 0; // Kernel time of the first report plus the time steps since
+	SensorClock _clock;
+	std::array<TimedImuState, kMaxReports> _reports{};
+	size_t _reportCount = 0;
+	uint64_t _dropped = 0;
+};
+
+// Event time in nanoseconds
+uint64_t EventNs(const input_event &event);
+
+// Whether the command line asks for this backend with --evdev
+bool Requested(const std::vector<std::string> &arguments);
+
+JslWrapper *New();
+
+} // namespace Evdev
@@ -0,0 +1,47 @@
+#include "AllocationCounter.h"
+
+#ifdef JSM_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> allocations{ 0 };
+}
+
+// The array and nothrow forms call this one
+void *operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+std::optional<size_t> AllocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+std::optional<size_t> AllocationCount()
+{
+	return std::nullopt;
+}
+
+#endif
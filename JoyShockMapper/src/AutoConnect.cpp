@@ -7,7 +7,7 @@
 namespace JSM
 {
 
-AutoConnect::AutoConnect(shared_ptr<JslWrapper> joyshock, bool start)
+AutoConnect::AutoConnect(const atomic<shared_ptr<JslWrapper>> &joyshock, bool start)
   : PollingThread("AutoConnect thread", std::bind(&AutoConnect::AutoConnectPoll, this, std::placeholders::_1), nullptr, 1000, start)
   , jsl(joyshock)
 {
@@ -15,7 +15,13 @@ AutoConnect::AutoConnect(shared_ptr<JslWrapper> joyshock, bool start)
 
 bool AutoConnect::AutoConnectPoll(void* param)
 {
-	int realSize = jsl->GetDeviceCount() - Gamepad::getCount();
+	shared_ptr<JslWrapper> backend = jsl.load();
+	// Replays and synthetic devices have no controllers to hotplug
+	if (!backend || !backend->IsLive())
+	{
+		return true;
+	}
+	int realSize = backend->GetDeviceCount() - Gamepad::getCount();
 	if(lastSize != realSize)
 	{
 		COUT_INFO << "[AUTOCONNECT] Going from " << lastSize << " devices to " << realSize << ".\n";
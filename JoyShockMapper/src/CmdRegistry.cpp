@@ -1,12 +1,17 @@
 #include "CmdRegistry.h"
 #include "PlatformDefinitions.h"
+#include "ConfigParser.h"
+#include "JSMVariable.hpp"
 
 #include <cctype>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
 #include <memory>
-#include <regex>
+#include <sstream>
 #include <string>
 #include <fstream>
+#include <utility>
 
 JSMCommand::JSMCommand(string_view name)
   : _parse()
@@ -54,6 +59,11 @@ bool JSMCommand::parseData(string_view arguments, string_view label)
 	return true; // Command is completely processed
 }
 
+JSMCommand::CompiledData JSMCommand::compileData(string_view arguments, string_view label)
+{
+	return nullptr;
+}
+
 CmdRegistry::CmdRegistry()
 {
     std::string NONAME;
@@ -72,25 +82,61 @@ bool CmdRegistry::loadConfigFile(string fileName)
 	if (*fileName.begin() == '\"' && *(fileName.end() - 1) == '\"')
 		fileName = fileName.substr(1, fileName.size() - 2);
 
-	ifstream file(fileName);
-	if (!file.is_open())
+	error_code error;
+	filesystem::path path(fileName);
+	if (!filesystem::is_regular_file(path, error))
 	{
-		file.open(string{ BASE_JSM_CONFIG_FOLDER() } + fileName);
+		path = string{ BASE_JSM_CONFIG_FOLDER() } + fileName;
+		if (!filesystem::is_regular_file(path, error))
+		{
+			return false;
+		}
 	}
-	if (file)
+
+	// Listeners hear of the settings of the whole file at once
+	SettingsTransaction transaction;
+	if (auto profile = _profiles.find(path))
 	{
 		COUT << "Loading commands from file ";
 		COUT_INFO << fileName << '\n';
-		// https://stackoverflow.com/questions/6892754/creating-a-simple-configuration-file-and-parser-in-c
-		string line;
-		while (getline(file, line))
+		// The profile's lines are already recorded wherever they need to be.
+		auto recording = exchange(_recording, nullptr);
+		for (auto& step : profile->steps)
 		{
-			processLine(line);
+			step();
 		}
-		file.close();
+		_recording = recording;
 		return true;
 	}
-	return false;
+
+	// Take the modification time first, so that a change made while reading is noticed next time.
+	auto modified = filesystem::last_write_time(path, error);
+	ifstream file(path, ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	COUT << "Loading commands from file ";
+	COUT_INFO << fileName << '\n';
+	string content{ istreambuf_iterator<char>(file), istreambuf_iterator<char>() };
+	file.close();
+
+	auto profile = make_shared<ProfileCache::Profile>();
+	profile->file = ProfileCache::stamp(path, modified, content);
+	auto recording = exchange(_recording, profile.get());
+	// https://stackoverflow.com/questions/6892754/creating-a-simple-configuration-file-and-parser-in-c
+	stringstream lines(content);
+	string line;
+	while (getline(lines, line))
+	{
+		processLine(line);
+	}
+	_recording = recording;
+	if (!error)
+	{
+		_profiles.store(profile);
+	}
+	return true;
 }
 
 string_view CmdRegistry::strtrim(string_view str)
@@ -121,7 +167,7 @@ string_view CmdRegistry::strtrim(string_view str)
 bool CmdRegistry::add(JSMCommand* newCommand)
 {
 	// Check that the pointer is valid, that the name is valid.
-	if (newCommand && regex_match(newCommand->_name, regex(R"(^(\+|-|\w+)$)")))
+	if (newCommand && ConfigParser::Active::isCommandName(newCommand->_name))
 	{
 		// Unique pointers automatically delete the pointer on object destruction
 		_registry.emplace(newCommand->_name, unique_ptr<JSMCommand>(newCommand));
@@ -134,7 +180,7 @@ bool CmdRegistry::add(JSMCommand* newCommand)
 bool CmdRegistry::Remove(string_view name)
 {
 	// If I allow multiple commands with the same name, I should have a way to specify which one I want to remove.
-	CmdMap::iterator cmd = find_if(_registry.begin(), _registry.end(), bind(&CmdRegistry::findCommandWithName, name, placeholders::_1));
+	CmdMap::iterator cmd = _registry.find(name);
 	if (cmd != _registry.end())
 	{
 		_registry.erase(cmd);
@@ -143,11 +189,6 @@ bool CmdRegistry::Remove(string_view name)
 	return false;
 }
 
-bool CmdRegistry::findCommandWithName(string_view name, const CmdMap::value_type& pair)
-{
-	return name == pair.first;
-}
-
 bool CmdRegistry::isCommandValid(string_view line) const
 {
 	ifstream file(line.data());
@@ -156,90 +197,90 @@ bool CmdRegistry::isCommandValid(string_view line) const
 		file.close();
 		return true;
 	}
-	smatch results;
-	string combo, name, arguments, label;
-	char op = '\0';
-	const string lineStr(line);
-	if (regex_match(lineStr, results, regex(R"(^\s*([+-]?\w*)\s*([,+]\s*([+-]?\w*))?\s*([^#\n]*)(#\s*(.*))?$)")))
+	ConfigParser::Line parts;
+	ConfigParser::Active::parseLine(line, ",+", parts);
+	return _registry.find(parts.name) != _registry.end();
+}
+
+void CmdRegistry::processLine(const string& line)
+{
+	auto trimmedLine = string{ strtrim(line) };
+
+	if (trimmedLine.empty() || trimmedLine.front() == '#')
 	{
-		if (results[2].length() > 0)
-		{
-			combo = results[1];
-			op = results[2].str()[0];
-			name = results[3];
-		}
-		else
+		return; // ignore empty lines
+	}
+
+	if (loadConfigFile(trimmedLine))
+	{
+		// When replayed, the file is looked up again and replays its own compiled profile.
+		if (_recording)
 		{
-			name = results[1];
+			_recording->steps.push_back([this, trimmedLine]()
+			  { processLine(trimmedLine); });
 		}
-
-		arguments = results[4];
-		label = results[6];
+		return;
 	}
 
-	bool hasProcessed = false;
-	CmdMap::const_iterator cmd = find_if(_registry.cbegin(), _registry.cend(), bind(&CmdRegistry::findCommandWithName, name, placeholders::_1));
-	return cmd != _registry.end();
+	// Break up the line of text in its relevant parts.
+	ConfigParser::Line parts;
+	ConfigParser::Active::parseLine(trimmedLine, ",+*", parts);
+	// Command parsers may read the arguments as C strings, so they are copied out of the line.
+	auto command = make_shared<CommandLine>(trimmedLine, string(parts.combo), string(parts.name), string(parts.arguments), string(parts.label), parts.op);
+	runLine(*command);
+	if (_recording)
+	{
+		_recording->steps.push_back([this, command]()
+		  { runLine(*command); });
+	}
 }
 
-void CmdRegistry::processLine(const string& line)
+void CmdRegistry::runLine(CommandLine& command)
 {
-	auto trimmedLine = string{ strtrim(line) };
-
-	if (!trimmedLine.empty() && trimmedLine.front() != '#' && !loadConfigFile(trimmedLine))
+	bool hasProcessed = false;
+	// Commands with the same name are next to each other in the map. The end of their range is looked up on
+	// each step because a command can add or remove others, like GRID_SIZE does.
+	CmdMap::iterator cmd = _registry.lower_bound(command.name);
+	// Arguments are only compiled for a command that is alone with its name, since they're read by the command.
+	bool compile = cmd != _registry.end() && next(cmd) == _registry.upper_bound(command.name);
+	while (cmd != _registry.end() && cmd->first == command.name)
 	{
-		smatch results;
-		string combo, name, arguments, label;
-		char op = '\0';
-		// Break up the line of text in its relevant parts.
-		// Pro tip: use regex101.com to develop these beautiful monstrosities. :P
-		// Also, use raw strings R"(...)" to avoid the need to escape characters
-		// I dislike having to code in exception for + and - _buttons not being \w characters
-		if (regex_match(trimmedLine, results, regex(R"(^\s*([+-]?\w*)\s*([,+\*]\s*([+-]?\w*))?\s*([^#\n]*)(#\s*(.*))?$)")))
+		if (command.combo.empty())
 		{
-			if (results[2].length() > 0)
-			{
-				combo = results[1];
-				op = results[2].str()[0];
-				name = results[3];
-			}
-			else
-			{
-				name = results[1];
-			}
-
-			arguments = results[4];
-			label = results[6];
+			hasProcessed |= runCommand(*cmd->second, command, compile);
 		}
-
-		bool hasProcessed = false;
-		CmdMap::iterator cmd = find_if(_registry.begin(), _registry.end(), bind(&CmdRegistry::findCommandWithName, name, placeholders::_1));
-		while (cmd != _registry.end())
+		else
 		{
-			if (combo.empty())
-			{
-				hasProcessed |= cmd->second->parseData(arguments, label);
-			}
-			else
+			auto modCommand = cmd->second->getModifiedCmd(command.op, command.combo);
+			if (modCommand)
 			{
-				auto modCommand = cmd->second->getModifiedCmd(op, combo);
-				if (modCommand)
-				{
-					hasProcessed |= modCommand->parseData(arguments, label);
-				}
-				// Any task set to be run on destruction is done here.
+				hasProcessed |= runCommand(*modCommand, command, compile);
 			}
-			cmd = find_if(++cmd, _registry.end(), bind(&CmdRegistry::findCommandWithName, name, placeholders::_1));
+			// Any task set to be run on destruction is done here.
 		}
+		++cmd;
+	}
 
-		if (!hasProcessed)
-		{
-			CERR << "Unrecognized command: \"" << trimmedLine << "\"\nEnter ";
-			COUT_INFO << "HELP";
-			CERR << " to display all commands.\n";
-		}
+	if (!hasProcessed)
+	{
+		CERR << "Unrecognized command: \"" << command.line << "\"\nEnter ";
+		COUT_INFO << "HELP";
+		CERR << " to display all commands.\n";
+	}
+}
+
+bool CmdRegistry::runCommand(JSMCommand& cmd, CommandLine& command, bool compile)
+{
+	if (compile && !command.compiled)
+	{
+		command.compiled = cmd.compileData(command.arguments, command.label);
+	}
+	if (compile && *command.compiled && (*command.compiled)(cmd))
+	{
+		return true;
 	}
-	// else ignore empty lines
+	// Not compiled, or compiled for a command of another kind: nothing was applied yet.
+	return cmd.parseData(command.arguments, command.label);
 }
 
 void CmdRegistry::GetCommandList(vector<string_view>& outList) const
@@ -0,0 +1,232 @@
+#include "ConfigParser.h"
+
+#include <cctype>
+#include <regex>
+#include <string>
+
+namespace ConfigParser
+{
+namespace
+{
+// The character classes of the regular expressions: \s and \w
+bool isSpace(char c)
+{
+	return isspace((unsigned char)c);
+}
+
+bool isWord(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+// What . doesn't match
+bool isLineBreak(char c)
+{
+	return c == '\n' || c == '\r';
+}
+
+size_t skipSpaces(std::string_view text, size_t pos)
+{
+	while (pos < text.size() && isSpace(text[pos]))
+		++pos;
+	return pos;
+}
+
+// [+-]?\w*
+std::string_view commandWord(std::string_view text, size_t &pos)
+{
+	size_t start = pos;
+	if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+		++pos;
+	while (pos < text.size() && isWord(text[pos]))
+		++pos;
+	return text.substr(start, pos - start);
+}
+
+// (\".*?\")|\w*[0-9A-Z]|\W from pos. Returns the length of the key, 0 when none matches.
+size_t mappingKey(std::string_view text, size_t pos)
+{
+	if (pos >= text.size())
+		return 0;
+	if (text[pos] == '"')
+	{
+		for (size_t end = pos + 1; end < text.size() && !isLineBreak(text[end]); ++end)
+		{
+			if (text[end] == '"')
+				return end + 1 - pos;
+		}
+	}
+	// The longest run of word characters that ends with a digit or a capital
+	size_t runEnd = pos;
+	while (runEnd < text.size() && isWord(text[runEnd]))
+		++runEnd;
+	for (size_t end = runEnd; end > pos; --end)
+	{
+		char last = text[end - 1];
+		if (isdigit((unsigned char)last) || (last >= 'A' && last <= 'Z'))
+			return end - pos;
+	}
+	return isWord(text[pos]) ? 0 : 1;
+}
+
+bool hasLineBreak(std::string_view text)
+{
+	for (char c : text)
+	{
+		if (isLineBreak(c))
+			return true;
+	}
+	return false;
+}
+
+template<typename Match>
+std::string_view view(const Match &match)
+{
+	return match.matched ? std::string_view(match.first, match.second) : std::string_view();
+}
+
+using ViewMatch = std::match_results<std::string_view::const_iterator>;
+} // namespace
+
+bool Tokenizer::parseLine(std::string_view line, std::string_view ops, Line &out)
+{
+	out = {};
+	Line parts;
+	size_t pos = skipSpaces(line, 0);
+	std::string_view first = commandWord(line, pos);
+	pos = skipSpaces(line, pos);
+	if (pos < line.size() && ops.find(line[pos]) != std::string_view::npos)
+	{
+		parts.combo = first;
+		parts.op = line[pos];
+		pos = skipSpaces(line, pos + 1);
+		parts.name = commandWord(line, pos);
+		pos = skipSpaces(line, pos);
+	}
+	else
+	{
+		parts.name = first;
+	}
+	size_t argumentsEnd = pos;
+	while (argumentsEnd < line.size() && line[argumentsEnd] != '#' && line[argumentsEnd] != '\n')
+		++argumentsEnd;
+	parts.arguments = line.substr(pos, argumentsEnd - pos);
+	if (argumentsEnd < line.size())
+	{
+		if (line[argumentsEnd] != '#')
+			return false;
+		parts.label = line.substr(skipSpaces(line, argumentsEnd + 1));
+		if (hasLineBreak(parts.label))
+			return false;
+	}
+	out = parts;
+	return true;
+}
+
+bool Tokenizer::parseAssignment(std::string_view arguments, std::string_view &value)
+{
+	size_t pos = skipSpaces(arguments, 0);
+	if (pos >= arguments.size() || arguments[pos] != '=')
+		return false;
+	std::string_view rest = arguments.substr(skipSpaces(arguments, pos + 1));
+	if (hasLineBreak(rest))
+		return false;
+	value = rest;
+	return true;
+}
+
+bool Tokenizer::nextMappingToken(std::string_view value, MappingToken &out)
+{
+	static constexpr std::string_view actions = "!^-";
+	static constexpr std::string_view events = "\\/+'_";
+	// Leading spaces are given back one at a time if nothing matches after them, like \s* does
+	for (size_t start = skipSpaces(value, 0) + 1; start-- > 0;)
+	{
+		bool hasAction = start < value.size() && actions.find(value[start]) != std::string_view::npos;
+		for (int withAction = hasAction ? 1 : 0; withAction >= 0; --withAction)
+		{
+			size_t pos = start + withAction;
+			size_t keyLength = mappingKey(value, pos);
+			if (keyLength == 0)
+				continue;
+			MappingToken token;
+			token.action = withAction ? value[start] : '\0';
+			token.key = value.substr(pos, keyLength);
+			pos += keyLength;
+			if (pos < value.size() && events.find(value[pos]) != std::string_view::npos)
+				token.event = value[pos++];
+			token.rest = value.substr(skipSpaces(value, pos));
+			if (hasLineBreak(token.rest))
+				return false;
+			out = token;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Tokenizer::isCommandName(std::string_view name)
+{
+	if (name == "+" || name == "-")
+		return true;
+	if (name.empty())
+		return false;
+	for (char c : name)
+	{
+		if (!isWord(c))
+			return false;
+	}
+	return true;
+}
+
+bool Regex::parseLine(std::string_view line, std::string_view ops, Line &out)
+{
+	out = {};
+	ViewMatch results;
+	// Pro tip: use regex101.com to develop these beautiful monstrosities. :P
+	// I dislike having to code in exception for + and - _buttons not being \w characters
+	std::string pattern = R"(^\s*([+-]?\w*)\s*([)" + std::string(ops) + R"(]\s*([+-]?\w*))?\s*([^#\n]*)(#\s*(.*))?$)";
+	if (!std::regex_match(line.begin(), line.end(), results, std::regex(pattern)))
+		return false;
+	if (results[2].length() > 0)
+	{
+		out.combo = view(results[1]);
+		out.op = *results[2].first;
+		out.name = view(results[3]);
+	}
+	else
+	{
+		out.name = view(results[1]);
+	}
+	out.arguments = view(results[4]);
+	out.label = view(results[6]);
+	return true;
+}
+
+bool Regex::parseAssignment(std::string_view arguments, std::string_view &value)
+{
+	ViewMatch results;
+	if (!std::regex_match(arguments.begin(), arguments.end(), results, std::regex(R"(\s*=\s*(.*))")))
+		return false;
+	value = view(results[1]);
+	return true;
+}
+
+bool Regex::nextMappingToken(std::string_view value, MappingToken &out)
+{
+	ViewMatch results;
+	static constexpr std::string_view rgx = R"(\s*([!\^-]?)((\".*?\")|\w*[0-9A-Z]|\W)([\\\/+'_]?)\s*(.*))";
+	if (!std::regex_match(value.begin(), value.end(), results, std::regex(rgx.data())) || results[0].length() == 0)
+		return false;
+	out.action = results[1].length() > 0 ? *results[1].first : '\0';
+	out.key = view(results[2]);
+	out.event = results[4].length() > 0 ? *results[4].first : '\0';
+	out.rest = view(results[5]);
+	return true;
+}
+
+bool Regex::isCommandName(std::string_view name)
+{
+	return std::regex_match(name.begin(), name.end(), std::regex(R"(^(\+|-|\w+)$)"));
+}
+} // namespace ConfigParser
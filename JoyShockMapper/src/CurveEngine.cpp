@@ -0,0 +1,128 @@
+#include "CurveEngine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// exp(-17) is below float resolution next to 1, so the saturating curves are flat past this point
+constexpr float SATURATION = 17.0f;
+
+float clamp01(float t)
+{
+    return std::clamp(t, 0.0f, 1.0f);
+}
+}
+
+void CurveEngine::configure(const CurveParams &params, bool useTable)
+{
+    if (_configured && params == _params && useTable == _useTable)
+    {
+        return;
+    }
+    _configured = true;
+    _params = params;
+
+    const float denom = params.maxThreshold - params.minThreshold;
+    _linearScale = denom > 0.0f ? 1.0f / denom : 0.0f;
+
+    _naturalK = params.naturalVHalf > 0.0f ? std::log(2.0f) / params.naturalVHalf : 0.0f;
+
+    _powerInvVRef = params.powerVRef > 0.0f ? 1.0f / params.powerVRef : 0.0f;
+
+    _quadraticInvCap = params.maxThreshold > 0.0f ? 1.0f / params.maxThreshold : 0.0f;
+
+    const float width = params.sigmoidWidth > 0.0f ? params.sigmoidWidth : 1e-6f;
+    _sigmoidInvWidth = 1.0f / width;
+    _sigmoidRaw0 = 1.0f / (1.0f + std::exp(params.sigmoidMid * _sigmoidInvWidth));
+    _sigmoidInvDenom = 1.0f - _sigmoidRaw0 > 0.0f ? 1.0f / (1.0f - _sigmoidRaw0) : 0.0f;
+
+    _jumpInvTau = params.jumpTau > 0.0f ? 1.0f / params.jumpTau : 0.0f;
+    _jumpRaw0 = 0.0f >= params.maxThreshold ? 1.0f : std::exp(-params.maxThreshold * _jumpInvTau);
+    _jumpInvDenom = 1.0f - _jumpRaw0 > 0.0f ? 1.0f / (1.0f - _jumpRaw0) : 0.0f;
+
+    _useTable = useTable;
+    _tableEnd = useTable ? tableRange() : 0.0f;
+    if (_tableEnd > 0.0f)
+    {
+        _tableScale = float(TABLE_SIZE) / _tableEnd;
+        for (size_t i = 0; i <= TABLE_SIZE; ++i)
+        {
+            _table[i] = exactShape(_tableEnd * float(i) / float(TABLE_SIZE));
+        }
+    }
+}
+
+// Where the curves that are worth tabulating stop changing. 0 means don't use a table.
+float CurveEngine::tableRange() const
+{
+    switch (_params.shape)
+    {
+    case CurveShape::NATURAL:
+        return _naturalK > 0.0f ? SATURATION / _naturalK : 0.0f;
+    case CurveShape::POWER:
+        // Below an exponent of 1 the slope at 0 is unbounded and interpolation would be far off
+        if (_powerInvVRef <= 0.0f || _params.powerExponent < 1.0f)
+            return 0.0f;
+        return _params.powerVRef * std::pow(SATURATION, 1.0f / _params.powerExponent);
+    case CurveShape::SIGMOID:
+        return std::max(0.0f, _params.sigmoidMid + SATURATION / _sigmoidInvWidth);
+    case CurveShape::JUMP:
+        return _jumpInvTau > 0.0f ? std::max(0.0f, _params.maxThreshold) : 0.0f;
+    default:
+        // Linear and quadratic are cheaper to compute than to look up
+        return 0.0f;
+    }
+}
+
+float CurveEngine::shape(float omegaAdjusted) const
+{
+    if (omegaAdjusted >= 0.0f && omegaAdjusted < _tableEnd)
+    {
+        const float position = omegaAdjusted * _tableScale;
+        const size_t index = std::min(size_t(position), TABLE_SIZE - 1);
+        const float fraction = position - float(index);
+        return _table[index] + (_table[index + 1] - _table[index]) * fraction;
+    }
+    return exactShape(omegaAdjusted);
+}
+
+float CurveEngine::exactShape(float omega) const
+{
+    switch (_params.shape)
+    {
+    case CurveShape::NATURAL:
+        if (_naturalK <= 0.0f)
+            return 1.0f;
+        return 1.0f - std::exp(-_naturalK * omega);
+    case CurveShape::POWER:
+        if (_powerInvVRef <= 0.0f)
+            return 1.0f;
+        if (_params.powerExponent <= 0.0f || omega <= 0.0f)
+            return 0.0f;
+        return clamp01(1.0f - std::exp(-std::pow(omega * _powerInvVRef, _params.powerExponent)));
+    case CurveShape::QUADRATIC:
+    {
+        if (_quadraticInvCap <= 0.0f || omega >= _params.maxThreshold)
+            return 1.0f;
+        const float t = omega * _quadraticInvCap;
+        return t * t;
+    }
+    case CurveShape::SIGMOID:
+    {
+        const float sigma = 1.0f / (1.0f + std::exp(-(omega - _params.sigmoidMid) * _sigmoidInvWidth));
+        return clamp01((sigma - _sigmoidRaw0) * _sigmoidInvDenom);
+    }
+    case CurveShape::JUMP:
+    {
+        if (_jumpInvTau <= 0.0f)
+            return omega < _params.maxThreshold ? 0.0f : 1.0f;
+        const float raw = omega >= _params.maxThreshold ? 1.0f : std::exp((omega - _params.maxThreshold) * _jumpInvTau);
+        return clamp01((raw - _jumpRaw0) * _jumpInvDenom);
+    }
+    case CurveShape::LINEAR:
+    default:
+        if (_linearScale > 0.0f)
+            return clamp01(omega * _linearScale);
+        return omega > 0.0f ? 1.0f : 0.0f;
+    }
+}
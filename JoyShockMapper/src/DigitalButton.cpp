@@ -15,6 +15,7 @@ void DigitalButton::Context::updateChordStack(bool isPressed, ButtonID id)
 			{
 				// COUT << "Button " << index << " is pressed!\n";
 				chordStack.push_front(id); // Always push at the fromt to make it a stack
+				++chordStackVersion;
 			}
 		}
 		else
@@ -24,6 +25,7 @@ void DigitalButton::Context::updateChordStack(bool isPressed, ButtonID id)
 			{
 				// COUT << "Button " << index << " is released!\n";
 				chordStack.erase(foundChord); // The chord is released
+				++chordStackVersion;
 			}
 		}
 	}
@@ -1080,6 +1082,10 @@ DigitalButton::Context::Context(Gamepad::Callback virtualControllerCallback, sha
 		{
 			virtual_controller->set(ControllerScheme::NONE);
 		}
+		else
+		{
+			virtualScheme = virtual_controller->value();
+		}
 		if (!error.empty())
 		{
 			CERR << error << '\n';
@@ -0,0 +1,41 @@
+#include "FlickCurve.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+FlickCurve::FlickCurve(Clock::time_point start, float angle, float flickTime, float timeExponent)
+  : _start(start)
+  , _end(start)
+  , _angle(angle)
+{
+	float duration = flickTime;
+	// don't divide by zero
+	if (std::abs(angle) > 0.f)
+	{
+		duration *= std::pow(std::abs(angle) / std::numbers::pi_v<float>, timeExponent);
+	}
+	if (duration > 0.f)
+	{
+		_end += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(duration));
+	}
+}
+
+float FlickCurve::percentDone(Clock::time_point now) const
+{
+	if (now >= _end)
+	{
+		return 1.f;
+	}
+	if (now <= _start)
+	{
+		return 0.f;
+	}
+	return std::chrono::duration<float>(now - _start).count() / std::chrono::duration<float>(_end - _start).count();
+}
+
+float FlickCurve::rotation(Clock::time_point now) const
+{
+	// warping towards 1.0
+	float remaining = 1.f - percentDone(now);
+	return _angle * (1.f - remaining * remaining);
+}
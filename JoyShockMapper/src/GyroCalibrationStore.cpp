@@ -0,0 +1,117 @@
+#include "GyroCalibrationStore.h"
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+constexpr const char *NO_SERIAL = "-";
+
+// Serials are written as one word
+std::string serialWord(const std::string &serial)
+{
+	if (serial.empty())
+	{
+		return NO_SERIAL;
+	}
+	std::string word(serial);
+	for (char &c : word)
+	{
+		if (std::isspace(static_cast<unsigned char>(c)))
+		{
+			c = '_';
+		}
+	}
+	return word;
+}
+
+// Keys as they are read back from the file
+GyroCalibrationStore::Key stored(const GyroCalibrationStore::Key &key)
+{
+	std::string word = serialWord(key.serial);
+	return { key.vendorId, key.productId, word == NO_SERIAL ? std::string() : word };
+}
+} // namespace
+
+GyroCalibrationStore::GyroCalibrationStore(std::string path)
+  : _path(std::move(path))
+{
+}
+
+bool GyroCalibrationStore::load()
+{
+	_offsets.clear();
+	std::error_code error;
+	if (!std::filesystem::exists(_path, error))
+	{
+		return true;
+	}
+	std::ifstream file(_path);
+	if (!file)
+	{
+		return false;
+	}
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream ss(line);
+		Key key;
+		Offset offset;
+		if (ss >> std::hex >> key.vendorId >> key.productId >> std::dec >> key.serial >> offset.x >> offset.y >> offset.z)
+		{
+			if (key.serial == NO_SERIAL)
+			{
+				key.serial.clear();
+			}
+			_offsets[key] = offset;
+		}
+	}
+	return true;
+}
+
+bool GyroCalibrationStore::save() const
+{
+	std::error_code error;
+	auto folder = std::filesystem::path(_path).parent_path();
+	if (!folder.empty())
+	{
+		std::filesystem::create_directories(folder, error);
+	}
+	std::string temporary = _path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::trunc);
+		if (!file)
+		{
+			return false;
+		}
+		file << std::setprecision(9);
+		for (auto &[key, offset] : _offsets)
+		{
+			file << std::hex << std::setfill('0') << std::setw(4) << key.vendorId << ' ' << std::setw(4) << key.productId
+			     << std::dec << std::setfill(' ') << ' ' << serialWord(key.serial) << ' ' << offset.x << ' ' << offset.y << ' ' << offset.z << '\n';
+		}
+		if (!file.flush())
+		{
+			return false;
+		}
+	}
+	std::filesystem::rename(temporary, _path, error);
+	return !error;
+}
+
+std::optional<GyroCalibrationStore::Offset> GyroCalibrationStore::find(const Key &key) const
+{
+	auto found = _offsets.find(stored(key));
+	if (found == _offsets.end())
+	{
+		return std::nullopt;
+	}
+	return found->second;
+}
+
+void GyroCalibrationStore::set(const Key &key, const Offset &offset)
+{
+	_offsets[stored(key)] = offset;
+}
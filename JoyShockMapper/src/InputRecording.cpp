@@ -0,0 +1,149 @@
+#include "InputRecording.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+
+using namespace InputRecording;
+
+// Records go through stdio's buffer so that a tick is a memcpy and the file is written in large chunks
+constexpr size_t kFileBufferSize = 1 << 20;
+
+std::mutex recordLock;
+std::FILE *recordFile = nullptr;
+std::atomic_bool recording = false;
+std::chrono::steady_clock::time_point recordStart;
+size_t recordCount = 0;
+
+File::Frame toFileFrame(const DeviceInfo &device, const DeviceFrame &frame, float deltaTime, int numReports)
+{
+	File::Frame out;
+	memset(&out, 0, sizeof(out));
+	out.tickNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - recordStart).count());
+	out.sensorTimestamp = frame.timestamp;
+	out.deltaTime = deltaTime;
+	out.handle = device.handle;
+	out.controllerType = uint8_t(device.controllerType);
+	out.splitType = uint8_t(device.splitType);
+	out.vendorId = uint16_t(device.vendorId);
+	out.productId = uint16_t(device.productId);
+	out.buttons = frame.buttons;
+	out.leftX = frame.leftX;
+	out.leftY = frame.leftY;
+	out.rightX = frame.rightX;
+	out.rightY = frame.rightY;
+	out.leftTrigger = frame.leftTrigger;
+	out.rightTrigger = frame.rightTrigger;
+	out.accel[0] = frame.imu.accelX;
+	out.accel[1] = frame.imu.accelY;
+	out.accel[2] = frame.imu.accelZ;
+	out.gyro[0] = frame.imu.gyroX;
+	out.gyro[1] = frame.imu.gyroY;
+	out.gyro[2] = frame.imu.gyroZ;
+	out.touchDown = (frame.touch.t0Down ? 1 : 0) | (frame.touch.t1Down ? 2 : 0);
+	out.touch[0] = frame.touch.t0X;
+	out.touch[1] = frame.touch.t0Y;
+	out.touch[2] = frame.touch.t1X;
+	out.touch[3] = frame.touch.t1Y;
+	out.imuReportCount = int16_t(std::clamp(numReports, -1, int(INT16_MAX)));
+	return out;
+}
+
+File::Report toFileReport(const TimedImuState &report)
+{
+	File::Report out;
+	out.accel[0] = report.imu.accelX;
+	out.accel[1] = report.imu.accelY;
+	out.accel[2] = report.imu.accelZ;
+	out.gyro[0] = report.imu.gyroX;
+	out.gyro[1] = report.imu.gyroY;
+	out.gyro[2] = report.imu.gyroZ;
+	out.deltaTime = report.deltaTime;
+	return out;
+}
+
+void closeFile()
+{
+	recording = false;
+	if (recordFile)
+	{
+		std::fclose(recordFile);
+		recordFile = nullptr;
+	}
+}
+
+} // namespace
+
+namespace InputRecording
+{
+
+bool Start(const std::string &path, std::string &error)
+{
+	std::lock_guard guard(recordLock);
+	closeFile();
+
+	recordFile = std::fopen(path.c_str(), "wb");
+	if (!recordFile)
+	{
+		error = std::strerror(errno);
+		return false;
+	}
+	std::setvbuf(recordFile, nullptr, _IOFBF, kFileBufferSize);
+
+	File::Header header;
+	header.frameSize = sizeof(File::Frame);
+	header.reportSize = sizeof(File::Report);
+	if (std::fwrite(&header, sizeof(header), 1, recordFile) != 1)
+	{
+		error = std::strerror(errno);
+		closeFile();
+		return false;
+	}
+	recordStart = std::chrono::steady_clock::now();
+	recordCount = 0;
+	recording = true;
+	return true;
+}
+
+size_t Stop()
+{
+	std::lock_guard guard(recordLock);
+	closeFile();
+	return std::exchange(recordCount, 0);
+}
+
+bool IsRecording()
+{
+	return recording.load(std::memory_order_relaxed);
+}
+
+void Record(const DeviceInfo &device, const DeviceFrame &frame, float deltaTime, const TimedImuState *reports, int numReports)
+{
+	if (!recording.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+	std::lock_guard guard(recordLock);
+	if (!recordFile)
+	{
+		return;
+	}
+	File::Frame out = toFileFrame(device, frame, deltaTime, numReports);
+	std::fwrite(&out, sizeof(out), 1, recordFile);
+	for (int i = 0; i < out.imuReportCount; ++i)
+	{
+		File::Report report = toFileReport(reports[i]);
+		std::fwrite(&report, sizeof(report), 1, recordFile);
+	}
+	++recordCount;
+}
+
+} // namespace InputRecording
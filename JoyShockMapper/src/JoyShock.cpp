@@ -1,12 +1,14 @@
 #include "JoyShock.h"
 #include "InputHelpers.h"
 #include <algorithm>
+#include <atomic>
 #define _USE_MATH_DEFINES
 #include <math.h> // M_PI
 
-extern shared_ptr<JslWrapper> jsl;
+extern atomic<shared_ptr<JslWrapper>> jsl;
 extern vector<JSMButton> mappings;
 extern vector<JSMButton> grid_mappings;
+extern unordered_map<int, shared_ptr<JoyShock>> handle_to_joyshock;
 extern float os_mouse_speed;
 extern float last_flick_and_rotation;
 
@@ -32,7 +34,7 @@ AdaptiveTriggerSetting JoyShock::_unusedEffect;
 JoyShock::JoyShock(int uniqueHandle, int controllerSplitType, shared_ptr<DigitalButton::Context> sharedButtonCommon)
   : _handle(uniqueHandle)
   , _splitType(controllerSplitType)
-  , _controllerType(jsl->GetControllerType(uniqueHandle))
+  , _controllerType(jsl.load()->GetControllerType(uniqueHandle))
   , _triggerState(NUM_ANALOG_TRIGGERS, DstState::NoPress)
   , _prevTriggerPosition(NUM_ANALOG_TRIGGERS, deque<float>(MAGIC_TRIGGER_SMOOTHING, 0.f))
   , _light_bar(SettingsManager::get<Color>(SettingID::LIGHT_BAR)->value())
@@ -45,8 +47,8 @@ JoyShock::JoyShock(int uniqueHandle, int controllerSplitType, shared_ptr<Digital
   , _motionStick(SettingID::MOTION_DEADZONE_INNER, SettingID::MOTION_DEADZONE_OUTER, SettingID::MOTION_RING_MODE,
       SettingID::MOTION_STICK_MODE, ButtonID::MRING, ButtonID::MLEFT, ButtonID::MRIGHT, ButtonID::MUP, ButtonID::MDOWN)
 {
-	_vendorId = jsl->GetControllerVendor(uniqueHandle);
-	_productId = jsl->GetControllerProduct(uniqueHandle);
+	_vendorId = jsl.load()->GetControllerVendor(uniqueHandle);
+	_productId = jsl.load()->GetControllerProduct(uniqueHandle);
 	if (!sharedButtonCommon)
 	{
 		_context = make_shared<DigitalButton::Context>(bind(&JoyShock::onVirtualControllerNotification, this, placeholders::_1, placeholders::_2, placeholders::_3), _motion);
@@ -67,7 +69,7 @@ JoyShock::JoyShock(int uniqueHandle, int controllerSplitType, shared_ptr<Digital
 	{
 		SettingsManager::getV<ControllerScheme>(SettingID::VIRTUAL_CONTROLLER)->set(ControllerScheme::NONE);
 	}
-	jsl->SetLightColour(_handle, getSetting<Color>(SettingID::LIGHT_BAR).raw);
+	jsl.load()->SetLightColour(_handle, getSetting<Color>(SettingID::LIGHT_BAR).raw);
 	for (int i = 0; i < MAX_NO_OF_TOUCH; ++i)
 	{
 		_touchpads.push_back(TouchStick(i, _context, _handle));
@@ -77,7 +79,7 @@ JoyShock::JoyShock(int uniqueHandle, int controllerSplitType, shared_ptr<Digital
 	_motionStick.scroll.init(_buttons[int(ButtonID::MLEFT)], _buttons[int(ButtonID::MRIGHT)]);
 	_touchScrollX.init(_touchpads[0].buttons.find(ButtonID::TLEFT)->second, _touchpads[0].buttons.find(ButtonID::TRIGHT)->second);
 	_touchScrollY.init(_touchpads[0].buttons.find(ButtonID::TUP)->second, _touchpads[0].buttons.find(ButtonID::TDOWN)->second);
-	updateGridSize();
+	updateGridSize(grid_mappings.size());
 	_touchpads[0].scroll.init(_touchpads[0].buttons.find(ButtonID::TLEFT)->second, _touchpads[0].buttons.find(ButtonID::TRIGHT)->second);
 	_touchpads[0].verticalScroll.init(_touchpads[0].buttons.find(ButtonID::TUP)->second, _touchpads[0].buttons.find(ButtonID::TDOWN)->second);
 }
@@ -99,7 +101,7 @@ void JoyShock::sendRumble(int smallRumble, int bigRumble)
 	if (SettingsManager::getV<Switch>(SettingID::RUMBLE)->value() == Switch::ON)
 	{
 		// DEBUG_LOG << "Rumbling at " << smallRumble << " and " << bigRumble << '\n';
-		jsl->SetRumble(_handle, smallRumble, bigRumble);
+		jsl.load()->SetRumble(_handle, smallRumble, bigRumble);
 	}
 }
 
@@ -130,22 +132,49 @@ void JoyShock::onVirtualControllerNotification(uint8_t largeMotor, uint8_t small
 	// auto diff = ((float)chrono::duration_cast<chrono::microseconds>(now - last_call).count()) / 1000000.0f;
 	// last_call = now;
 	// COUT_INFO << "Time since last vigem rumble is " << diff << " us\n";
-	lock_guard guard(_context->callback_lock);
-	switch (_controllerType)
+	// Called from the virtual controller's thread. Joy-Con pairs share the context, which can outlive either of
+	// them, so the controller is looked up again when the change runs.
+	_context->pendingChanges.publish([handle = _handle, largeMotor, smallMotor, indicator]
+	  {
+		  auto found = handle_to_joyshock.find(handle);
+		  if (found == handle_to_joyshock.end())
+		  {
+			  return;
+		  }
+		  JoyShock &js = *found->second;
+		  switch (js._controllerType)
+		  {
+		  case JS_TYPE_DS4:
+		  case JS_TYPE_DS:
+			  jsl.load()->SetLightColour(js._handle, js._light_bar.raw);
+			  break;
+		  default:
+			  jsl.load()->SetPlayerNumber(js._handle, indicator.led);
+			  break;
+		  }
+		  js.sendRumble(smallMotor << 8, largeMotor << 8);
+	  });
+}
+
+void JoyShock::validateResolvedSettings()
+{
+	auto generation = JSMVariableBase::generation();
+	if (_resolved.settingsGeneration != generation || _resolved.chordStackVersion != _context->chordStackVersion)
 	{
-	case JS_TYPE_DS4:
-	case JS_TYPE_DS:
-		jsl->SetLightColour(_handle, _light_bar.raw);
-		break;
-	default:
-		jsl->SetPlayerNumber(_handle, indicator.led);
-		break;
+		_resolved.hasFloat.reset();
+		_resolved.hasEnum.reset();
+		_resolved.hasFloatXY.reset();
+		_resolved.settingsGeneration = generation;
+		_resolved.chordStackVersion = _context->chordStackVersion;
 	}
-	sendRumble(smallMotor << 8, largeMotor << 8);
 }
 
 float JoyShock::getSetting(SettingID index)
 {
+	validateResolvedSettings();
+	if (size_t(index) < SETTINGS_COUNT && _resolved.hasFloat[size_t(index)])
+		return _resolved.floats[size_t(index)];
+
 	// Look at active chord mappings starting with the latest activates chord
 	for (auto activeChord = _context->chordStack.begin(); activeChord != _context->chordStack.end(); activeChord++)
 	{
@@ -170,7 +199,14 @@ float JoyShock::getSetting(SettingID index)
 				opt = float(*axisSign);
 		}
 		if (opt)
+		{
+			if (size_t(index) < SETTINGS_COUNT)
+			{
+				_resolved.floats[size_t(index)] = *opt;
+				_resolved.hasFloat.set(size_t(index));
+			}
 			return *opt;
+		}
 	}
 
 	stringstream message;
@@ -181,12 +217,23 @@ float JoyShock::getSetting(SettingID index)
 template<>
 FloatXY JoyShock::getSetting<FloatXY>(SettingID index)
 {
+	validateResolvedSettings();
+	if (size_t(index) < SETTINGS_COUNT && _resolved.hasFloatXY[size_t(index)])
+		return _resolved.floatXYs[size_t(index)];
+
 	// Look at active chord mappings starting with the latest activates chord
 	for (auto activeChord = _context->chordStack.begin(); activeChord != _context->chordStack.end(); activeChord++)
 	{
 		optional<FloatXY> opt = getSettingAtChord<FloatXY>(index, *activeChord);
 		if (opt)
+		{
+			if (size_t(index) < SETTINGS_COUNT)
+			{
+				_resolved.floatXYs[size_t(index)] = *opt;
+				_resolved.hasFloatXY.set(size_t(index));
+			}
 			return *opt;
+		}
 	} // Check next Chord
 
 	stringstream ss;
@@ -267,7 +314,7 @@ DigitalButton *JoyShock::getMatchingSimBtn(ButtonID index)
 	  int(index) - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &grid_mappings[int(index) - FIRST_TOUCH_BUTTON] :
 	                                                           nullptr;
 	DigitalButton *button1 = int(index) < mappings.size()    ? &_buttons[int(index)] :
-	  int(index) - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &_gridButtons[int(index) - FIRST_TOUCH_BUTTON] :
+	  int(index) - FIRST_TOUCH_BUTTON < _gridButtons.size()  ? &_gridButtons[int(index) - FIRST_TOUCH_BUTTON] :
 	                                                           nullptr;
 	if (!mapping)
 	{
@@ -286,7 +333,7 @@ DigitalButton *JoyShock::getMatchingSimBtn(ButtonID index)
 		for (auto iter = mapping->getSimMapIter() ; iter ; ++iter)
 		{
 			DigitalButton *button2 = int(iter->first) < mappings.size()      ? &_buttons[int(iter->first)] :
-			  int(iter->first) - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &_gridButtons[int(iter->first) - FIRST_TOUCH_BUTTON] :
+			  int(iter->first) - FIRST_TOUCH_BUTTON < _gridButtons.size()  ? &_gridButtons[int(iter->first) - FIRST_TOUCH_BUTTON] :
 																				nullptr;
 
 			if (!button2)
@@ -308,7 +355,7 @@ DigitalButton *JoyShock::getMatchingDiagBtn(ButtonID index, optional<MapIterator
 	  int(index) - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &grid_mappings[int(index) - FIRST_TOUCH_BUTTON] :
 	                                                           nullptr;
 	DigitalButton *button1 = int(index) < mappings.size()    ? &_buttons[int(index)] :
-	  int(index) - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &_gridButtons[int(index) - FIRST_TOUCH_BUTTON] :
+	  int(index) - FIRST_TOUCH_BUTTON < _gridButtons.size()  ? &_gridButtons[int(index) - FIRST_TOUCH_BUTTON] :
 	                                                           nullptr;
 	if (!mapping)
 	{
@@ -327,7 +374,7 @@ DigitalButton *JoyShock::getMatchingDiagBtn(ButtonID index, optional<MapIterator
 		{
 			int i = int((*iter)->first);
 			DigitalButton *button2 = i < mappings.size()    ? &_buttons[i] :
-			  i - FIRST_TOUCH_BUTTON < grid_mappings.size() ? &_gridButtons[i - FIRST_TOUCH_BUTTON] :
+			  i - FIRST_TOUCH_BUTTON < _gridButtons.size()  ? &_gridButtons[i - FIRST_TOUCH_BUTTON] :
 			                                                                 nullptr;
 
 			if (!button2)
@@ -345,19 +392,11 @@ DigitalButton *JoyShock::getMatchingDiagBtn(ButtonID index, optional<MapIterator
 
 void JoyShock::resetSmoothSample()
 {
-	_frontSample = 0;
-	for (int i = 0; i < NUM_SAMPLES; i++)
-	{
-		_flickSamples[i] = 0.0;
-	}
+	_flickSamples.reset();
 }
 
 float JoyShock::getSmoothedStickRotation(float value, float bottomThreshold, float topThreshold, int maxSamples)
 {
-	// which sample in the circular smoothing buffer do we want to write over?
-	_frontSample--;
-	if (_frontSample < 0)
-		_frontSample = NUM_SAMPLES - 1;
 	// if this input is bigger than the top threshold, it'll all be consumed immediately; 0 gets put into the smoothing buffer. If it's below the bottomThreshold, it'll all be put in the smoothing buffer
 	float length = abs(value);
 	float immediateFactor;
@@ -379,27 +418,15 @@ float JoyShock::getSmoothedStickRotation(float value, float bottomThreshold, flo
 		immediateFactor = 1.0f;
 	}
 	float smoothFactor = 1.0f - immediateFactor;
-	// now we can push the smooth sample (or as much of it as we want smoothed)
-	float frontSample = _flickSamples[_frontSample] = value * smoothFactor;
-	// and now calculate smoothed result
-	float result = frontSample / maxSamples;
-	for (int i = 1; i < maxSamples; i++)
-	{
-		int rotatedIndex = (_frontSample + i) % NUM_SAMPLES;
-		frontSample = _flickSamples[rotatedIndex];
-		result += frontSample / maxSamples;
-	}
+	// push the smooth sample (or as much of it as we want smoothed) and get the smoothed result
+	float result = _flickSamples.push(value * smoothFactor, maxSamples);
 	// finally, add immediate portion
 	return result + value * immediateFactor;
 }
 
-void JoyShock::getSmoothedGyro(float x, float y, float length, float bottomThreshold, float topThreshold, int maxSamples, float &outX, float &outY)
+void JoyShock::getSmoothedGyro(float x, float y, float length, float bottomThreshold, float topThreshold, GyroSmoothKernel kernel, float smoothTime, float beta, float deltaTime, float &outX, float &outY)
 {
 	// this is basically the same as we use for smoothing flick-stick rotations, but because this deals in vectors, it's a slightly different function. Not worth abstracting until it'll be used in more ways
-	// which item in the circular smoothing buffer will we write over?
-	_frontGyroSample--;
-	if (_frontGyroSample < 0)
-		_frontGyroSample = MAX_GYRO_SAMPLES - 1;
 	float immediateFactor;
 	if (topThreshold <= bottomThreshold)
 	{
@@ -419,17 +446,41 @@ void JoyShock::getSmoothedGyro(float x, float y, float length, float bottomThres
 		immediateFactor = 1.0f;
 	}
 	float smoothFactor = 1.0f - immediateFactor;
-	// now we can push the smooth sample (or as much of it as we want smoothed)
-	FloatXY frontSample = _gyroSamples[_frontGyroSample] = { x * smoothFactor, y * smoothFactor };
-	// and now calculate smoothed result
-	float xResult = frontSample.x() / maxSamples;
-	float yResult = frontSample.y() / maxSamples;
-	for (int i = 1; i < maxSamples; i++)
-	{
-		int rotatedIndex = (_frontGyroSample + i) % MAX_GYRO_SAMPLES;
-		frontSample = _gyroSamples[rotatedIndex];
-		xResult += frontSample.x() / maxSamples;
-		yResult += frontSample.y() / maxSamples;
+	if (kernel != _gyroKernel)
+	{
+		// don't let stale state from the previous kernel leak into the output
+		_gyroKernel = kernel;
+		_gyroSamplesX.reset();
+		_gyroSamplesY.reset();
+		_gyroExponentialX.reset();
+		_gyroExponentialY.reset();
+		_gyroOneEuroX.reset();
+		_gyroOneEuroY.reset();
+	}
+	// now we can smooth the smooth sample (or as much of it as we want smoothed).
+	// The exponential kernels use half the window as time constant, which gives them the same average delay.
+	float xResult, yResult;
+	switch (kernel)
+	{
+	case GyroSmoothKernel::EXPONENTIAL:
+		xResult = _gyroExponentialX.apply(x * smoothFactor, smoothTime / 2.f, deltaTime);
+		yResult = _gyroExponentialY.apply(y * smoothFactor, smoothTime / 2.f, deltaTime);
+		break;
+	case GyroSmoothKernel::ONE_EURO:
+	{
+		float minCutoff = 1.f / (float(M_PI) * smoothTime);
+		xResult = _gyroOneEuroX.apply(x * smoothFactor, minCutoff, beta, deltaTime);
+		yResult = _gyroOneEuroY.apply(y * smoothFactor, minCutoff, beta, deltaTime);
+		break;
+	}
+	default:
+	{
+		// need at least 1 sample
+		int maxSamples = max(1, int(smoothTime / deltaTime));
+		xResult = _gyroSamplesX.push(x * smoothFactor, maxSamples);
+		yResult = _gyroSamplesY.push(y * smoothFactor, maxSamples);
+		break;
+	}
 	}
 	// finally, add immediate portion
 	outX = xResult + x * immediateFactor;
@@ -794,12 +845,12 @@ bool JoyShock::processDeadZones(float &x, float &y, float innerDeadzone, float o
 	return false;
 }
 
-void JoyShock::updateGridSize()
+void JoyShock::updateGridSize(size_t count)
 {
-	while (_gridButtons.size() > grid_mappings.size())
+	while (_gridButtons.size() > count)
 		_gridButtons.pop_back();
 
-	for (size_t i = _gridButtons.size(); i < grid_mappings.size(); ++i)
+	for (size_t i = _gridButtons.size(); i < count; ++i)
 	{
 		JSMButton &map(grid_mappings[i]);
 		_gridButtons.push_back(DigitalButton(_context, map));
@@ -901,9 +952,22 @@ float JoyShock::handleFlickStick(float stickX, float stickY, Stick &stick, float
 					stickAngle = 0.0f;
 				}
 
-				stick.started_flick = chrono::steady_clock::now();
+				stick.started_flick = _timeNow;
 				stick.delta_flick = stickAngle;
 				stick.flick_percent_done = 0.0f;
+				stick.flick = FlickCurve(stick.started_flick, stickAngle, getSetting(SettingID::FLICK_TIME), getSetting(SettingID::FLICK_TIME_EXPONENT));
+				stick.flick_rotation_sent = 0.0f;
+				stick.flick_on_output_thread = false;
+				if (isMouse)
+				{
+					// With MOUSE_OUTPUT_RATE, the output thread reads the curve at its own rate rather than on the ticks
+					float countsPerRadian = getSetting(SettingID::REAL_WORLD_CALIBRATION) * -mouseCalibrationFactor / getSetting(SettingID::IN_GAME_SENS);
+					auto path = [curve = stick.flick, countsPerRadian](chrono::steady_clock::time_point now)
+					{
+						return pair{ curve.rotation(now) * countsPerRadian, 0.f };
+					};
+					stick.flick_on_output_thread = playMousePath(&stick, path, stick.flick.end());
+				}
 				resetSmoothSample();
 				stick.flick_rotation_counter = stickAngle; // track all rotation for this flick
 				COUT << "Flick: " << setprecision(3) << stickAngle * (180.0f / (float)M_PI) << " degrees\n";
@@ -958,29 +1022,16 @@ float JoyShock::handleFlickStick(float stickX, float stickY, Stick &stick, float
 	// do the flicking. this works very differently if it's mouse vs stick
 	if (isMouse)
 	{
-		float secondsSinceFlick = ((float)chrono::duration_cast<chrono::microseconds>(_timeNow - stick.started_flick).count()) / 1000000.0f;
-		float newPercent = secondsSinceFlick / getSetting(SettingID::FLICK_TIME);
-
-		// don't divide by zero
-		if (abs(stick.delta_flick) > 0.0f)
+		// The curve gives the same total rotation and easing at any tick time
+		stick.flick_percent_done = stick.flick.percentDone(_timeNow);
+		if (!stick.flick_on_output_thread)
 		{
-			newPercent = newPercent / pow(abs(stick.delta_flick) / M_PI, getSetting(SettingID::FLICK_TIME_EXPONENT));
+			float rotation = stick.flick.rotation(_timeNow);
+			float camSpeedChange = (rotation - stick.flick_rotation_sent) * getSetting(SettingID::REAL_WORLD_CALIBRATION) * -mouseCalibrationFactor / getSetting(SettingID::IN_GAME_SENS);
+			stick.flick_rotation_sent = rotation;
+			camSpeedX += camSpeedChange;
 		}
 
-		if (newPercent > 1.0f)
-			newPercent = 1.0f;
-		// warping towards 1.0
-		float oldShapedPercent = 1.0f - stick.flick_percent_done;
-		oldShapedPercent *= oldShapedPercent;
-		oldShapedPercent = 1.0f - oldShapedPercent;
-		// float oldShapedPercent = flick_percent_done;
-		stick.flick_percent_done = newPercent;
-		newPercent = 1.0f - newPercent;
-		newPercent *= newPercent;
-		newPercent = 1.0f - newPercent;
-		float camSpeedChange = (newPercent - oldShapedPercent) * stick.delta_flick * getSetting(SettingID::REAL_WORLD_CALIBRATION) * -mouseCalibrationFactor / getSetting(SettingID::IN_GAME_SENS);
-		camSpeedX += camSpeedChange;
-
 		return camSpeedX;
 	}
 	else
@@ -1116,7 +1167,7 @@ void JoyShock::processStick(float stickX, float stickY, Stick &stick, float mous
 		float mouseX = (rawX - rawLastX) * mouse_ring_radius;
 		float mouseY = (rawY - rawLastY) * -1 * mouse_ring_radius;
 		// do it!
-		moveMouse(mouseX, mouseY);
+		moveMouse(mouseX, mouseY, _mouseRemainder);
 	}
 	else if (stickMode == StickMode::MOUSE_RING)
 	{
@@ -1154,7 +1205,7 @@ void JoyShock::processStick(float stickX, float stickY, Stick &stick, float mous
 					lastAngle = lastAngle > 0 ? lastAngle - 360.f : lastAngle + 360.f;
 				}
 				// COUT << "Stick moved from " << lastAngle << " to " << angle; // << '\n';
-				stick.scroll.processScroll(angle - lastAngle, getSetting<FloatXY>(SettingID::SCROLL_SENS).x(), _timeNow);
+				stick.scroll.processScroll(angle - lastAngle, getSetting<FloatXY>(SettingID::SCROLL_SENS).x(), getSetting<Switch>(SettingID::HI_RES_SCROLL) == Switch::ON, _timeNow, _context->chordStack, _mouseRemainder);
 			}
 		}
 	}
@@ -1467,7 +1518,7 @@ void JoyShock::processStick(float stickX, float stickY, Stick &stick, float mous
 			if (returnDeadzone == 0.f)
 				stick.edgePushAmount = 0.f;
 		}
-		moveMouse(outputX, outputY);
+		moveMouse(outputX, outputY, _mouseRemainder);
 	}
 }
 
@@ -1493,7 +1544,7 @@ void JoyShock::handleTouchStickChange(TouchStick &ts, bool down, short movX, sho
 	ts.lastX = stickX;
 	ts.lastY = stickY;
 
-	moveMouse(camSpeedX * float(getSetting<AxisSignPair>(SettingID::TOUCH_STICK_AXIS).first), -camSpeedY * float(getSetting<AxisSignPair>(SettingID::TOUCH_STICK_AXIS).second));
+	moveMouse(camSpeedX * float(getSetting<AxisSignPair>(SettingID::TOUCH_STICK_AXIS).first), -camSpeedY * float(getSetting<AxisSignPair>(SettingID::TOUCH_STICK_AXIS).second), _mouseRemainder);
 
 	if (!down && ts._prevDown)
 	{
@@ -1,5 +1,6 @@
 #define JSL_WRAPPER_SOURCE
 #include "JslWrapper.h"
+#include <chrono>
 
 class JSlWrapperImpl : public JslWrapper
 {
@@ -39,6 +40,24 @@ public:
 		return JslGetIMUState(deviceId);
 	}
 
+	bool GetDeviceFrame(int deviceId, DeviceFrame &frame) override
+	{
+		// JSL gives unknown devices an empty state
+		JOY_SHOCK_STATE state = JslGetSimpleState(deviceId);
+		frame.buttons = state.buttons;
+		frame.leftX = state.stickLX;
+		frame.leftY = state.stickLY;
+		frame.rightX = state.stickRX;
+		frame.rightY = state.stickRY;
+		frame.leftTrigger = state.lTrigger;
+		frame.rightTrigger = state.rTrigger;
+		frame.imu = JslGetIMUState(deviceId);
+		frame.touch = JslGetTouchState(deviceId, false);
+		// JSL doesn't expose the report time
+		frame.timestamp = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		return true;
+	}
+
 	MOTION_STATE GetMotionState(int deviceId) override
 	{
 		return JslGetMotionState(deviceId);
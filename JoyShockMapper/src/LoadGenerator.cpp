@@ -0,0 +1,675 @@
+#include "LoadGenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+using namespace LoadGenerator;
+
+constexpr double TAU = 6.283185307179586;
+
+constexpr int DS4_BUTTONS = 0x03FFFF;
+constexpr int DS_BUTTONS = DS4_BUTTONS | JSMASK_MIC;
+constexpr int JOYCON_LEFT_BUTTONS = JSMASK_UP | JSMASK_DOWN | JSMASK_LEFT | JSMASK_RIGHT | JSMASK_MINUS | JSMASK_LCLICK |
+  JSMASK_L | JSMASK_ZL | JSMASK_CAPTURE | JSMASK_SL | JSMASK_SR;
+constexpr int JOYCON_RIGHT_BUTTONS = JSMASK_N | JSMASK_E | JSMASK_S | JSMASK_W | JSMASK_PLUS | JSMASK_RCLICK | JSMASK_R |
+  JSMASK_ZR | JSMASK_HOME | JSMASK_SL | JSMASK_SR;
+
+struct SyntheticDevice
+{
+	int controllerType = 0;
+	int splitType = JS_SPLIT_TYPE_FULL;
+	int vendorId = JS_VENDOR_UNKNOWN;
+	int productId = JS_PRODUCT_UNKNOWN;
+	std::vector<int> buttons; // Masks of the buttons the device has
+	double phase = 0.0;       // So that the devices don't all move together
+	std::mt19937 random;
+	uint64_t nextTick = 0; // The first tick not generated yet
+	float walk[6]{};       // Sticks and triggers of the random walk
+	DeviceFrame frame{};
+	TOUCH_STATE prevTouch{};
+};
+
+template<typename T>
+bool parseNumber(std::string_view text, T &value)
+{
+	auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parseOption(std::string_view option, Config &config)
+{
+	auto equal = option.find('=');
+	if (equal == std::string_view::npos)
+	{
+		return false;
+	}
+	auto key = option.substr(0, equal);
+	auto value = option.substr(equal + 1);
+	if (key == "TYPE")
+	{
+		if (value == "DS4")
+			config.controllerType = JS_TYPE_DS4;
+		else if (value == "DS")
+			config.controllerType = JS_TYPE_DS;
+		else if (value == "JOYCON")
+			config.controllerType = JS_TYPE_JOYCON_LEFT;
+		else if (value == "MIXED")
+			config.controllerType = 0;
+		else
+			return false;
+		return true;
+	}
+	if (key == "STICKS")
+	{
+		if (value == "NONE")
+			config.sticks = StickPattern::NONE;
+		else if (value == "CIRCLE")
+			config.sticks = StickPattern::CIRCLE;
+		else if (value == "SWEEP")
+			config.sticks = StickPattern::SWEEP;
+		else if (value == "RANDOM")
+			config.sticks = StickPattern::RANDOM;
+		else
+			return false;
+		return true;
+	}
+	if (key == "RATE")
+		return parseNumber(value, config.rate) && config.rate > 0.f;
+	if (key == "NOISE")
+		return parseNumber(value, config.gyroNoise) && config.gyroNoise >= 0.f;
+	if (key == "BUTTONS")
+		return parseNumber(value, config.buttonRate) && config.buttonRate >= 0.f;
+	if (key == "SEED")
+		return parseNumber(value, config.seed);
+	return false;
+}
+
+// -1 to 1 and back, once per period
+float triangle(double t)
+{
+	double x = t - std::floor(t);
+	return float(x < 0.5 ? 4.0 * x - 1.0 : 3.0 - 4.0 * x);
+}
+
+// All devices are generated and sent to the callbacks by one polling thread, so the getters are meant to be called
+// from the callbacks, like with the replay.
+class GeneratorInstance : public JslWrapper
+{
+public:
+	GeneratorInstance(const Config &config, std::function<void(const Stats &)> report)
+	  : _config(config)
+	  , _report(std::move(report))
+	{
+		_devices.resize(std::max(config.devices, 0));
+		for (size_t i = 0; i < _devices.size(); ++i)
+		{
+			auto &device = _devices[i];
+			int type = config.controllerType;
+			if (type == 0)
+			{
+				static constexpr int MIXED[] = { JS_TYPE_DS4, JS_TYPE_DS, JS_TYPE_JOYCON_LEFT, JS_TYPE_JOYCON_RIGHT };
+				type = MIXED[i % 4];
+			}
+			else if (type == JS_TYPE_JOYCON_LEFT && i % 2 == 1)
+			{
+				type = JS_TYPE_JOYCON_RIGHT;
+			}
+			device.controllerType = type;
+			int mask = 0;
+			switch (type)
+			{
+			case JS_TYPE_DS4:
+				device.vendorId = 0x054C;
+				device.productId = 0x09CC;
+				mask = DS4_BUTTONS;
+				break;
+			case JS_TYPE_DS:
+				device.vendorId = 0x054C;
+				device.productId = 0x0CE6;
+				mask = DS_BUTTONS;
+				break;
+			case JS_TYPE_JOYCON_LEFT:
+				device.splitType = JS_SPLIT_TYPE_LEFT;
+				device.vendorId = 0x057E;
+				device.productId = 0x2006;
+				mask = JOYCON_LEFT_BUTTONS;
+				break;
+			case JS_TYPE_JOYCON_RIGHT:
+				device.splitType = JS_SPLIT_TYPE_RIGHT;
+				device.vendorId = 0x057E;
+				device.productId = 0x2007;
+				mask = JOYCON_RIGHT_BUTTONS;
+				break;
+			}
+			for (int bit = 1; bit <= mask; bit <<= 1)
+			{
+				if (mask & bit)
+				{
+					device.buttons.push_back(bit);
+				}
+			}
+			device.random.seed(config.seed + uint32_t(i));
+			device.phase = double(i) / double(_devices.size());
+			device.frame.imu.accelY = 1.f;
+		}
+	}
+
+	~GeneratorInstance() override
+	{
+		stop();
+	}
+
+	bool IsLive() override
+	{
+		return false;
+	}
+
+	int ConnectDevices() override
+	{
+		return int(_devices.size());
+	}
+
+	int GetDeviceCount() override
+	{
+		return int(_devices.size());
+	}
+
+	// Handles are 1 to the number of devices
+	int GetConnectedDeviceHandles(int *deviceHandleArray, int size) override
+	{
+		int count = std::min(size, int(_devices.size()));
+		for (int i = 0; i < count; ++i)
+		{
+			deviceHandleArray[i] = i + 1;
+		}
+		return count;
+	}
+
+	void DisconnectAndDisposeAll() override
+	{
+		stop();
+		_callback = nullptr;
+		_touchCallback = nullptr;
+	}
+
+	JOY_SHOCK_STATE GetSimpleState(int deviceId) override
+	{
+		JOY_SHOCK_STATE state;
+		memset(&state, 0, sizeof(state));
+		if (auto *device = find(deviceId))
+		{
+			state.buttons = device->frame.buttons;
+			state.lTrigger = device->frame.leftTrigger;
+			state.rTrigger = device->frame.rightTrigger;
+			state.stickLX = device->frame.leftX;
+			state.stickLY = device->frame.leftY;
+			state.stickRX = device->frame.rightX;
+			state.stickRY = device->frame.rightY;
+		}
+		return state;
+	}
+
+	IMU_STATE GetIMUState(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->frame.imu : IMU_STATE();
+	}
+
+	bool GetDeviceFrame(int deviceId, DeviceFrame &frame) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		frame = device->frame;
+		return true;
+	}
+
+	MOTION_STATE GetMotionState(int deviceId) override
+	{
+		return MOTION_STATE();
+	}
+
+	TOUCH_STATE GetTouchState(int deviceId, bool previous = false) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return TOUCH_STATE();
+		}
+		return previous ? device->prevTouch : device->frame.touch;
+	}
+
+	bool GetTouchpadDimension(int deviceId, int &sizeX, int &sizeY) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		// Same as the SDL backend
+		bool hasTouchpad = device->controllerType == JS_TYPE_DS4 || device->controllerType == JS_TYPE_DS;
+		sizeX = hasTouchpad ? 1920 : 0;
+		sizeY = hasTouchpad ? 920 : 0;
+		return true;
+	}
+
+	int GetButtons(int deviceId) override
+	{
+		return GetSimpleState(deviceId).buttons;
+	}
+
+	float GetLeftX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLX;
+	}
+
+	float GetLeftY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLY;
+	}
+
+	float GetRightX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRX;
+	}
+
+	float GetRightY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRY;
+	}
+
+	float GetLeftTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).lTrigger;
+	}
+
+	float GetRightTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).rTrigger;
+	}
+
+	float GetGyroX(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroX;
+	}
+
+	float GetGyroY(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroY;
+	}
+
+	float GetGyroZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroZ;
+	}
+
+	float GetAccelX(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelX;
+	}
+
+	float GetAccelY(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelY;
+	}
+
+	float GetAccelZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelZ;
+	}
+
+	int GetTouchId(int deviceId, bool secondTouch = false) override
+	{
+		return secondTouch ? 1 : 0;
+	}
+
+	bool GetTouchDown(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Down : touch.t0Down;
+	}
+
+	float GetTouchX(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1X : touch.t0X;
+	}
+
+	float GetTouchY(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Y : touch.t0Y;
+	}
+
+	float GetStickStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetTriggerStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetPollRate(int deviceId) override
+	{
+		return find(deviceId) ? _config.rate : float();
+	}
+
+	void ResetContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void StartContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void PauseContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void GetCalibrationOffset(int deviceId, float &xOffset, float &yOffset, float &zOffset) override
+	{
+		xOffset = yOffset = zOffset = 0.f;
+	}
+
+	void SetCalibrationOffset(int deviceId, float xOffset, float yOffset, float zOffset) override
+	{
+	}
+
+	// Polling starts with the first callback
+	void SetCallback(void (*callback)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)) override
+	{
+		_callback = callback;
+		if (callback && !_poller.joinable())
+		{
+			_polling = true;
+			_poller = std::thread(&GeneratorInstance::poll, this);
+		}
+	}
+
+	void SetTouchCallback(void (*callback)(int, TOUCH_STATE, TOUCH_STATE, float)) override
+	{
+		_touchCallback = callback;
+	}
+
+	int GetControllerType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->controllerType : 0;
+	}
+
+	int GetControllerSplitType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->splitType : JS_SPLIT_TYPE_FULL;
+	}
+
+	int GetControllerVendor(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->vendorId : JS_VENDOR_UNKNOWN;
+	}
+
+	int GetControllerProduct(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->productId : JS_PRODUCT_UNKNOWN;
+	}
+
+	int GetControllerColour(int deviceId) override
+	{
+		return int();
+	}
+
+	// There is no device to send output to
+	void SetLightColour(int deviceId, int colour) override
+	{
+	}
+
+	void SetRumble(int deviceId, int smallRumble, int bigRumble) override
+	{
+	}
+
+	void SetPlayerNumber(int deviceId, int number) override
+	{
+	}
+
+	// For LoadGenerator::Generate
+	void generateAll(uint64_t tick)
+	{
+		for (auto &device : _devices)
+		{
+			generate(device, tick);
+		}
+	}
+
+private:
+	SyntheticDevice *find(int deviceId)
+	{
+		return deviceId >= 1 && deviceId <= int(_devices.size()) ? &_devices[deviceId - 1] : nullptr;
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard guard(_pollLock);
+			_polling = false;
+		}
+		_wake.notify_all();
+		if (_poller.joinable())
+		{
+			_poller.join();
+		}
+	}
+
+	// The input of a device only depends on the tick and the seed, so that runs can be compared. The random walk and
+	// the buttons carry over from one tick to the next, so the ticks that polling skipped are generated all the same.
+	void generate(SyntheticDevice &device, uint64_t tick)
+	{
+		while (device.nextTick <= tick)
+		{
+			step(device, device.nextTick++);
+		}
+	}
+
+	void step(SyntheticDevice &device, uint64_t tick)
+	{
+		double t = double(tick) / _config.rate + device.phase;
+		auto &frame = device.frame;
+		device.prevTouch = frame.touch;
+
+		std::normal_distribution<float> noise(0.f, 1.f);
+		frame.imu.gyroX = 20.f * float(std::sin(TAU * 0.25 * t)) + _config.gyroNoise * noise(device.random);
+		frame.imu.gyroY = 90.f * float(std::sin(TAU * 0.5 * t)) + _config.gyroNoise * noise(device.random);
+		frame.imu.gyroZ = _config.gyroNoise * noise(device.random);
+		// Accelerometers are noisy by about a hundredth of a g for each degree per second of gyro noise
+		frame.imu.accelX = 0.01f * _config.gyroNoise * noise(device.random);
+		frame.imu.accelY = 1.f + 0.01f * _config.gyroNoise * noise(device.random);
+		frame.imu.accelZ = 0.01f * _config.gyroNoise * noise(device.random);
+
+		float sticks[6]{}; // Left x and y, right x and y, left and right trigger
+		switch (_config.sticks)
+		{
+		case StickPattern::NONE:
+			break;
+		case StickPattern::CIRCLE:
+			sticks[0] = float(std::cos(TAU * t));
+			sticks[1] = float(-std::sin(TAU * t));
+			sticks[2] = float(std::cos(TAU * 0.5 * t));
+			sticks[3] = float(std::sin(TAU * 0.5 * t));
+			sticks[4] = 0.5f + 0.5f * triangle(0.5 * t);
+			sticks[5] = 0.5f - 0.5f * triangle(0.5 * t);
+			break;
+		case StickPattern::SWEEP:
+			for (int i = 0; i < 4; ++i)
+			{
+				sticks[i] = triangle(t + 0.25 * i);
+			}
+			sticks[4] = sticks[5] = 0.5f + 0.5f * triangle(t);
+			break;
+		case StickPattern::RANDOM:
+		{
+			std::uniform_real_distribution<float> step(-0.05f, 0.05f);
+			for (int i = 0; i < 6; ++i)
+			{
+				device.walk[i] = std::clamp(device.walk[i] + step(device.random), i < 4 ? -1.f : 0.f, 1.f);
+				sticks[i] = device.walk[i];
+			}
+			break;
+		}
+		}
+		bool hasLeft = device.splitType != JS_SPLIT_TYPE_RIGHT;
+		bool hasRight = device.splitType != JS_SPLIT_TYPE_LEFT;
+		frame.leftX = hasLeft ? sticks[0] : 0.f;
+		frame.leftY = hasLeft ? sticks[1] : 0.f;
+		frame.rightX = hasRight ? sticks[2] : 0.f;
+		frame.rightY = hasRight ? sticks[3] : 0.f;
+		frame.leftTrigger = hasLeft ? sticks[4] : 0.f;
+		frame.rightTrigger = hasRight ? sticks[5] : 0.f;
+
+		if (_config.buttonRate > 0.f && !device.buttons.empty())
+		{
+			std::uniform_real_distribution<float> chance(0.f, 1.f);
+			// More than one change per report when the storm is faster than the report rate
+			for (float expected = _config.buttonRate / _config.rate; expected > 0.f; expected -= 1.f)
+			{
+				if (expected >= 1.f || chance(device.random) < expected)
+				{
+					std::uniform_int_distribution<size_t> pick(0, device.buttons.size() - 1);
+					frame.buttons ^= device.buttons[pick(device.random)];
+				}
+			}
+		}
+		frame.timestamp = uint64_t(double(tick) * 1e9 / _config.rate);
+	}
+
+	void poll()
+	{
+		using clock = std::chrono::steady_clock;
+		auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / _config.rate));
+		float deltaTime = 1.f / _config.rate;
+		auto next = clock::now();
+		auto reportAt = next + std::chrono::seconds(1);
+		uint64_t tick = 0;
+		Stats stats;
+		double totalMs = 0.0;
+		while (_polling)
+		{
+			{
+				std::unique_lock lock(_pollLock);
+				if (_wake.wait_until(lock, next, [this]() { return !_polling; }))
+				{
+					break;
+				}
+			}
+			auto begin = clock::now();
+			for (size_t i = 0; i < _devices.size(); ++i)
+			{
+				auto &device = _devices[i];
+				int handle = int(i) + 1;
+				generate(device, tick);
+				if (auto callback = _callback.load())
+				{
+					JOY_SHOCK_STATE state = GetSimpleState(handle);
+					callback(handle, state, state, device.frame.imu, device.frame.imu, deltaTime);
+				}
+				if (auto touchCallback = _touchCallback.load())
+				{
+					touchCallback(handle, device.frame.touch, device.prevTouch, deltaTime);
+				}
+			}
+			auto end = clock::now();
+
+			double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+			++stats.ticks;
+			totalMs += ms;
+			stats.worstTickMs = std::max(stats.worstTickMs, ms);
+			next += period;
+			++tick;
+			if (end > next)
+			{
+				// Skip the reports that are already late rather than sending them in a burst
+				++stats.overruns;
+				auto late = (end - next) / period + 1;
+				next += late * period;
+				tick += late;
+			}
+			if (end >= reportAt)
+			{
+				stats.meanTickMs = totalMs / double(stats.ticks);
+				if (_report)
+				{
+					_report(stats);
+				}
+				stats = Stats();
+				totalMs = 0.0;
+				reportAt += std::chrono::seconds(1);
+			}
+		}
+	}
+
+	Config _config;
+	std::function<void(const Stats &)> _report;
+	std::vector<SyntheticDevice> _devices;
+
+	std::atomic<void (*)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)> _callback = nullptr;
+	std::atomic<void (*)(int, TOUCH_STATE, TOUCH_STATE, float)> _touchCallback = nullptr;
+	std::atomic_bool _polling = false;
+	std::mutex _pollLock;
+	std::condition_variable _wake;
+	std::thread _poller;
+};
+
+} // namespace
+
+namespace LoadGenerator
+{
+
+std::optional<Config> ParseArguments(const std::vector<std::string> &arguments)
+{
+	auto flag = std::find(arguments.begin(), arguments.end(), "--synthetic");
+	if (flag == arguments.end())
+	{
+		return std::nullopt;
+	}
+	Config config;
+	if (flag + 1 == arguments.end() || !parseNumber(std::string_view(*(flag + 1)), config.devices) || config.devices <= 0)
+	{
+		return Config();
+	}
+	// Options follow the count. Anything else is left for the rest of the command line, like config files.
+	for (auto arg = flag + 2; arg != arguments.end() && !arg->starts_with("--"); ++arg)
+	{
+		if (arg->find('=') != std::string::npos && !parseOption(*arg, config))
+		{
+			return Config();
+		}
+	}
+	return config;
+}
+
+JslWrapper *New(const Config &config, std::function<void(const Stats &)> report)
+{
+	return new GeneratorInstance(config, std::move(report));
+}
+
+void Generate(JslWrapper *generator, uint64_t tick)
+{
+	static_cast<GeneratorInstance *>(generator)->generateAll(tick);
+}
+
+} // namespace LoadGenerator
@@ -1,6 +1,6 @@
 #include "Mapping.h"
 #include "InputHelpers.h"
-#include <regex>
+#include "ConfigParser.h"
 #include <cstring>
 #include <atomic>
 
@@ -18,32 +18,31 @@ istream &operator>>(istream &in, Mapping &mapping)
 	string valueName(128, '\0');
 	in.getline(&valueName[0], valueName.size());
 	valueName.resize(strlen(valueName.c_str()));
-	smatch results;
+	ConfigParser::MappingToken token;
 	int count = 0;
 
 	mapping._command = valueName;
-	static constexpr string_view rgx = R"(\s*([!\^-]?)((\".*?\")|\w*[0-9A-Z]|\W)([\\\/+'_]?)\s*(.*))";
-	while (regex_match(valueName, results, regex(rgx.data())) && !results[0].str().empty())
+	while (ConfigParser::Active::nextMappingToken(valueName, token))
 	{
 		Mapping::ActionModifier actMod =
-		  results[1].str().empty()   ? Mapping::ActionModifier::None :
-		  results[1].str()[0] == '!' ? Mapping::ActionModifier::Instant :
-		  results[1].str()[0] == '^' ? Mapping::ActionModifier::Toggle :
-		  results[1].str()[0] == '-' ? Mapping::ActionModifier::Release :
-		                               Mapping::ActionModifier::INVALID;
+		  token.action == '\0' ? Mapping::ActionModifier::None :
+		  token.action == '!'  ? Mapping::ActionModifier::Instant :
+		  token.action == '^'  ? Mapping::ActionModifier::Toggle :
+		  token.action == '-'  ? Mapping::ActionModifier::Release :
+		                         Mapping::ActionModifier::INVALID;
 
-		string keyStr(results[2]);
+		string keyStr(token.key);
 
 		Mapping::EventModifier evtMod =
-		  results[4].str().empty()    ? Mapping::EventModifier::Auto :
-		  results[4].str()[0] == '\\' ? Mapping::EventModifier::StartPress :
-		  results[4].str()[0] == '+'  ? Mapping::EventModifier::TurboPress :
-		  results[4].str()[0] == '/'  ? Mapping::EventModifier::ReleasePress :
-		  results[4].str()[0] == '\'' ? Mapping::EventModifier::TapPress :
-		  results[4].str()[0] == '_'  ? Mapping::EventModifier::HoldPress :
-		                                Mapping::EventModifier::INVALID;
+		  token.event == '\0' ? Mapping::EventModifier::Auto :
+		  token.event == '\\' ? Mapping::EventModifier::StartPress :
+		  token.event == '+'  ? Mapping::EventModifier::TurboPress :
+		  token.event == '/'  ? Mapping::EventModifier::ReleasePress :
+		  token.event == '\'' ? Mapping::EventModifier::TapPress :
+		  token.event == '_'  ? Mapping::EventModifier::HoldPress :
+		                        Mapping::EventModifier::INVALID;
 
-		string leftovers(results[5]);
+		string leftovers(token.rest);
 
 		KeyCode key(keyStr);
 		if (evtMod == Mapping::EventModifier::Auto)
@@ -151,6 +150,8 @@ bool Mapping::AddMapping(KeyCode key, EventModifier evtMod, ActionModifier actMo
 	{
 		return false;
 	}
+	bool onlyKey = _eventMapping.empty() && evtMod == EventModifier::StartPress && actMod == ActionModifier::None;
+	_wheelNotch = !onlyKey ? 0 : key.code == V_WHEEL_UP ? 1 : key.code == V_WHEEL_DOWN ? -1 : 0;
 	if (key.code == CALIBRATE)
 	{
 		apply = bind(&EventActionIf::StartCalibration, placeholders::_1);
@@ -162,6 +163,7 @@ bool Mapping::AddMapping(KeyCode key, EventModifier evtMod, ActionModifier actMo
 		extern std::atomic_bool g_hasGyroOnAllBinding;
 		if (key.code == GYRO_ON_ALL_BIND)
 		{
+			_hasGyroOnAll = true;
 			g_hasGyroOnAllBinding.store(true);
 		}
 		apply = bind(&EventActionIf::ApplyGyroAction, placeholders::_1, key);
@@ -315,6 +317,15 @@ bool Mapping::AppendToCommand(KeyCode key, EventModifier evtMod, ActionModifier
 	return true;
 }
 
+void Mapping::flagGyroOnAll() const
+{
+	if (_hasGyroOnAll)
+	{
+		extern std::atomic_bool g_hasGyroOnAllBinding;
+		g_hasGyroOnAllBinding.store(true);
+	}
+}
+
 void Mapping::RunBothActions(EventActionIf *btn, EventActionIf::Callback action1, EventActionIf::Callback action2)
 {
 	if (action1)
@@ -0,0 +1,83 @@
+#include "InputHelpers.h"
+#include "SettingsManager.h"
+
+// Relative mouse movement is the same on every platform up to sendMouseMove
+
+// Off until MOUSE_OUTPUT_RATE is set. Made on first use, so it stops before the platform's output is destroyed.
+static MouseScheduler &mouseScheduler()
+{
+	static MouseScheduler scheduler{ sendMouseMove };
+	return scheduler;
+}
+
+void setMouseOutputRate(float hz)
+{
+	mouseScheduler().setRate(hz);
+}
+
+bool playMousePath(const void *source, MouseScheduler::Path path, MouseScheduler::Clock::time_point until)
+{
+	if (getOutputSink() || !mouseScheduler().running())
+	{
+		return false;
+	}
+	auto dpiMultiplier = SettingsManager::getV<float>(SettingID::MOUSE_DPI_MULTIPLIER)->value();
+	mouseScheduler().play(
+	  source, [path = std::move(path), dpiMultiplier](MouseScheduler::Clock::time_point now)
+	  {
+		  auto [x, y] = path(now);
+		  return std::pair{ x * dpiMultiplier, y * dpiMultiplier };
+	  },
+	  until);
+	return true;
+}
+
+void moveMouse(float x, float y, MouseRemainder &remainder)
+{
+	auto dpiMultiplier = SettingsManager::getV<float>(SettingID::MOUSE_DPI_MULTIPLIER)->value();
+	auto sink = getOutputSink();
+	if (!sink && mouseScheduler().running())
+	{
+		// The scheduler keeps the remainder of each controller from here on
+		mouseScheduler().submit(&remainder, x * dpiMultiplier, y * dpiMultiplier);
+		return;
+	}
+	remainder.x += x * dpiMultiplier;
+	remainder.y += y * dpiMultiplier;
+
+	int applicableX = (int)remainder.x;
+	int applicableY = (int)remainder.y;
+
+	remainder.x -= applicableX;
+	remainder.y -= applicableY;
+	if (sink)
+	{
+		sink->mouseMove(applicableX, applicableY);
+		return;
+	}
+
+	sendMouseMove(applicableX, applicableY);
+}
+
+void scrollMouse(float notchesX, float notchesY, MouseRemainder &remainder)
+{
+	remainder.wheelX += notchesX * WHEEL_HI_RES_PER_NOTCH;
+	remainder.wheelY += notchesY * WHEEL_HI_RES_PER_NOTCH;
+
+	int applicableX = (int)remainder.wheelX;
+	int applicableY = (int)remainder.wheelY;
+	if (applicableX == 0 && applicableY == 0)
+	{
+		return;
+	}
+
+	remainder.wheelX -= applicableX;
+	remainder.wheelY -= applicableY;
+	if (auto sink = getOutputSink())
+	{
+		sink->mouseScroll(applicableX, applicableY);
+		return;
+	}
+
+	sendMouseScroll(applicableX, applicableY);
+}
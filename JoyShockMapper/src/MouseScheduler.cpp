@@ -0,0 +1,189 @@
+#include "MouseScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// A tick can't spread its movement for longer than this, so that a source that stops still lands its movement soon
+constexpr std::chrono::milliseconds kMaxSpread{ 100 };
+// Sources without movement for this long are forgotten
+constexpr std::chrono::seconds kIdleSource{ 1 };
+// How fast the usual interval follows the ticks
+constexpr float kIntervalRate = 0.2f;
+// Spreading splits the movement into many float shares. A remainder this close to a whole count is that count.
+constexpr float kCountSnap = 1e-3f;
+
+int wholeCounts(float remainder)
+{
+	return int(remainder + std::copysign(kCountSnap, remainder));
+}
+} // namespace
+
+MouseScheduler::MouseScheduler(Send send)
+  : _send(std::move(send))
+{
+}
+
+MouseScheduler::~MouseScheduler()
+{
+	setRate(0.f);
+}
+
+void MouseScheduler::setRate(float hz)
+{
+	float previous = _rate.exchange(std::max(hz, 0.f));
+	if (hz > 0.f && previous <= 0.f)
+	{
+		if (_thread.joinable())
+		{
+			_thread.join();
+		}
+		_thread = std::thread(&MouseScheduler::run, this);
+	}
+	else if (hz <= 0.f && previous > 0.f)
+	{
+		_wake.notify_all();
+		if (_thread.joinable())
+		{
+			_thread.join();
+		}
+		// Don't lose what was still being spread
+		auto [x, y] = step(Clock::time_point::max());
+		if (x != 0 || y != 0)
+		{
+			_send(x, y);
+		}
+	}
+}
+
+MouseScheduler::Clock::duration MouseScheduler::period() const
+{
+	float rate = _rate.load();
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / std::max(rate, 1.f)));
+}
+
+void MouseScheduler::submit(const void *source, float x, float y, Clock::time_point now)
+{
+	std::lock_guard guard(_lock);
+	auto [found, added] = _sources.try_emplace(source);
+	Source &state = found->second;
+	auto gap = now - state.lastSubmit;
+	if (added || state.ticks == 0 || gap > kMaxSpread)
+	{
+		// New or moving again: nothing to go by until the next tick
+		state.ticks = 0;
+		state.interval = period();
+	}
+	else if (state.ticks == 1)
+	{
+		state.interval = gap;
+	}
+	else
+	{
+		state.interval += std::chrono::duration_cast<Clock::duration>((gap - state.interval) * kIntervalRate);
+	}
+	state.interval = std::min<Clock::duration>(state.interval, kMaxSpread);
+	++state.ticks;
+	state.lastSubmit = now;
+	// Whatever is left from the previous tick is spread along with this one
+	state.pendingX += x;
+	state.pendingY += y;
+	state.spreadFrom = now;
+	state.spreadUntil = now + state.interval;
+}
+
+void MouseScheduler::play(const void *source, Path path, Clock::time_point until)
+{
+	std::lock_guard guard(_lock);
+	Source &state = _sources[source];
+	state.path = std::move(path);
+	state.pathUntil = until;
+	state.pathX = 0.f;
+	state.pathY = 0.f;
+}
+
+std::pair<int, int> MouseScheduler::step(Clock::time_point now)
+{
+	std::lock_guard guard(_lock);
+	int totalX = 0;
+	int totalY = 0;
+	for (auto iter = _sources.begin(); iter != _sources.end();)
+	{
+		Source &state = iter->second;
+		bool moving = false;
+		if (state.pendingX != 0.f || state.pendingY != 0.f)
+		{
+			float share = 1.f;
+			if (now < state.spreadUntil)
+			{
+				auto elapsed = std::max(now - state.spreadFrom, Clock::duration::zero());
+				share = float(elapsed.count()) / float((state.spreadUntil - state.spreadFrom).count());
+				state.spreadFrom = std::max(now, state.spreadFrom);
+			}
+			float takeX = state.pendingX * share;
+			float takeY = state.pendingY * share;
+			state.pendingX -= takeX;
+			state.pendingY -= takeY;
+			state.remainderX += takeX;
+			state.remainderY += takeY;
+			moving = true;
+		}
+		if (state.path)
+		{
+			auto [x, y] = state.path(std::min(now, state.pathUntil));
+			state.remainderX += x - state.pathX;
+			state.remainderY += y - state.pathY;
+			state.pathX = x;
+			state.pathY = y;
+			if (now >= state.pathUntil)
+			{
+				state.path = nullptr;
+			}
+			state.lastSubmit = std::max(state.lastSubmit, std::min(now, state.pathUntil));
+			moving = true;
+		}
+		if (moving)
+		{
+			int countX = wholeCounts(state.remainderX);
+			int countY = wholeCounts(state.remainderY);
+			state.remainderX -= countX;
+			state.remainderY -= countY;
+			totalX += countX;
+			totalY += countY;
+		}
+		else if (now != Clock::time_point::max() && now - state.lastSubmit > kIdleSource)
+		{
+			iter = _sources.erase(iter);
+			continue;
+		}
+		++iter;
+	}
+	return { totalX, totalY };
+}
+
+void MouseScheduler::run()
+{
+	auto next = Clock::now();
+	std::unique_lock waitLock(_lock, std::defer_lock);
+	while (running())
+	{
+		next += period();
+		auto now = Clock::now();
+		if (next < now)
+		{
+			next = now; // Fell behind: don't try to catch up with a burst
+		}
+		waitLock.lock();
+		_wake.wait_until(waitLock, next, [this] { return !running(); });
+		waitLock.unlock();
+		if (!running())
+		{
+			break;
+		}
+		auto [x, y] = step(Clock::now());
+		if (x != 0 || y != 0)
+		{
+			_send(x, y);
+		}
+	}
+}
@@ -0,0 +1,333 @@
+#include "OfflineRender.h"
+#include "AllocationCounter.h"
+#include "Gamepad.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+namespace
+{
+
+using namespace OfflineRender;
+
+// Virtual controller that reports its state to the sink instead of a driver
+class RenderedGamepad : public Gamepad
+{
+public:
+	RenderedGamepad(Sink &sink, ControllerScheme scheme)
+	  : _sink(sink)
+	  , _scheme(scheme)
+	{
+	}
+
+	bool isInitialized(string *errorMsg = nullptr) const override
+	{
+		return true;
+	}
+
+	void setButton(KeyCode btn, bool pressed) override
+	{
+		_sink.write("PAD_BUTTON", { float(btn.code), pressed ? 1.f : 0.f });
+	}
+
+	void setLeftStick(float x, float y) override
+	{
+		_state[0] = x;
+		_state[1] = y;
+	}
+
+	void setRightStick(float x, float y) override
+	{
+		_state[2] = x;
+		_state[3] = y;
+	}
+
+	void setStick(float x, float y, bool isLeft) override
+	{
+		isLeft ? setLeftStick(x, y) : setRightStick(x, y);
+	}
+
+	void setLeftTrigger(float value) override
+	{
+		_state[4] = value;
+	}
+
+	void setRightTrigger(float value) override
+	{
+		_state[5] = value;
+	}
+
+	void setGyro(TimePoint now, float accelX, float accelY, float accelZ, float gyroX, float gyroY, float gyroZ) override
+	{
+	}
+
+	void setTouchState(optional<FloatXY> press1, optional<FloatXY> press2) override
+	{
+	}
+
+	void update() override
+	{
+		if (_state != _sent)
+		{
+			_sink.write("PAD", { _state[0], _state[1], _state[2], _state[3], _state[4], _state[5] });
+			_sent = _state;
+		}
+	}
+
+	ControllerScheme getType() const override
+	{
+		return _scheme;
+	}
+
+private:
+	Sink &_sink;
+	ControllerScheme _scheme;
+	array<float, 6> _state{};
+	array<float, 6> _sent{};
+};
+
+#ifdef _WIN32
+// Converted the way the child opens the narrow path, rather than byte by byte
+wstring quoted(const string &arg)
+{
+	return L"\"" + filesystem::path(arg).wstring() + L"\"";
+}
+#endif
+
+} // namespace
+
+namespace OfflineRender
+{
+
+optional<Job> ParseArguments(const vector<string> &arguments)
+{
+	auto flag = find(arguments.begin(), arguments.end(), "--benchmark");
+	if (flag != arguments.end())
+	{
+		Job job;
+		job.benchmark = true;
+		if (distance(flag, arguments.end()) == 3)
+		{
+			job.recording = *(flag + 1);
+			job.configs.push_back(*(flag + 2));
+		}
+		return job;
+	}
+	flag = find(arguments.begin(), arguments.end(), "--render");
+	if (flag == arguments.end())
+	{
+		return nullopt;
+	}
+	Job job;
+	if (distance(flag, arguments.end()) >= 4)
+	{
+		job.recording = *(flag + 1);
+		job.outputFolder = *(flag + 2);
+		job.configs.assign(flag + 3, arguments.end());
+	}
+	return job;
+}
+
+string OutputPath(const Job &job, const string &config)
+{
+	return (filesystem::path(job.outputFolder) / filesystem::path(config).stem()).string() + ".txt";
+}
+
+int RunBatch(const Job &job)
+{
+	error_code error;
+	filesystem::create_directories(job.outputFolder, error);
+
+	size_t parallel = max(1u, thread::hardware_concurrency());
+	int failures = 0;
+	size_t next = 0;
+#ifdef _WIN32
+	wstring executable(MAX_PATH, L'\0');
+	executable.resize(GetModuleFileNameW(nullptr, executable.data(), DWORD(executable.size())));
+	vector<HANDLE> running;
+	while (next < job.configs.size() || !running.empty())
+	{
+		while (next < job.configs.size() && running.size() < min(parallel, size_t(MAXIMUM_WAIT_OBJECTS)))
+		{
+			wstring commandLine = L"\"" + executable + L"\" --render " + quoted(job.recording) + L" " +
+			  quoted(job.outputFolder) + L" " + quoted(job.configs[next]);
+			STARTUPINFOW startup{ sizeof(startup) };
+			PROCESS_INFORMATION process;
+			if (CreateProcessW(executable.c_str(), commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process))
+			{
+				CloseHandle(process.hThread);
+				running.push_back(process.hProcess);
+			}
+			else
+			{
+				CERR << "Cannot start the render of " << job.configs[next] << '\n';
+				++failures;
+			}
+			++next;
+		}
+		if (running.empty())
+		{
+			break;
+		}
+		DWORD index = WaitForMultipleObjects(DWORD(running.size()), running.data(), FALSE, INFINITE) - WAIT_OBJECT_0;
+		if (index >= running.size())
+		{
+			break;
+		}
+		DWORD exitCode = 1;
+		GetExitCodeProcess(running[index], &exitCode);
+		failures += exitCode != 0;
+		CloseHandle(running[index]);
+		running.erase(running.begin() + index);
+	}
+#else
+	// Don't rely on argv[0] or PATH to find ourselves
+	const char *executable = "/proc/self/exe";
+	size_t running = 0;
+	while (next < job.configs.size() || running > 0)
+	{
+		while (next < job.configs.size() && running < parallel)
+		{
+			array<const char *, 6> argv = { executable, "--render", job.recording.c_str(), job.outputFolder.c_str(), job.configs[next].c_str(), nullptr };
+			pid_t pid;
+			if (posix_spawn(&pid, executable, nullptr, nullptr, const_cast<char *const *>(argv.data()), environ) == 0)
+			{
+				++running;
+			}
+			else
+			{
+				CERR << "Cannot start the render of " << job.configs[next] << '\n';
+				++failures;
+			}
+			++next;
+		}
+		if (running == 0)
+		{
+			break;
+		}
+		int status = 0;
+		if (wait(&status) < 0)
+		{
+			break;
+		}
+		--running;
+		failures += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+	}
+#endif
+	COUT << "Rendered " << job.configs.size() - failures << " of " << job.configs.size() << " configs to " << job.outputFolder << '\n';
+	return failures;
+}
+
+Sink::Sink(const string &path, const InputRecording::Replay &replay)
+  : _replay(replay)
+{
+	if (!path.empty())
+	{
+		_out.open(path);
+		_out << "# JoyShockMapper render\n";
+	}
+}
+
+void Sink::key(uint16_t code, bool pressed)
+{
+	write("KEY", { float(code), pressed ? 1.f : 0.f });
+}
+
+void Sink::mouseMove(int x, int y)
+{
+	if (x != 0 || y != 0)
+	{
+		write("MOVE", { float(x), float(y) });
+	}
+}
+
+void Sink::mouseScroll(int hiResX, int hiResY)
+{
+	write("SCROLL", { float(hiResX), float(hiResY) });
+}
+
+void Sink::mouseAbsolute(float x, float y)
+{
+	write("ABSOLUTE", { x, y });
+}
+
+Gamepad *Sink::newGamepad(ControllerScheme scheme)
+{
+	return scheme == ControllerScheme::NONE ? nullptr : new RenderedGamepad(*this, scheme);
+}
+
+void Sink::write(string_view event, initializer_list<float> values)
+{
+	if (!_out.is_open())
+	{
+		return;
+	}
+	lock_guard guard(_lock);
+	_out << fixed << setprecision(6) << _replay.position() << ' ' << event;
+	_out << defaultfloat;
+	for (float value : values)
+	{
+		_out << ' ' << value;
+	}
+	_out << '\n';
+}
+
+void Benchmark::begin()
+{
+	_allocationsAtStart = AllocationCount();
+	_start = chrono::steady_clock::now();
+}
+
+void Benchmark::end()
+{
+	auto duration = chrono::steady_clock::now() - _start;
+	auto allocations = AllocationCount();
+	// Only now, so that growing the vector isn't counted as part of the tick
+	_durationsNs.push_back(chrono::duration_cast<chrono::nanoseconds>(duration).count());
+	if (allocations && _allocationsAtStart)
+	{
+		size_t count = *allocations - *_allocationsAtStart;
+		_allocations += count;
+		_allocatingTicks += count > 0;
+	}
+}
+
+string Benchmark::report() const
+{
+	if (_durationsNs.empty())
+	{
+		return "No tick was played\n";
+	}
+	vector<int64_t> sorted = _durationsNs;
+	sort(sorted.begin(), sorted.end());
+	auto microseconds = [&sorted](double quantile)
+	{
+		return double(sorted[min(sorted.size() - 1, size_t(quantile * sorted.size()))]) / 1000.0;
+	};
+	stringstream out;
+	out << fixed << setprecision(2);
+	out << _durationsNs.size() << " ticks\n";
+	out << "Time per tick: median " << microseconds(0.5) << " us, 99th percentile " << microseconds(0.99) << " us, worst " << microseconds(1.0) << " us\n";
+	if (AllocationCount())
+	{
+		out << "Allocations per tick: " << double(_allocations) / _durationsNs.size() << ", in " << _allocatingTicks << " of the ticks\n";
+	}
+	else
+	{
+		out << "Allocations per tick: not counted, build with JSM_COUNT_ALLOCATIONS to count them\n";
+	}
+	return out.str();
+}
+
+} // namespace OfflineRender
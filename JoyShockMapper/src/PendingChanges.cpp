@@ -0,0 +1,50 @@
+#include "PendingChanges.h"
+#include <utility>
+
+PendingChanges::~PendingChanges()
+{
+	release(_latest.exchange(nullptr));
+}
+
+void PendingChanges::release(Node *node)
+{
+	while (node)
+	{
+		delete std::exchange(node, node->next);
+	}
+}
+
+void PendingChanges::publish(Change change)
+{
+	Node *node = new Node{ std::move(change) };
+	node->next = _latest.load(std::memory_order_relaxed);
+	while (!_latest.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+size_t PendingChanges::apply()
+{
+	// Take them all at once, so that there is nothing to race with the publishers over
+	Node *latest = _latest.exchange(nullptr, std::memory_order_acquire);
+	if (!latest)
+	{
+		return 0;
+	}
+	Node *first = nullptr;
+	while (latest)
+	{
+		Node *next = latest->next;
+		latest->next = first;
+		first = latest;
+		latest = next;
+	}
+	size_t count = 0;
+	for (Node *node = first; node; node = node->next)
+	{
+		node->change();
+		++count;
+	}
+	release(first);
+	return count;
+}
@@ -0,0 +1,71 @@
+#include "ProfileCache.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+
+ProfileCache::FileStamp ProfileCache::stamp(const std::filesystem::path &path, std::filesystem::file_time_type modified, std::string_view content)
+{
+	return { path, modified, content.size(), hash(content) };
+}
+
+bool ProfileCache::unchanged(FileStamp &stamp)
+{
+	std::error_code error;
+	auto modified = std::filesystem::last_write_time(stamp.path, error);
+	if (error)
+	{
+		return false;
+	}
+	auto size = std::filesystem::file_size(stamp.path, error);
+	if (error || size != stamp.size)
+	{
+		return false;
+	}
+	if (modified == stamp.modified)
+	{
+		return true;
+	}
+	std::ifstream file(stamp.path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::string content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	if (content.size() != stamp.size || hash(content) != stamp.hash)
+	{
+		return false;
+	}
+	stamp.modified = modified;
+	return true;
+}
+
+std::uint64_t ProfileCache::hash(std::string_view content)
+{
+	std::uint64_t value = 0xcbf29ce484222325ull;
+	for (unsigned char c : content)
+	{
+		value = (value ^ c) * 0x100000001b3ull;
+	}
+	return value;
+}
+
+std::shared_ptr<const ProfileCache::Profile> ProfileCache::find(const std::filesystem::path &path)
+{
+	auto found = _profiles.find(path);
+	if (found == _profiles.end())
+	{
+		return nullptr;
+	}
+	if (!unchanged(found->second->file))
+	{
+		_profiles.erase(found);
+		return nullptr;
+	}
+	return found->second;
+}
+
+void ProfileCache::store(std::shared_ptr<Profile> profile)
+{
+	auto path = profile->file.path;
+	_profiles.insert_or_assign(std::move(path), std::move(profile));
+}
@@ -0,0 +1,637 @@
+#include "InputRecording.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+using namespace InputRecording;
+
+// Read only view of a whole file
+class MappedFile
+{
+public:
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (_data)
+			UnmapViewOfFile(_data);
+		if (_mapping)
+			CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE)
+			CloseHandle(_file);
+#else
+		if (_data)
+			munmap(const_cast<uint8_t *>(_data), _size);
+		if (_fd >= 0)
+			close(_fd);
+#endif
+	}
+
+	bool open(const std::string &path, std::string &error)
+	{
+#ifdef _WIN32
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		LARGE_INTEGER size;
+		if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size))
+		{
+			error = "cannot open the file";
+			return false;
+		}
+		_size = size_t(size.QuadPart);
+		if (_size == 0)
+		{
+			return true;
+		}
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		_data = _mapping ? static_cast<const uint8_t *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+		_fd = ::open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if (_fd < 0 || fstat(_fd, &info) != 0)
+		{
+			error = std::strerror(errno);
+			return false;
+		}
+		_size = size_t(info.st_size);
+		if (_size == 0)
+		{
+			return true;
+		}
+		void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+		if (data != MAP_FAILED)
+		{
+			_data = static_cast<const uint8_t *>(data);
+			// Records are read front to back
+			madvise(data, _size, MADV_SEQUENTIAL);
+		}
+#endif
+		if (!_data)
+		{
+			error = "cannot map the file";
+			return false;
+		}
+		return true;
+	}
+
+	const uint8_t *data() const
+	{
+		return _data;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+private:
+	const uint8_t *_data = nullptr;
+	size_t _size = 0;
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+};
+
+DeviceFrame toDeviceFrame(const File::Frame &in)
+{
+	DeviceFrame frame;
+	memset(&frame, 0, sizeof(frame));
+	frame.buttons = in.buttons;
+	frame.leftX = in.leftX;
+	frame.leftY = in.leftY;
+	frame.rightX = in.rightX;
+	frame.rightY = in.rightY;
+	frame.leftTrigger = in.leftTrigger;
+	frame.rightTrigger = in.rightTrigger;
+	frame.imu.accelX = in.accel[0];
+	frame.imu.accelY = in.accel[1];
+	frame.imu.accelZ = in.accel[2];
+	frame.imu.gyroX = in.gyro[0];
+	frame.imu.gyroY = in.gyro[1];
+	frame.imu.gyroZ = in.gyro[2];
+	frame.touch.t0Down = (in.touchDown & 1) != 0;
+	frame.touch.t1Down = (in.touchDown & 2) != 0;
+	frame.touch.t0X = in.touch[0];
+	frame.touch.t0Y = in.touch[1];
+	frame.touch.t1X = in.touch[2];
+	frame.touch.t1Y = in.touch[3];
+	frame.timestamp = in.sensorTimestamp;
+	return frame;
+}
+
+TimedImuState toTimedImuState(const uint8_t *data)
+{
+	File::Report in;
+	memcpy(&in, data, sizeof(in)); // Records are packed, so not aligned
+	TimedImuState report;
+	report.imu.accelX = in.accel[0];
+	report.imu.accelY = in.accel[1];
+	report.imu.accelZ = in.accel[2];
+	report.imu.gyroX = in.gyro[0];
+	report.imu.gyroY = in.gyro[1];
+	report.imu.gyroZ = in.gyro[2];
+	report.deltaTime = in.deltaTime;
+	return report;
+}
+
+// Plays a recording on its own thread, which runs the callbacks like the polling thread of a real backend.
+// The state of the devices is only touched by that thread, so the getters are meant to be called from the callbacks.
+class ReplayInstance : public Replay
+{
+public:
+	ReplayInstance(bool realTime)
+	  : _realTime(realTime)
+	{
+	}
+
+	~ReplayInstance() override
+	{
+		stop();
+	}
+
+	// Check every record once so that playback doesn't have to, and find the devices
+	bool open(const std::string &path, std::string &error)
+	{
+		if (!_file.open(path, error))
+		{
+			return false;
+		}
+		File::Header header;
+		if (_file.size() < sizeof(header))
+		{
+			error = "not a recording";
+			return false;
+		}
+		memcpy(&header, _file.data(), sizeof(header));
+		if (header.magic != File::kMagic || header.version != File::kVersion ||
+		  header.frameSize < sizeof(File::Frame) || header.reportSize < sizeof(File::Report))
+		{
+			error = "not a recording, or from an incompatible version";
+			return false;
+		}
+		_frameSize = header.frameSize;
+		_reportSize = header.reportSize;
+		_begin = sizeof(header);
+
+		size_t position = _begin;
+		while (position + _frameSize <= _file.size())
+		{
+			File::Frame record;
+			memcpy(&record, _file.data() + position, sizeof(record));
+			size_t recordSize = _frameSize + size_t(std::max<int>(record.imuReportCount, 0)) * _reportSize;
+			if (position + recordSize > _file.size())
+			{
+				break; // The recording was cut short
+			}
+			if (_devices.find(record.handle) == _devices.end())
+			{
+				auto &device = _devices[record.handle];
+				device.info = { record.handle, record.controllerType, record.splitType, record.vendorId, record.productId };
+			}
+			position += recordSize;
+			++_frameCount;
+		}
+		_end = position;
+		if (_frameCount == 0)
+		{
+			error = "the recording is empty";
+			return false;
+		}
+		return true;
+	}
+
+	int ConnectDevices() override
+	{
+		return int(_devices.size());
+	}
+
+	int GetDeviceCount() override
+	{
+		return int(_devices.size());
+	}
+
+	int GetConnectedDeviceHandles(int *deviceHandleArray, int size) override
+	{
+		int count = 0;
+		for (auto iter = _devices.begin(); iter != _devices.end() && count < size; ++iter)
+		{
+			deviceHandleArray[count++] = iter->first;
+		}
+		return count;
+	}
+
+	void DisconnectAndDisposeAll() override
+	{
+		stop();
+		_callback = nullptr;
+		_touchCallback = nullptr;
+	}
+
+	bool ProvidesTimeStep() override
+	{
+		return true;
+	}
+
+	bool IsLive() override
+	{
+		return false;
+	}
+
+	double position() const override
+	{
+		return double(_positionNs.load()) / 1e9;
+	}
+
+	bool finished() const override
+	{
+		return _finished;
+	}
+
+	JOY_SHOCK_STATE GetSimpleState(int deviceId) override
+	{
+		JOY_SHOCK_STATE state;
+		memset(&state, 0, sizeof(state));
+		if (auto *device = find(deviceId))
+		{
+			state.buttons = device->frame.buttons;
+			state.lTrigger = device->frame.leftTrigger;
+			state.rTrigger = device->frame.rightTrigger;
+			state.stickLX = device->frame.leftX;
+			state.stickLY = device->frame.leftY;
+			state.stickRX = device->frame.rightX;
+			state.stickRY = device->frame.rightY;
+		}
+		return state;
+	}
+
+	IMU_STATE GetIMUState(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->frame.imu : IMU_STATE();
+	}
+
+	int GetIMUReports(int deviceId, TimedImuState *reports, int maxReports) override
+	{
+		auto *device = find(deviceId);
+		if (!device || device->reportCount < 0)
+		{
+			return -1;
+		}
+		int count = std::min(device->reportCount, maxReports);
+		for (int i = 0; i < count; ++i)
+		{
+			reports[i] = toTimedImuState(device->reports + i * _reportSize);
+		}
+		device->reportCount = 0;
+		return count;
+	}
+
+	bool GetDeviceFrame(int deviceId, DeviceFrame &frame) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		frame = device->frame;
+		return true;
+	}
+
+	MOTION_STATE GetMotionState(int deviceId) override
+	{
+		return MOTION_STATE();
+	}
+
+	TOUCH_STATE GetTouchState(int deviceId, bool previous = false) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return TOUCH_STATE();
+		}
+		return previous ? device->prevTouch : device->frame.touch;
+	}
+
+	bool GetTouchpadDimension(int deviceId, int &sizeX, int &sizeY) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		// Same as the SDL backend
+		bool hasTouchpad = device->info.controllerType == JS_TYPE_DS4 || device->info.controllerType == JS_TYPE_DS;
+		sizeX = hasTouchpad ? 1920 : 0;
+		sizeY = hasTouchpad ? 920 : 0;
+		return true;
+	}
+
+	int GetButtons(int deviceId) override
+	{
+		return GetSimpleState(deviceId).buttons;
+	}
+
+	float GetLeftX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLX;
+	}
+
+	float GetLeftY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLY;
+	}
+
+	float GetRightX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRX;
+	}
+
+	float GetRightY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRY;
+	}
+
+	float GetLeftTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).lTrigger;
+	}
+
+	float GetRightTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).rTrigger;
+	}
+
+	float GetGyroX(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroX;
+	}
+
+	float GetGyroY(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroY;
+	}
+
+	float GetGyroZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroZ;
+	}
+
+	float GetAccelX(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelX;
+	}
+
+	float GetAccelY(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelY;
+	}
+
+	float GetAccelZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelZ;
+	}
+
+	int GetTouchId(int deviceId, bool secondTouch = false) override
+	{
+		return secondTouch ? 1 : 0;
+	}
+
+	bool GetTouchDown(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Down : touch.t0Down;
+	}
+
+	float GetTouchX(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1X : touch.t0X;
+	}
+
+	float GetTouchY(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Y : touch.t0Y;
+	}
+
+	float GetStickStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetTriggerStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetPollRate(int deviceId) override
+	{
+		return float();
+	}
+
+	void ResetContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void StartContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void PauseContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void GetCalibrationOffset(int deviceId, float &xOffset, float &yOffset, float &zOffset) override
+	{
+		xOffset = yOffset = zOffset = 0.f;
+	}
+
+	void SetCalibrationOffset(int deviceId, float xOffset, float yOffset, float zOffset) override
+	{
+	}
+
+	// Playback starts with the first callback
+	void SetCallback(void (*callback)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)) override
+	{
+		_callback = callback;
+		if (callback && !_player.joinable())
+		{
+			_playing = true;
+			_finished = false;
+			_player = std::thread(&ReplayInstance::play, this);
+		}
+	}
+
+	void SetTouchCallback(void (*callback)(int, TOUCH_STATE, TOUCH_STATE, float)) override
+	{
+		_touchCallback = callback;
+	}
+
+	int GetControllerType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->info.controllerType : 0;
+	}
+
+	int GetControllerSplitType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->info.splitType : JS_SPLIT_TYPE_FULL;
+	}
+
+	int GetControllerVendor(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->info.vendorId : JS_VENDOR_UNKNOWN;
+	}
+
+	int GetControllerProduct(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->info.productId : JS_PRODUCT_UNKNOWN;
+	}
+
+	int GetControllerColour(int deviceId) override
+	{
+		return int();
+	}
+
+	// There is no device to send output to
+	void SetLightColour(int deviceId, int colour) override
+	{
+	}
+
+	void SetRumble(int deviceId, int smallRumble, int bigRumble) override
+	{
+	}
+
+	void SetPlayerNumber(int deviceId, int number) override
+	{
+	}
+
+private:
+	struct ReplayDevice
+	{
+		DeviceInfo info;
+		DeviceFrame frame{};
+		TOUCH_STATE prevTouch{};
+		const uint8_t *reports = nullptr; // File::Report records of the current tick
+		int reportCount = -1;
+	};
+
+	ReplayDevice *find(int deviceId)
+	{
+		auto iter = _devices.find(deviceId);
+		return iter != _devices.end() ? &iter->second : nullptr;
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard guard(_playLock);
+			_playing = false;
+		}
+		_wake.notify_all();
+		if (_player.joinable())
+		{
+			_player.join();
+		}
+	}
+
+	void play()
+	{
+		auto start = std::chrono::steady_clock::now();
+		size_t position = _begin;
+		while (_playing && position < _end)
+		{
+			File::Frame record;
+			memcpy(&record, _file.data() + position, sizeof(record));
+			const uint8_t *reports = _file.data() + position + _frameSize;
+			position += _frameSize + size_t(std::max<int>(record.imuReportCount, 0)) * _reportSize;
+
+			if (_realTime)
+			{
+				std::unique_lock lock(_playLock);
+				if (_wake.wait_until(lock, start + std::chrono::nanoseconds(record.tickNs), [this]() { return !_playing; }))
+				{
+					break;
+				}
+			}
+
+			_positionNs = record.tickNs;
+			auto &device = _devices[record.handle];
+			device.prevTouch = device.frame.touch;
+			device.frame = toDeviceFrame(record);
+			device.reports = reports;
+			device.reportCount = record.imuReportCount;
+
+			if (auto callback = _callback.load())
+			{
+				JOY_SHOCK_STATE state = GetSimpleState(record.handle);
+				callback(record.handle, state, state, device.frame.imu, device.frame.imu, record.deltaTime);
+			}
+			if (auto touchCallback = _touchCallback.load())
+			{
+				touchCallback(record.handle, device.frame.touch, device.prevTouch, record.deltaTime);
+			}
+		}
+		_finished = position >= _end;
+	}
+
+	MappedFile _file;
+	bool _realTime;
+	size_t _frameSize = 0;
+	size_t _reportSize = 0;
+	size_t _begin = 0;
+	size_t _end = 0;
+	size_t _frameCount = 0;
+	std::map<int, ReplayDevice> _devices;
+
+	std::atomic<void (*)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)> _callback = nullptr;
+	std::atomic<void (*)(int, TOUCH_STATE, TOUCH_STATE, float)> _touchCallback = nullptr;
+	std::atomic_bool _playing = false;
+	std::atomic_bool _finished = false;
+	std::atomic<uint64_t> _positionNs = 0;
+	std::mutex _playLock;
+	std::condition_variable _wake;
+	std::thread _player;
+};
+
+} // namespace
+
+namespace InputRecording
+{
+
+Replay *OpenReplay(const std::string &path, bool realTime, std::string &error)
+{
+	auto replay = new ReplayInstance(realTime);
+	if (!replay->open(path, error))
+	{
+		delete replay;
+		return nullptr;
+	}
+	return replay;
+}
+
+} // namespace InputRecording
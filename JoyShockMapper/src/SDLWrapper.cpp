@@ -3,9 +3,12 @@
 #include "JSMVariable.hpp"
  #include "TriggerEffectGenerator.h"
 #include "SettingsManager.h"
+#include "SensorClock.h"
 #include "SDL3/SDL.h"
 #include <map>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <atomic>
 #define _USE_MATH_DEFINES
 #include <math.h> // M_PI
@@ -14,6 +17,80 @@
 #include <iostream>
 #include <cstring>
 #include <span>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+using Deadline = timespec;
+
+Deadline deadlineNow()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now;
+}
+
+void advanceDeadline(Deadline &deadline, float milliseconds)
+{
+	deadline.tv_nsec += long(milliseconds * 1000000.f);
+	deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+	deadline.tv_nsec %= 1000000000L;
+}
+
+bool isPast(const Deadline &deadline, const Deadline &now)
+{
+	return now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec > deadline.tv_nsec);
+}
+
+// Sleep on an absolute deadline so that the time spent polling doesn't accumulate as drift
+void sleepUntil(const Deadline &deadline)
+{
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+	{
+	}
+}
+
+bool raiseThreadPriority()
+{
+	sched_param param;
+	param.sched_priority = min(10, sched_get_priority_max(SCHED_FIFO));
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+#else
+using Deadline = chrono::steady_clock::time_point;
+
+Deadline deadlineNow()
+{
+	return chrono::steady_clock::now();
+}
+
+void advanceDeadline(Deadline &deadline, float milliseconds)
+{
+	deadline += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float, milli>(milliseconds));
+}
+
+bool isPast(const Deadline &deadline, const Deadline &now)
+{
+	return now > deadline;
+}
+
+void sleepUntil(const Deadline &deadline)
+{
+	this_thread::sleep_until(deadline);
+}
+
+bool raiseThreadPriority()
+{
+	return SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
+}
+#endif
+} // namespace
 
 typedef struct
 {
@@ -76,6 +153,7 @@ struct ControllerDevice
 						SDL_SetGamepadSensorEnabled(_sdlController, SDL_SENSOR_ACCEL, true);
 					}
 
+					_joystickId = SDL_GetGamepadID(_sdlController);
 					_vendorId = SDL_GetGamepadVendor(_sdlController);
 					_productId = SDL_GetGamepadProduct(_sdlController);
 
@@ -194,6 +272,170 @@ private:
 	}
 
 public:
+	// SDL reports gyro in radians per second and accel in m/s^2
+	static IMU_STATE toImuState(const float *gyro, const float *accel)
+	{
+		static constexpr float toDegPerSec = float(180. / M_PI);
+		static constexpr float toGs = 1.f / 9.8f;
+		IMU_STATE imuState;
+		memset(&imuState, 0, sizeof(imuState));
+		if (gyro)
+		{
+			imuState.gyroX = gyro[0] * toDegPerSec;
+			imuState.gyroY = gyro[1] * toDegPerSec;
+			imuState.gyroZ = gyro[2] * toDegPerSec;
+		}
+		if (accel)
+		{
+			imuState.accelX = accel[0] * toGs;
+			imuState.accelY = accel[1] * toGs;
+			imuState.accelZ = accel[2] * toGs;
+		}
+		return imuState;
+	}
+
+	int readButtons() const
+	{
+		static constexpr pair<SDL_GamepadButton, int> sdl2jsl[] = {
+			{ SDL_GAMEPAD_BUTTON_SOUTH, JSOFFSET_S },
+			{ SDL_GAMEPAD_BUTTON_EAST, JSOFFSET_E },
+			{ SDL_GAMEPAD_BUTTON_WEST, JSOFFSET_W },
+			{ SDL_GAMEPAD_BUTTON_NORTH, JSOFFSET_N },
+			{ SDL_GAMEPAD_BUTTON_BACK, JSOFFSET_MINUS },
+			{ SDL_GAMEPAD_BUTTON_GUIDE, JSOFFSET_HOME },
+			{ SDL_GAMEPAD_BUTTON_START, JSOFFSET_PLUS },
+			{ SDL_GAMEPAD_BUTTON_LEFT_STICK, JSOFFSET_LCLICK },
+			{ SDL_GAMEPAD_BUTTON_RIGHT_STICK, JSOFFSET_RCLICK },
+			{ SDL_GAMEPAD_BUTTON_LEFT_SHOULDER, JSOFFSET_L },
+			{ SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER, JSOFFSET_R },
+			{ SDL_GAMEPAD_BUTTON_DPAD_UP, JSOFFSET_UP },
+			{ SDL_GAMEPAD_BUTTON_DPAD_DOWN, JSOFFSET_DOWN },
+			{ SDL_GAMEPAD_BUTTON_DPAD_LEFT, JSOFFSET_LEFT },
+			{ SDL_GAMEPAD_BUTTON_DPAD_RIGHT, JSOFFSET_RIGHT }
+		};
+
+		int buttons = 0;
+		for (auto pair : sdl2jsl)
+		{
+			buttons |= SDL_GetGamepadButton(_sdlController, pair.first) ? 1 << pair.second : 0;
+		}
+		switch (_ctrlr_type)
+		{
+		case JS_TYPE_JOYCON_LEFT:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
+			break;
+		case JS_TYPE_JOYCON_RIGHT:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
+			break;
+		case JS_TYPE_DS:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_MIC : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_TOUCHPAD) ? 1 << JSOFFSET_CAPTURE : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SR : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNR : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
+			break;
+		case JS_TYPE_DS4:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_TOUCHPAD) ? 1 << JSOFFSET_CAPTURE : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
+			break;
+		case JS_TYPE_PRO_CONTROLLER:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SR : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNR : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
+			break;
+		default:
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
+			buttons |= SDL_GetGamepadButton(_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_FNR : 0;
+			break;
+		}
+		return buttons;
+	}
+
+	// Sticks are up positive, triggers from 0 to 1
+	float readAxis(SDL_GamepadAxis axis, bool invert = false) const
+	{
+		float value = SDL_GetGamepadAxis(_sdlController, axis) / (float)SDL_JOYSTICK_AXIS_MAX;
+		return invert ? -value : value;
+	}
+
+	IMU_STATE readImu() const
+	{
+		array<float, 3> gyro;
+		array<float, 3> accel;
+		bool hasGyro = _has_gyro && SDL_GetGamepadSensorData(_sdlController, SDL_SENSOR_GYRO, &gyro[0], 3);
+		bool hasAccel = _has_accel && SDL_GetGamepadSensorData(_sdlController, SDL_SENSOR_ACCEL, &accel[0], 3);
+		return toImuState(hasGyro ? gyro.data() : nullptr, hasAccel ? accel.data() : nullptr);
+	}
+
+	TOUCH_STATE readTouch() const
+	{
+		TOUCH_STATE state;
+		memset(&state, 0, sizeof(TOUCH_STATE));
+		if (!SDL_GetGamepadTouchpadFinger(_sdlController, 0, 0, &state.t0Down, &state.t0X, &state.t0Y, nullptr) ||
+		  !SDL_GetGamepadTouchpadFinger(_sdlController, 0, 1, &state.t1Down, &state.t1X, &state.t1Y, nullptr))
+		{
+			CERR << "Cannot get finger state: " << SDL_GetError() << '\n';
+		}
+		return state;
+	}
+
+	// Take the snapshot of the device that the callbacks of this tick work with
+	void captureFrame()
+	{
+		_frame.buttons = readButtons();
+		_frame.leftX = readAxis(SDL_GAMEPAD_AXIS_LEFTX);
+		_frame.leftY = readAxis(SDL_GAMEPAD_AXIS_LEFTY, true);
+		_frame.rightX = readAxis(SDL_GAMEPAD_AXIS_RIGHTX);
+		_frame.rightY = readAxis(SDL_GAMEPAD_AXIS_RIGHTY, true);
+		_frame.leftTrigger = readAxis(SDL_GAMEPAD_AXIS_LEFT_TRIGGER);
+		_frame.rightTrigger = readAxis(SDL_GAMEPAD_AXIS_RIGHT_TRIGGER);
+		_frame.imu = readImu();
+		_frame.touch = readTouch();
+		_frame.timestamp = _lastGyroTimestamp != 0 ? _lastGyroTimestamp : SDL_GetTicksNS();
+	}
+
+	// Queue a gyro report paired with the latest accelerometer report
+	void addSensorEvent(const SDL_GamepadSensorEvent &event)
+	{
+		if (event.sensor == SDL_SENSOR_ACCEL)
+		{
+			copy(begin(event.data), end(event.data), _lastAccel.begin());
+			return;
+		}
+		if (event.sensor != SDL_SENSOR_GYRO)
+		{
+			return;
+		}
+		// Not every driver provides a sensor timestamp
+		Uint64 timestamp = event.sensor_timestamp != 0 ? event.sensor_timestamp : event.timestamp;
+		float deltaTime = 0.f;
+		if (!_sensorClock.step(timestamp, deltaTime))
+		{
+			return; // Already seen
+		}
+		_lastGyroTimestamp = timestamp;
+
+		TimedImuState report{ toImuState(event.data, _has_accel ? _lastAccel.data() : nullptr), deltaTime };
+		if (_imuReportCount < _imuReports.size())
+		{
+			_imuReports[_imuReportCount++] = report;
+		}
+		else
+		{
+			// Nobody is consuming the reports. Keep the latest one without losing the elapsed time.
+			report.deltaTime += _imuReports.back().deltaTime;
+			_imuReports.back() = report;
+		}
+	}
+
 	void SendEffect()
 	{
 		if (_ctrlr_type == JS_TYPE_DS)
@@ -231,8 +473,24 @@ public:
 	AdaptiveTriggerSetting _leftTriggerEffect;
 	AdaptiveTriggerSetting _rightTriggerEffect;
 	uint8_t _micLight = 0;
+	// Last output sent to the device, so that unchanged state isn't written again
+	uint16_t _sentSmallRumble = 0;
+	uint16_t _sentBigRumble = 0;
+	Uint64 _rumbleSentTicks = 0;
+	int _lightColour = -1;
+	int _playerNumber = -1;
 	SDL_Gamepad *_sdlController = nullptr;
+	SDL_JoystickID _joystickId = 0;
 	TOUCH_STATE _prevTouchState;
+
+	// IMU reports received through sensor events since the last callback
+	array<TimedImuState, 128> _imuReports;
+	size_t _imuReportCount = 0;
+	array<float, 3> _lastAccel = { 0.f, 0.f, 0.f };
+	Uint64 _lastGyroTimestamp = 0;
+	SensorClock _sensorClock;
+
+	DeviceFrame _frame{};
 };
 
 struct SdlInstance : public JslWrapper
@@ -268,38 +526,198 @@ public:
 			auto tick_time = SettingsManager::get<float>(SettingID::TICK_TIME)->value();
 			SDL_Delay(Uint32(tick_time));
 
+			bool perDevice = SettingsManager::getV<Switch>(SettingID::PER_DEVICE_POLLING)->value() == Switch::ON;
+			if (perDevice)
+			{
+				startDeviceWorkers();
+			}
+			else
+			{
+				stopDeviceWorkers();
+			}
+
 			lock_guard guard(controller_lock);
 			SDL_UpdateGamepads();
-			for (auto iter = _controllerMap.begin(); iter != _controllerMap.end(); ++iter)
+			_sensorEvents = SettingsManager::getV<Switch>(SettingID::SENSOR_EVENTS)->value() == Switch::ON;
+			if (_sensorEvents)
+			{
+				dispatchSensorEvents();
+			}
+			else
 			{
-				if (g_callback)
+				SDL_FlushEvent(SDL_EVENT_GAMEPAD_SENSOR_UPDATE);
+				for (auto &device : _controllerMap)
 				{
-					JOY_SHOCK_STATE dummy1;
-					IMU_STATE dummy2;
-					memset(&dummy1, 0, sizeof(dummy1));
-					memset(&dummy2, 0, sizeof(dummy2));
-					g_callback(iter->first, dummy1, dummy1, dummy2, dummy2, tick_time);
+					device.second->_imuReportCount = 0;
+					device.second->_lastGyroTimestamp = 0;
+					device.second->_sensorClock.reset();
 				}
-				if (g_touch_callback)
+			}
+			if (!perDevice)
+			{
+				for (auto iter = _controllerMap.begin(); iter != _controllerMap.end(); ++iter)
 				{
-					TOUCH_STATE touch = GetTouchState(iter->first, false);
-					g_touch_callback(iter->first, touch, iter->second->_prevTouchState, tick_time);
-					iter->second->_prevTouchState = touch;
+					pollDevice(iter->first, *iter->second, tick_time);
 				}
-				// Perform rumble
-				SDL_RumbleGamepad(iter->second->_sdlController, iter->second->_big_rumble, iter->second->_small_rumble, Uint32(tick_time + 5));
 			}
 		}
+		stopDeviceWorkers();
 
 		return 1;
 	}
 
+	// Run the callbacks of a single device. The caller holds controller_lock, shared or exclusive.
+	void pollDevice(int deviceId, ControllerDevice &device, float tick_time)
+	{
+		device.captureFrame();
+		if (g_callback)
+		{
+			JOY_SHOCK_STATE dummy1;
+			IMU_STATE dummy2;
+			memset(&dummy1, 0, sizeof(dummy1));
+			memset(&dummy2, 0, sizeof(dummy2));
+			g_callback(deviceId, dummy1, dummy1, dummy2, dummy2, tick_time);
+		}
+		if (g_touch_callback)
+		{
+			g_touch_callback(deviceId, device._frame.touch, device._prevTouchState, tick_time);
+			device._prevTouchState = device._frame.touch;
+		}
+		// Perform rumble. SDL stops rumbling once the duration runs out, so an active rumble is renewed every
+		// RUMBLE_KEEP_ALIVE ms and lasts a bit longer than that. Otherwise it is only sent when it changes.
+		auto keepAlive = SettingsManager::getV<float>(SettingID::RUMBLE_KEEP_ALIVE)->value();
+		auto now = SDL_GetTicks();
+		bool changed = device._big_rumble != device._sentBigRumble || device._small_rumble != device._sentSmallRumble;
+		bool active = device._big_rumble != 0 || device._small_rumble != 0;
+		if (changed || (active && now - device._rumbleSentTicks >= Uint64(keepAlive)))
+		{
+			SDL_RumbleGamepad(device._sdlController, device._big_rumble, device._small_rumble, Uint32(keepAlive + tick_time + 5));
+			device._sentBigRumble = device._big_rumble;
+			device._sentSmallRumble = device._small_rumble;
+			device._rumbleSentTicks = now;
+		}
+	}
+
+	// In per device mode, each controller runs its callbacks on its own thread and timing loop.
+	// The main poll thread then only updates SDL. A worker ends when its device is gone.
+	struct DeviceWorker
+	{
+		atomic_bool running = true;
+		thread worker;
+	};
+
+	void deviceWorkerLoop(int deviceId, DeviceWorker *self)
+	{
+		if (SettingsManager::getV<Switch>(SettingID::REALTIME_POLLING)->value() == Switch::ON && !raiseThreadPriority())
+		{
+			COUT_WARN << "Real-time priority is not permitted for the polling thread of device " << deviceId << ". Using normal priority.\n";
+		}
+		Deadline deadline = deadlineNow();
+		while (self->running && keep_polling)
+		{
+			auto tick_time = SettingsManager::get<float>(SettingID::TICK_TIME)->value();
+			advanceDeadline(deadline, tick_time);
+			Deadline now = deadlineNow();
+			if (isPast(deadline, now))
+			{
+				deadline = now; // Fell behind. Don't try to catch up with a burst of ticks.
+			}
+			else
+			{
+				sleepUntil(deadline);
+			}
+
+			shared_lock guard(controller_lock);
+			auto device = _controllerMap.find(deviceId);
+			if (device == _controllerMap.end())
+			{
+				break;
+			}
+			pollDevice(deviceId, *device->second, tick_time);
+		}
+		self->running = false;
+	}
+
+	void startDeviceWorkers()
+	{
+		lock_guard workerGuard(_workerLock);
+		// Collect workers whose device went away
+		for (auto iter = _deviceWorkers.begin(); iter != _deviceWorkers.end();)
+		{
+			if (!iter->second->running)
+			{
+				iter->second->worker.join();
+				iter = _deviceWorkers.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		shared_lock guard(controller_lock);
+		for (auto &device : _controllerMap)
+		{
+			auto &worker = _deviceWorkers[device.first];
+			if (!worker)
+			{
+				worker = make_unique<DeviceWorker>();
+				worker->worker = thread(&SdlInstance::deviceWorkerLoop, this, device.first, worker.get());
+			}
+		}
+	}
+
+	// Never call this while holding controller_lock: the workers need it to finish their tick
+	void stopDeviceWorkers()
+	{
+		lock_guard workerGuard(_workerLock);
+		for (auto &worker : _deviceWorkers)
+		{
+			worker.second->running = false;
+		}
+		for (auto &worker : _deviceWorkers)
+		{
+			worker.second->worker.join();
+		}
+		_deviceWorkers.clear();
+	}
+
+	// Move every pending sensor event into the report queue of its device
+	void dispatchSensorEvents()
+	{
+		array<SDL_Event, 64> events;
+		int count = 0;
+		while ((count = SDL_PeepEvents(events.data(), int(events.size()), SDL_GETEVENT, SDL_EVENT_GAMEPAD_SENSOR_UPDATE, SDL_EVENT_GAMEPAD_SENSOR_UPDATE)) > 0)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				const auto &sensorEvent = events[i].gsensor;
+				auto device = find_if(_controllerMap.begin(), _controllerMap.end(), [&sensorEvent](auto &pair)
+				  { return pair.second->_joystickId == sensorEvent.which; });
+				if (device != _controllerMap.end())
+				{
+					device->second->addSensorEvent(sensorEvent);
+				}
+			}
+		}
+	}
+
+	// The device of a handle, or nullptr if it's unknown or gone. Unlike operator[], this never inserts into the
+	// map, which other threads may be reading under the shared lock.
+	ControllerDevice *findDevice(int deviceId) const
+	{
+		auto device = _controllerMap.find(deviceId);
+		return device != _controllerMap.end() ? device->second : nullptr;
+	}
+
 	SDL_JoystickID * _joysticksArray = nullptr;
 	map<int, ControllerDevice *> _controllerMap;
 	void (*g_callback)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float) = nullptr;
 	void (*g_touch_callback)(int, TOUCH_STATE, TOUCH_STATE, float) = nullptr;
 	atomic_bool keep_polling = false;
-	mutex controller_lock;
+	bool _sensorEvents = false;
+	shared_mutex controller_lock; // Device workers take it shared, everything else exclusive
+	mutex _workerLock;
+	map<int, unique_ptr<DeviceWorker>> _deviceWorkers;
 
 	int ConnectDevices() override
 	{
@@ -381,27 +799,44 @@ public:
 
 	IMU_STATE GetIMUState(int deviceId) override
 	{
-		IMU_STATE imuState;
-		memset(&imuState, 0, sizeof(imuState));
-		if (_controllerMap[deviceId]->_has_gyro)
+		auto device = findDevice(deviceId);
+		return device ? device->readImu() : IMU_STATE();
+	}
+
+	int GetIMUReports(int deviceId, TimedImuState *reports, int maxReports) override
+	{
+		if (!_sensorEvents)
 		{
-			array<float, 3> gyro;
-			SDL_GetGamepadSensorData(_controllerMap[deviceId]->_sdlController, SDL_SENSOR_GYRO, &gyro[0], 3);
-			static constexpr float toDegPerSec = float(180. / M_PI);
-			imuState.gyroX = gyro[0] * toDegPerSec;
-			imuState.gyroY = gyro[1] * toDegPerSec;
-			imuState.gyroZ = gyro[2] * toDegPerSec;
+			return -1;
 		}
-		if (_controllerMap[deviceId]->_has_accel)
+		auto device = findDevice(deviceId);
+		if (!device)
 		{
-			array<float, 3> accel;
-			SDL_GetGamepadSensorData(_controllerMap[deviceId]->_sdlController, SDL_SENSOR_ACCEL, &accel[0], 3);
-			static constexpr float toGs = 1.f / 9.8f;
-			imuState.accelX = accel[0] * toGs;
-			imuState.accelY = accel[1] * toGs;
-			imuState.accelZ = accel[2] * toGs;
+			return 0;
 		}
-		return imuState;
+		int count = min(int(device->_imuReportCount), maxReports);
+		copy_n(device->_imuReports.begin(), count, reports);
+		device->_imuReportCount = 0;
+		return count;
+	}
+
+	ImuReportStats GetIMUReportStats(int deviceId) override
+	{
+		// Devices come and go under the lock
+		lock_guard guard(controller_lock);
+		auto device = findDevice(deviceId);
+		return device ? device->_sensorClock.stats() : ImuReportStats();
+	}
+
+	bool GetDeviceFrame(int deviceId, DeviceFrame &frame) override
+	{
+		auto device = _controllerMap.find(deviceId);
+		if (device == _controllerMap.end())
+		{
+			return false;
+		}
+		frame = device->second->_frame;
+		return true;
 	}
 
 	MOTION_STATE GetMotionState(int deviceId) override
@@ -411,23 +846,17 @@ public:
 
 	TOUCH_STATE GetTouchState(int deviceId, bool previous) override
 	{
-		TOUCH_STATE state;
-		memset(&state, 0, sizeof(TOUCH_STATE));
-		if (!SDL_GetGamepadTouchpadFinger(_controllerMap[deviceId]->_sdlController, 0, 0, &state.t0Down, &state.t0X, &state.t0Y, nullptr) || 
-			!SDL_GetGamepadTouchpadFinger(_controllerMap[deviceId]->_sdlController, 0, 1, &state.t1Down, &state.t1X, &state.t1Y, nullptr))
-		{
-			CERR << "Cannot get finger state: " << SDL_GetError() << '\n';
-		}
-		return state;
+		auto device = findDevice(deviceId);
+		return device ? device->readTouch() : TOUCH_STATE();
 	}
 
 	bool GetTouchpadDimension(int deviceId, int &sizeX, int &sizeY) override
 	{
 		// I am assuming a single touchpad (or all _touchpads are the same dimension)?
-		auto *jc = _controllerMap[deviceId];
+		auto jc = findDevice(deviceId);
 		if (jc != nullptr)
 		{
-			switch (_controllerMap[deviceId]->_ctrlr_type)
+			switch (jc->_ctrlr_type)
 			{
 			case JS_TYPE_DS4:
 			case JS_TYPE_DS:
@@ -447,126 +876,75 @@ public:
 
 	int GetButtons(int deviceId) override
 	{
-		static const map<int, int> sdl2jsl = {
-			{ SDL_GAMEPAD_BUTTON_SOUTH, JSOFFSET_S },
-			{ SDL_GAMEPAD_BUTTON_EAST, JSOFFSET_E },
-			{ SDL_GAMEPAD_BUTTON_WEST, JSOFFSET_W },
-			{ SDL_GAMEPAD_BUTTON_NORTH, JSOFFSET_N },
-			{ SDL_GAMEPAD_BUTTON_BACK, JSOFFSET_MINUS },
-			{ SDL_GAMEPAD_BUTTON_GUIDE, JSOFFSET_HOME },
-			{ SDL_GAMEPAD_BUTTON_START, JSOFFSET_PLUS },
-			{ SDL_GAMEPAD_BUTTON_LEFT_STICK, JSOFFSET_LCLICK },
-			{ SDL_GAMEPAD_BUTTON_RIGHT_STICK, JSOFFSET_RCLICK },
-			{ SDL_GAMEPAD_BUTTON_LEFT_SHOULDER, JSOFFSET_L },
-			{ SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER, JSOFFSET_R },
-			{ SDL_GAMEPAD_BUTTON_DPAD_UP, JSOFFSET_UP },
-			{ SDL_GAMEPAD_BUTTON_DPAD_DOWN, JSOFFSET_DOWN },
-			{ SDL_GAMEPAD_BUTTON_DPAD_LEFT, JSOFFSET_LEFT },
-			{ SDL_GAMEPAD_BUTTON_DPAD_RIGHT, JSOFFSET_RIGHT }
-		};
-
-		int buttons = 0;
-		for (auto pair : sdl2jsl)
-		{
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GamepadButton(pair.first)) ? 1 << pair.second : 0;
-
-		}
-		switch (_controllerMap[deviceId]->_ctrlr_type)
-		{
-		case JS_TYPE_JOYCON_LEFT:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
-			break;
-		case JS_TYPE_JOYCON_RIGHT:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
-			break;
-		case JS_TYPE_DS:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_MIC : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_TOUCHPAD) ? 1 << JSOFFSET_CAPTURE : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SR : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNR : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
-			break;
-		case JS_TYPE_DS4:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_TOUCHPAD) ? 1 << JSOFFSET_CAPTURE : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_SR : 0;
-			break;
-		case JS_TYPE_PRO_CONTROLLER:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_SR : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE1) ? 1 << JSOFFSET_SL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNR : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_LEFT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
-			break;
-		default:
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_MISC1) ? 1 << JSOFFSET_CAPTURE : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2) ? 1 << JSOFFSET_FNL : 0;
-			buttons |= SDL_GetGamepadButton(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1) ? 1 << JSOFFSET_FNR : 0;
-			break;
-		}
-		return buttons;
+		auto device = findDevice(deviceId);
+		return device ? device->readButtons() : 0;
 	}
 
 	float GetLeftX(int deviceId) override
 	{
-		return SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_LEFTX) / (float)SDL_JOYSTICK_AXIS_MAX;
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_LEFTX) : float();
 	}
 
 	float GetLeftY(int deviceId) override
 	{
-		return -SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_LEFTY) / (float)SDL_JOYSTICK_AXIS_MAX;
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_LEFTY, true) : float();
 	}
 
 	float GetRightX(int deviceId) override
 	{
-		return SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_RIGHTX) / (float)SDL_JOYSTICK_AXIS_MAX;
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_RIGHTX) : float();
 	}
 
 	float GetRightY(int deviceId) override
 	{
-		return -SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_RIGHTY) / (float)SDL_JOYSTICK_AXIS_MAX;
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_RIGHTY, true) : float();
 	}
 
 	float GetLeftTrigger(int deviceId) override
 	{
-		return (SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_LEFT_TRIGGER)) / (float)(SDL_JOYSTICK_AXIS_MAX);
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_LEFT_TRIGGER) : float();
 	}
 
 	float GetRightTrigger(int deviceId) override
 	{
-		return (SDL_GetGamepadAxis(_controllerMap[deviceId]->_sdlController, SDL_GAMEPAD_AXIS_RIGHT_TRIGGER)) / (float)(SDL_JOYSTICK_AXIS_MAX);
+		auto device = findDevice(deviceId);
+		return device ? device->readAxis(SDL_GAMEPAD_AXIS_RIGHT_TRIGGER) : float();
 	}
 
 	float GetGyroX(int deviceId) override
 	{
-		if (_controllerMap[deviceId]->_has_gyro)
+		auto device = findDevice(deviceId);
+		if (device && device->_has_gyro)
 		{
 			float rawGyro[3];
-			SDL_GetGamepadSensorData(_controllerMap[deviceId]->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
+			SDL_GetGamepadSensorData(device->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
 		}
 		return float();
 	}
 
 	float GetGyroY(int deviceId) override
 	{
-		if (_controllerMap[deviceId]->_has_gyro)
+		auto device = findDevice(deviceId);
+		if (device && device->_has_gyro)
 		{
 			float rawGyro[3];
-			SDL_GetGamepadSensorData(_controllerMap[deviceId]->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
+			SDL_GetGamepadSensorData(device->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
 		}
 		return float();
 	}
 
 	float GetGyroZ(int deviceId) override
 	{
-		if (_controllerMap[deviceId]->_has_gyro)
+		auto device = findDevice(deviceId);
+		if (device && device->_has_gyro)
 		{
 			float rawGyro[3];
-			SDL_GetGamepadSensorData(_controllerMap[deviceId]->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
+			SDL_GetGamepadSensorData(device->_sdlController, SDL_SENSOR_GYRO, rawGyro, 3);
 		}
 		return float();
 	}
@@ -594,13 +972,15 @@ public:
 	bool GetTouchDown(int deviceId, bool secondTouch)
 	{
 		bool touchState = 0;
-		return SDL_GetGamepadTouchpadFinger(_controllerMap[deviceId]->_sdlController, 0, secondTouch ? 1 : 0, &touchState, nullptr, nullptr, nullptr) ? touchState : false;
+		auto device = findDevice(deviceId);
+		return device && SDL_GetGamepadTouchpadFinger(device->_sdlController, 0, secondTouch ? 1 : 0, &touchState, nullptr, nullptr, nullptr) ? touchState : false;
 	}
 
 	float GetTouchX(int deviceId, bool secondTouch = false) override
 	{
 		float x = 0;
-		if (SDL_GetGamepadTouchpadFinger(_controllerMap[deviceId]->_sdlController, 0, secondTouch ? 1 : 0, nullptr, nullptr, &x, nullptr))
+		auto device = findDevice(deviceId);
+		if (device && SDL_GetGamepadTouchpadFinger(device->_sdlController, 0, secondTouch ? 1 : 0, nullptr, nullptr, &x, nullptr))
 		{
 			return x;
 		}
@@ -610,7 +990,8 @@ public:
 	float GetTouchY(int deviceId, bool secondTouch = false) override
 	{
 		float y = 0;
-		if (SDL_GetGamepadTouchpadFinger(_controllerMap[deviceId]->_sdlController, 0, secondTouch ? 1 : 0, nullptr, nullptr, &y, nullptr))
+		auto device = findDevice(deviceId);
+		if (device && SDL_GetGamepadTouchpadFinger(device->_sdlController, 0, secondTouch ? 1 : 0, nullptr, nullptr, &y, nullptr))
 		{
 			return y;
 		}
@@ -666,22 +1047,33 @@ public:
 
 	int GetControllerType(int deviceId) override
 	{
-		return _controllerMap[deviceId]->_ctrlr_type;
+		auto device = findDevice(deviceId);
+		return device ? device->_ctrlr_type : 0;
 	}
 
 	int GetControllerSplitType(int deviceId) override
 	{
-		return _controllerMap[deviceId]->_split_type;
+		auto device = findDevice(deviceId);
+		return device ? device->_split_type : 0;
 	}
 
 	int GetControllerVendor(int deviceId) override
 	{
-		return _controllerMap[deviceId]->_vendorId;
+		auto device = findDevice(deviceId);
+		return device ? device->_vendorId : 0;
 	}
 
 	int GetControllerProduct(int deviceId) override
 	{
-		return _controllerMap[deviceId]->_productId;
+		auto device = findDevice(deviceId);
+		return device ? device->_productId : 0;
+	}
+
+	std::string GetControllerSerial(int deviceId) override
+	{
+		auto device = findDevice(deviceId);
+		const char *serial = device ? SDL_GetGamepadSerial(device->_sdlController) : nullptr;
+		return serial ? serial : std::string();
 	}
 
 	int GetControllerColour(int deviceId) override
@@ -691,7 +1083,13 @@ public:
 
 	void SetLightColour(int deviceId, int colour) override
 	{
-		auto prop = SDL_GetGamepadProperties(_controllerMap[deviceId]->_sdlController);
+		auto device = findDevice(deviceId);
+		if (!device || device->_lightColour == colour)
+		{
+			return;
+		}
+		device->_lightColour = colour;
+		auto prop = SDL_GetGamepadProperties(device->_sdlController);
 		
 		if (SDL_GetStringProperty(prop, SDL_PROP_GAMEPAD_CAP_RGB_LED_BOOLEAN, nullptr) != nullptr)
 		{
@@ -701,41 +1099,50 @@ public:
 				uint8_t argb[4];
 			} uColour;
 			uColour.raw = colour;
-			SDL_SetGamepadLED(_controllerMap[deviceId]->_sdlController, uColour.argb[2], uColour.argb[1], uColour.argb[0]);
+			SDL_SetGamepadLED(device->_sdlController, uColour.argb[2], uColour.argb[1], uColour.argb[0]);
 		}
 	}
 
 	void SetRumble(int deviceId, int smallRumble, int bigRumble) override
 	{
-		// sendRumble command needs to be sent at every poll in SDL, so the next value is set here and the actual call
-		// is done after the callback return
-		_controllerMap[deviceId]->_small_rumble = clamp(smallRumble, 0, int(UINT16_MAX));
-		_controllerMap[deviceId]->_big_rumble = clamp(bigRumble, 0, int(UINT16_MAX));
+		// The next value is set here and the actual call is done after the callback returns
+		if (auto device = findDevice(deviceId))
+		{
+			device->_small_rumble = clamp(smallRumble, 0, int(UINT16_MAX));
+			device->_big_rumble = clamp(bigRumble, 0, int(UINT16_MAX));
+		}
 	}
 
 	void SetPlayerNumber(int deviceId, int number) override
 	{
-		SDL_SetGamepadPlayerIndex(_controllerMap[deviceId]->_sdlController, number);
+		auto device = findDevice(deviceId);
+		if (device && device->_playerNumber != number)
+		{
+			device->_playerNumber = number;
+			SDL_SetGamepadPlayerIndex(device->_sdlController, number);
+		}
 	}
 
 	void SetTriggerEffect(int deviceId, const AdaptiveTriggerSetting &_leftTriggerEffect, const AdaptiveTriggerSetting &_rightTriggerEffect) override
 	{
-		if (_leftTriggerEffect != _controllerMap[deviceId]->_leftTriggerEffect || _rightTriggerEffect != _controllerMap[deviceId]->_rightTriggerEffect)
+		auto device = findDevice(deviceId);
+		if (device && (_leftTriggerEffect != device->_leftTriggerEffect || _rightTriggerEffect != device->_rightTriggerEffect))
 		{
 			// Update active trigger effect
-			_controllerMap[deviceId]->_leftTriggerEffect = _leftTriggerEffect;
-			_controllerMap[deviceId]->_rightTriggerEffect = _rightTriggerEffect;
+			device->_leftTriggerEffect = _leftTriggerEffect;
+			device->_rightTriggerEffect = _rightTriggerEffect;
+			device->SendEffect();
 		}
-		_controllerMap[deviceId]->SendEffect();
 	}
 
 	virtual void SetMicLight(int deviceId, uint8_t mode) override
 	{
-		if (mode != _controllerMap[deviceId]->_micLight)
+		auto device = findDevice(deviceId);
+		if (device && mode != device->_micLight)
 		{
-			_controllerMap[deviceId]->_micLight = mode;
+			device->_micLight = mode;
 
-			_controllerMap[deviceId]->SendEffect();
+			device->SendEffect();
 		}
 	}
 };
@@ -0,0 +1,72 @@
+#include "SensorClock.h"
+#include <cmath>
+
+namespace
+{
+// A gap this many intervals long means reports were lost
+constexpr double kDropRatio = 1.5;
+// How fast the usual interval follows the reports
+constexpr double kIntervalRate = 0.05;
+// After this many long gaps in a row, nothing was lost: the reports come less often
+constexpr int kRateChangeGaps = 8;
+} // namespace
+
+bool SensorClock::step(uint64_t timestampNs, float &deltaTime)
+{
+	deltaTime = 0.f;
+	if (!_started)
+	{
+		_started = true;
+		_lastNs = timestampNs;
+		return true;
+	}
+	if (timestampNs <= _lastNs)
+	{
+		_duplicated.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	double gapNs = double(timestampNs - _lastNs);
+	_lastNs = timestampNs;
+	deltaTime = float(gapNs / 1e9);
+
+	if (_intervalNs <= 0.0)
+	{
+		_intervalNs = gapNs;
+	}
+	else if (gapNs > _intervalNs * kDropRatio)
+	{
+		uint64_t dropped = uint64_t(std::llround(gapNs / _intervalNs)) - 1;
+		_dropped.fetch_add(dropped, std::memory_order_relaxed);
+		++_longGaps;
+		_longGapsNs += gapNs;
+		_longGapsDropped += dropped;
+		if (_longGaps == kRateChangeGaps)
+		{
+			_dropped.fetch_sub(_longGapsDropped, std::memory_order_relaxed);
+			_intervalNs = _longGapsNs / _longGaps;
+			_longGaps = 0;
+			_longGapsNs = 0.0;
+			_longGapsDropped = 0;
+		}
+	}
+	else
+	{
+		_intervalNs += (gapNs - _intervalNs) * kIntervalRate;
+		_longGaps = 0;
+		_longGapsNs = 0.0;
+		_longGapsDropped = 0;
+	}
+	return true;
+}
+
+void SensorClock::reset()
+{
+	_lastNs = 0;
+	_started = false;
+	_intervalNs = 0.0;
+	_longGaps = 0;
+	_longGapsNs = 0.0;
+	_longGapsDropped = 0;
+	_dropped = 0;
+	_duplicated = 0;
+}
@@ -1,33 +1,36 @@
 #include "SettingsManager.h"
 #include <algorithm>
-#include <ranges>
-#include <set>
 
-SettingsManager::SettingsMap SettingsManager::_settings;
+array<SettingsManager::Entry, SETTINGS_COUNT> SettingsManager::_settings;
 
-bool SettingsManager::add(SettingID id, JSMVariableBase *setting)
+bool SettingsManager::add(SettingID id, Entry entry)
 {
-	return _settings.emplace(id, setting).second;
+	if (size_t(id) >= SETTINGS_COUNT || _settings[size_t(id)].base)
+	{
+		// The caller keeps a setting that can't be held
+		entry.base.release();
+		return false;
+	}
+	_settings[size_t(id)] = std::move(entry);
+	return true;
 }
 
-
 void SettingsManager::resetAllSettings()
 {
-	static constexpr auto callReset = [](SettingsMap::value_type &kvPair)
-	{
-		kvPair.second->reset();
+	static constexpr array exceptions = {
+		SettingID::AUTOLOAD,
+		SettingID::JSM_DIRECTORY,
+		SettingID::HIDE_MINIMIZED,
+		SettingID::VIRTUAL_CONTROLLER,
+		SettingID::ADAPTIVE_TRIGGER,
+		SettingID::RUMBLE,
 	};
-	static constexpr auto exceptions = [](SettingsMap::value_type &kvPair)
+	SettingsTransaction transaction;
+	for (size_t id = 0; id < SETTINGS_COUNT; ++id)
 	{
-		static set<SettingID> exceptions = {
-			SettingID::AUTOLOAD,
-			SettingID::JSM_DIRECTORY,
-			SettingID::HIDE_MINIMIZED,
-			SettingID::VIRTUAL_CONTROLLER,
-			SettingID::ADAPTIVE_TRIGGER,
-			SettingID::RUMBLE,
-		};
-		return exceptions.find(kvPair.first) == exceptions.end();
-	};
-	ranges::for_each(_settings | views::filter(exceptions), callReset);
+		if (_settings[id].base && ranges::find(exceptions, SettingID(id)) == exceptions.end())
+		{
+			_settings[id].base->reset();
+		}
+	}
 }
@@ -0,0 +1,72 @@
+#include "SettingsTransaction.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// Transactions that are being committed stay listed until they're done, so that owners deleted by a
+// notification are forgotten by them too. Notifications run after their transaction, so a transaction they
+// open is a new one.
+struct Transaction
+{
+	int depth = 1;
+	std::unordered_map<const void *, std::function<void()>> pending;
+	std::vector<const void *> order;
+	Transaction *outer = nullptr;
+};
+
+thread_local Transaction *transaction = nullptr;
+} // namespace
+
+SettingsTransaction::SettingsTransaction()
+{
+	if (transaction && transaction->depth > 0)
+	{
+		++transaction->depth;
+	}
+	else
+	{
+		transaction = new Transaction{ .outer = transaction };
+	}
+}
+
+SettingsTransaction::~SettingsTransaction()
+{
+	if (--transaction->depth > 0)
+	{
+		return;
+	}
+	std::unique_ptr<Transaction> committed(transaction);
+	for (auto owner : committed->order)
+	{
+		auto pending = committed->pending.find(owner);
+		if (pending != committed->pending.end())
+		{
+			auto notify = std::move(pending->second);
+			committed->pending.erase(pending);
+			notify();
+		}
+	}
+	transaction = committed->outer;
+}
+
+void SettingsTransaction::notify(const void *owner, std::function<void()> notify)
+{
+	if (!transaction || transaction->depth == 0)
+	{
+		notify();
+	}
+	else if (transaction->pending.try_emplace(owner, std::move(notify)).second)
+	{
+		transaction->order.push_back(owner);
+	}
+}
+
+void SettingsTransaction::forget(const void *owner)
+{
+	for (auto open = transaction; open; open = open->outer)
+	{
+		open->pending.erase(owner);
+	}
+}
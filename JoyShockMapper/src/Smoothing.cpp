@@ -0,0 +1,55 @@
+#include "Smoothing.h"
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+// Smoothing factor of a first order low pass with the given cutoff frequency
+float lowPassAlpha(float cutoff, float deltaTime)
+{
+	float tau = 1.f / (2.f * std::numbers::pi_v<float> * cutoff);
+	return deltaTime / (deltaTime + tau);
+}
+} // namespace
+
+float ExponentialFilter::apply(float value, float timeConstant, float deltaTime)
+{
+	if (!_primed || timeConstant <= 0.f || deltaTime <= 0.f)
+	{
+		_primed = true;
+		_value = value;
+		return _value;
+	}
+	float alpha = 1.f - std::exp(-deltaTime / timeConstant);
+	_value += alpha * (value - _value);
+	return _value;
+}
+
+void ExponentialFilter::reset()
+{
+	_value = 0.f;
+	_primed = false;
+}
+
+float OneEuroFilter::apply(float value, float minCutoff, float beta, float deltaTime)
+{
+	if (!_primed || minCutoff <= 0.f || deltaTime <= 0.f)
+	{
+		_primed = true;
+		_value = value;
+		_derivative = 0.f;
+		return _value;
+	}
+	float derivative = (value - _value) / deltaTime;
+	_derivative += lowPassAlpha(DERIVATIVE_CUTOFF, deltaTime) * (derivative - _derivative);
+	float cutoff = minCutoff + beta * std::abs(_derivative);
+	_value += lowPassAlpha(cutoff, deltaTime) * (value - _value);
+	return _value;
+}
+
+void OneEuroFilter::reset()
+{
+	_value = 0.f;
+	_derivative = 0.f;
+	_primed = false;
+}
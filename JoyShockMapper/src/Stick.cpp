@@ -1,6 +1,7 @@
 #include <cmath>
 #include "Stick.h"
 #include "JSMVariable.hpp"
+#include "InputHelpers.h"
 
 extern vector<JSMButton> grid_mappings;
 extern vector<JSMButton> mappings;
@@ -12,11 +13,41 @@ void ScrollAxis::init(DigitalButton& negativeBtn, DigitalButton& positiveBtn, in
 	_touchpadId = touchpadId;
 }
 
-void ScrollAxis::processScroll(float distance, float sens, chrono::steady_clock::time_point now)
+// The binding a press of the button would use now, picked like DigitalButton does
+static const Mapping *activeBinding(ButtonID id, const deque<ButtonID> &chordStack)
+{
+	const JSMButton &button = mappings[int(id)];
+	for (auto chord : chordStack)
+	{
+		if (chord == id)
+			continue;
+		if (chord == ButtonID::NONE)
+			return &button.value();
+		if (auto chorded = button.atChord(chord))
+			return &chorded->value();
+	}
+	return nullptr;
+}
+
+void ScrollAxis::processScroll(float distance, float sens, bool hiRes, chrono::steady_clock::time_point now, const deque<ButtonID> &chordStack, MouseRemainder &remainder)
 {
 	if (!_negativeButton || !_positiveButton)
 		return; // not initalized!
 
+	auto negativeBinding = hiRes ? activeBinding(_negativeButton->_id, chordStack) : nullptr;
+	auto positiveBinding = hiRes ? activeBinding(_positiveButton->_id, chordStack) : nullptr;
+	int notch = negativeBinding ? negativeBinding->wheelNotch() : 0;
+	if (notch != 0 && positiveBinding && positiveBinding->wheelNotch() == -notch && sens > 0.f)
+	{
+		if (_pressedBtn != ButtonID::NONE)
+		{
+			reset(now);
+		}
+		// Distance that would press the negative button scrolls its way
+		scrollMouse(0.f, distance / sens * notch, remainder);
+		return;
+	}
+
 	_leftovers += distance;
 	//if (distance != 0)
 	//	DEBUG_LOG << " leftover is now " << _leftovers << '\n';
@@ -1,10 +1,13 @@
 #include "Telemetry.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstring>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -29,7 +32,54 @@ constexpr SocketHandle kInvalidSocket = -1;
 #endif
 
 constexpr const char *kLoopback = "127.0.0.1";
+constexpr auto kDrainPeriod = std::chrono::milliseconds(2);
+constexpr auto kMinIntervalTicks = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+  std::chrono::microseconds(1000000 / Telemetry::kMaxRateHz)).count();
 
+// Single producer, single consumer queue. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+	bool push(const T &item)
+	{
+		const auto head = _head.load(std::memory_order_relaxed);
+		if (head - _tail.load(std::memory_order_acquire) == Capacity)
+		{
+			return false; // full, drop
+		}
+		_slots[head & (Capacity - 1)] = item;
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T &item)
+	{
+		const auto tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire))
+		{
+			return false; // empty
+		}
+		item = _slots[tail & (Capacity - 1)];
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	void clear()
+	{
+		_tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+private:
+	std::array<T, Capacity> _slots{};
+	alignas(64) std::atomic<size_t> _head = 0;
+	alignas(64) std::atomic<size_t> _tail = 0;
+};
+
+// The input threads only copy samples into a ring buffer. Encoding and the socket
+// calls all happen on the sender thread.
 class TelemetryEmitter
 {
 public:
@@ -39,46 +89,196 @@ public:
 		return emitter;
 	}
 
-	void configure(bool enabled, uint16_t port)
+	~TelemetryEmitter()
+	{
+		shutdown();
+	}
+
+	void setRoster(const TelemetryRoster &roster)
+	{
+		std::lock_guard guard(_rosterLock);
+		_roster = roster;
+		_rosterDirty = true;
+	}
+
+	bool isSendDue() const
+	{
+		return _enabled.load(std::memory_order_relaxed) &&
+		  std::chrono::steady_clock::now().time_since_epoch().count() >= _nextSendTicks.load(std::memory_order_relaxed);
+	}
+
+	void configure(bool enabled, uint16_t port, bool jsonFormat)
 	{
-		if (_enabled == enabled && (!_enabled || port == _port))
+		_port = port;
+		_jsonFormat = jsonFormat;
+		if (enabled)
 		{
-			return;
+			startSender();
+		}
+		else
+		{
+			stopSender();
 		}
-
 		_enabled = enabled;
-		_port = port;
-		_nextSend = std::chrono::steady_clock::time_point::min();
-		closeSocket();
 	}
 
 	void shutdown()
 	{
 		_enabled = false;
-		closeSocket();
+		stopSender();
 	}
 
 	void maybeSend(const TelemetrySample &sample)
 	{
-		if (!_enabled)
+		if (!_enabled.load(std::memory_order_relaxed))
 		{
 			return;
 		}
 
-		const auto now = std::chrono::steady_clock::now();
-		const auto minInterval = std::chrono::microseconds(1000000 / Telemetry::kMaxRateHz);
-		if (now < _nextSend)
+		// With JSL each device polls on its own thread. Rather than blocking, a sample
+		// arriving while another thread is pushing is simply dropped.
+		if (_producerBusy.test_and_set(std::memory_order_acquire))
 		{
 			return;
 		}
 
-		if (!ensureSocket())
+		const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+		if (now >= _nextSendTicks.load(std::memory_order_relaxed))
+		{
+			_nextSendTicks.store(now + kMinIntervalTicks, std::memory_order_relaxed);
+			_ring.push(sample);
+		}
+		_producerBusy.clear(std::memory_order_release);
+	}
+
+private:
+	void startSender()
+	{
+		if (_sender.joinable())
 		{
 			return;
 		}
+		_ring.clear();
+		_nextSendTicks = 0;
+		{
+			std::lock_guard guard(_rosterLock);
+			_rosterDirty = true;
+		}
+		_running = true;
+		_sender = std::thread(&TelemetryEmitter::senderLoop, this);
+	}
+
+	void stopSender()
+	{
+		_running = false;
+		if (_sender.joinable())
+		{
+			_sender.join();
+		}
+	}
+
+	void senderLoop()
+	{
+		TelemetrySample sample;
+		TelemetryRoster roster;
+		auto nextRoster = std::chrono::steady_clock::now();
+		while (_running)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			bool sendRoster = now >= nextRoster;
+			{
+				std::lock_guard guard(_rosterLock);
+				sendRoster |= _rosterDirty;
+				if (sendRoster)
+				{
+					roster = _roster;
+					_rosterDirty = false;
+				}
+			}
+			if (sendRoster && ensureSocket())
+			{
+				send(roster);
+				nextRoster = now + std::chrono::milliseconds(Telemetry::kRosterRefreshMs);
+			}
+			while (_ring.pop(sample))
+			{
+				if (ensureSocket())
+				{
+					send(sample);
+				}
+			}
+			std::this_thread::sleep_for(kDrainPeriod);
+		}
+		closeSocket();
+	}
+
+	void send(const TelemetrySample &sample)
+	{
+		if (_jsonFormat)
+		{
+			const auto payload = encodeJson(sample);
+			sendto(_socket, payload.c_str(), static_cast<int>(payload.size()), 0, reinterpret_cast<sockaddr *>(&_target), sizeof(_target));
+		}
+		else
+		{
+			Telemetry::Wire::Sample packet;
+			const auto size = encodeBinary(sample, packet);
+			sendto(_socket, reinterpret_cast<const char *>(&packet), static_cast<int>(size), 0, reinterpret_cast<sockaddr *>(&_target), sizeof(_target));
+		}
+	}
+
+	void send(const TelemetryRoster &roster)
+	{
+		if (_jsonFormat)
+		{
+			const auto payload = encodeJson(roster);
+			sendto(_socket, payload.c_str(), static_cast<int>(payload.size()), 0, reinterpret_cast<sockaddr *>(&_target), sizeof(_target));
+		}
+		else
+		{
+			Telemetry::Wire::Roster packet;
+			const auto size = encodeBinary(roster, packet);
+			sendto(_socket, reinterpret_cast<const char *>(&packet), static_cast<int>(size), 0, reinterpret_cast<sockaddr *>(&_target), sizeof(_target));
+		}
+	}
+
+	static size_t encodeBinary(const TelemetrySample &sample, Telemetry::Wire::Sample &packet)
+	{
+		packet = Telemetry::Wire::Sample{};
+		packet.header.type = static_cast<uint16_t>(Telemetry::Wire::PacketType::SAMPLE);
+		packet.timestampMs = sample.timestampMs;
+		packet.omega = sample.omega;
+		packet.normalized = sample.normalized;
+		packet.sensX = sample.sensX;
+		packet.sensY = sample.sensY;
+		packet.minThreshold = sample.minThreshold;
+		packet.maxThreshold = sample.maxThreshold;
+		packet.sMinX = sample.sMinX;
+		packet.sMaxX = sample.sMaxX;
+		packet.sMinY = sample.sMinY;
+		packet.sMaxY = sample.sMaxY;
+		if (sample.curve)
+		{
+			std::strncpy(packet.curve, sample.curve, sizeof(packet.curve) - 1);
+		}
+		return sizeof(packet);
+	}
 
-		_nextSend = now + minInterval;
+	static size_t encodeBinary(const TelemetryRoster &roster, Telemetry::Wire::Roster &packet)
+	{
+		packet = Telemetry::Wire::Roster{};
+		packet.header.type = static_cast<uint16_t>(Telemetry::Wire::PacketType::ROSTER);
+		packet.deviceCount = static_cast<uint32_t>(std::min<size_t>(roster.deviceCount, roster.devices.size()));
+		for (uint32_t i = 0; i < packet.deviceCount; ++i)
+		{
+			const auto &dev = roster.devices[i];
+			packet.devices[i] = { dev.handle, dev.controllerType, dev.splitType, dev.vendorId, dev.productId };
+		}
+		return offsetof(Telemetry::Wire::Roster, devices) + packet.deviceCount * sizeof(Telemetry::Wire::Device);
+	}
 
+	static std::string encodeJson(const TelemetrySample &sample)
+	{
 		std::ostringstream oss;
 		oss.setf(std::ios::fixed, std::ios::floatfield);
 		oss.precision(4);
@@ -95,45 +295,43 @@ public:
 		    << ",\"SmaxX\":" << sample.sMaxX
 		    << ",\"SminY\":" << sample.sMinY
 		    << ",\"SmaxY\":" << sample.sMaxY
-		    << ",\"curve\":\"" << sample.curve << "\""
-		    << ",\"params\":" << (sample.paramsJson.empty() ? "{}" : sample.paramsJson);
+		    << ",\"curve\":\"" << (sample.curve ? sample.curve : "LINEAR") << "\""
+		    << ",\"params\":{}"
+		    << "}";
+		return oss.str();
+	}
 
-		if (!sample.devices.empty())
+	static std::string encodeJson(const TelemetryRoster &roster)
+	{
+		std::ostringstream oss;
+		oss << "{"
+		    << "\"protoVer\":" << Telemetry::kProtoVersion
+		    << ",\"type\":\"roster\""
+		    << ",\"devices\":[";
+		const auto deviceCount = std::min<size_t>(roster.deviceCount, roster.devices.size());
+		for (size_t i = 0; i < deviceCount; ++i)
 		{
-			oss << ",\"devices\":[";
-			for (size_t i = 0; i < sample.devices.size(); ++i)
+			const auto &dev = roster.devices[i];
+			if (i > 0)
 			{
-				const auto &dev = sample.devices[i];
-				if (i > 0)
-				{
-					oss << ",";
-				}
-				oss << "{"
-				    << "\"handle\":" << dev.handle
-				    << ",\"type\":" << dev.controllerType
-				    << ",\"split\":" << dev.splitType
-				    << ",\"vid\":" << dev.vendorId
-				    << ",\"pid\":" << dev.productId
-				    << "}";
+				oss << ",";
 			}
-			oss << "]";
+			oss << "{"
+			    << "\"handle\":" << dev.handle
+			    << ",\"type\":" << dev.controllerType
+			    << ",\"split\":" << dev.splitType
+			    << ",\"vid\":" << dev.vendorId
+			    << ",\"pid\":" << dev.productId
+			    << "}";
 		}
-
-		oss << "}";
-
-		const auto payload = oss.str();
-		sendto(_socket, payload.c_str(), static_cast<int>(payload.size()), 0, reinterpret_cast<sockaddr *>(&_target), sizeof(_target));
+		oss << "]}";
+		return oss.str();
 	}
 
-private:
 	bool ensureSocket()
 	{
-		if (!_enabled)
-		{
-			return false;
-		}
-
-		if (_socket != kInvalidSocket && ntohs(_target.sin_port) == _port)
+		const uint16_t port = _port;
+		if (_socket != kInvalidSocket && ntohs(_target.sin_port) == port)
 		{
 			return true;
 		}
@@ -160,7 +358,7 @@ private:
 
 		std::memset(&_target, 0, sizeof(_target));
 		_target.sin_family = AF_INET;
-		_target.sin_port = htons(_port);
+		_target.sin_port = htons(port);
 #ifdef _WIN32
 		if (InetPtonA(AF_INET, kLoopback, &_target.sin_addr) != 1)
 		{
@@ -178,6 +376,7 @@ private:
 		return true;
 	}
 
+	// Only called from the sender thread
 	void closeSocket()
 	{
 		if (_socket != kInvalidSocket)
@@ -198,11 +397,19 @@ private:
 #endif
 	}
 
-	bool _enabled = false;
-	uint16_t _port = Telemetry::kDefaultPort;
+	std::atomic_bool _enabled = false;
+	std::atomic<uint16_t> _port = Telemetry::kDefaultPort;
+	std::atomic_bool _jsonFormat = false;
+	std::atomic_bool _running = false;
+	std::atomic_flag _producerBusy = ATOMIC_FLAG_INIT;
+	std::thread _sender;
+	SpscRing<TelemetrySample, 64> _ring;
 	SocketHandle _socket = kInvalidSocket;
 	sockaddr_in _target {};
-	std::chrono::steady_clock::time_point _nextSend = std::chrono::steady_clock::time_point::min();
+	std::atomic<std::chrono::steady_clock::rep> _nextSendTicks = 0;
+	std::mutex _rosterLock;
+	TelemetryRoster _roster;
+	bool _rosterDirty = true;
 #ifdef _WIN32
 	bool _wsaStarted = false;
 #endif
@@ -219,9 +426,9 @@ uint64_t TimestampNowMs()
 namespace Telemetry
 {
 
-void Configure(bool enabled, uint16_t port)
+void Configure(bool enabled, uint16_t port, bool jsonFormat)
 {
-	TelemetryEmitter::Instance().configure(enabled, port);
+	TelemetryEmitter::Instance().configure(enabled, port, jsonFormat);
 }
 
 void Shutdown()
@@ -229,6 +436,11 @@ void Shutdown()
 	TelemetryEmitter::Instance().shutdown();
 }
 
+bool IsSendDue()
+{
+	return TelemetryEmitter::Instance().isSendDue();
+}
+
 void MaybeSend(const TelemetrySample &sample)
 {
 	TelemetrySample enriched = sample;
@@ -239,4 +451,9 @@ void MaybeSend(const TelemetrySample &sample)
 	TelemetryEmitter::Instance().maybeSend(enriched);
 }
 
+void SetRoster(const TelemetryRoster &roster)
+{
+	TelemetryEmitter::Instance().setRoster(roster);
+}
+
 } // namespace Telemetry
@@ -0,0 +1,1184 @@
+#include "linux/EvdevWrapper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+
+using namespace Evdev;
+
+template<size_t N>
+using Bits = std::array<uint8_t, N / 8 + 1>;
+
+template<size_t N>
+bool testBit(const Bits<N> &bits, int bit)
+{
+	return (bits[bit / 8] >> (bit % 8)) & 1;
+}
+
+// hid-playstation and hid-nintendo name the buttons by position, like JSM
+constexpr std::pair<int, int> evdev2jsl[] = {
+	{ BTN_SOUTH, JSOFFSET_S },
+	{ BTN_EAST, JSOFFSET_E },
+	{ BTN_WEST, JSOFFSET_W },
+	{ BTN_NORTH, JSOFFSET_N },
+	{ BTN_SELECT, JSOFFSET_MINUS },
+	{ BTN_START, JSOFFSET_PLUS },
+	{ BTN_MODE, JSOFFSET_HOME },
+	{ BTN_THUMBL, JSOFFSET_LCLICK },
+	{ BTN_THUMBR, JSOFFSET_RCLICK },
+	{ BTN_DPAD_UP, JSOFFSET_UP },
+	{ BTN_DPAD_DOWN, JSOFFSET_DOWN },
+	{ BTN_DPAD_LEFT, JSOFFSET_LEFT },
+	{ BTN_DPAD_RIGHT, JSOFFSET_RIGHT },
+	{ BTN_Z, JSOFFSET_CAPTURE },
+};
+
+void setButton(int &buttons, int offset, bool pressed)
+{
+	buttons = pressed ? buttons | (1 << offset) : buttons & ~(1 << offset);
+}
+
+} // namespace
+
+namespace Evdev
+{
+
+int ControllerType(int vendorId, int productId)
+{
+	if (vendorId == 0x054C)
+	{
+		switch (productId)
+		{
+		case 0x05C4:
+		case 0x09CC:
+		case 0x0BA0:
+			return JS_TYPE_DS4;
+		case 0x0CE6:
+		case 0x0DF2:
+			return JS_TYPE_DS;
+		}
+	}
+	else if (vendorId == 0x057E)
+	{
+		switch (productId)
+		{
+		case 0x2006:
+			return JS_TYPE_JOYCON_LEFT;
+		case 0x2007:
+			return JS_TYPE_JOYCON_RIGHT;
+		case 0x2009:
+			return JS_TYPE_PRO_CONTROLLER;
+		}
+	}
+	return 0;
+}
+
+uint64_t EventNs(const input_event &event)
+{
+	return uint64_t(event.input_event_sec) * 1000000000ull + uint64_t(event.input_event_usec) * 1000ull;
+}
+
+Decoder::Decoder(int controllerType)
+  : _controllerType(controllerType)
+{
+}
+
+void Decoder::setRange(NodeRole role, int code, const input_absinfo &info)
+{
+	if (code < 0 || code >= int(kAxes))
+	{
+		return;
+	}
+	auto &range = _ranges[size_t(role)][code];
+	range.min = info.minimum;
+	range.max = info.maximum;
+	range.resolution = float(info.resolution);
+	if (role == NodeRole::GAMEPAD && (code == ABS_Z || code == ABS_RZ))
+	{
+		_analogTriggers = true;
+	}
+}
+
+bool Decoder::feed(NodeRole role, const input_event &event)
+{
+	size_t index = size_t(role);
+	if (event.type == EV_SYN)
+	{
+		if (event.code == SYN_DROPPED)
+		{
+			_dropping[index] = true;
+			++_dropped;
+		}
+		else if (event.code == SYN_REPORT)
+		{
+			if (_dropping[index])
+			{
+				// The events up to here are incomplete
+				_dropping[index] = false;
+				_resync[index] = true;
+				_hasSensorTime = false;
+				return false;
+			}
+			if (role == NodeRole::MOTION)
+			{
+				endMotionReport(EventNs(event));
+			}
+			return true;
+		}
+		return false;
+	}
+	if (_dropping[index])
+	{
+		return false;
+	}
+	switch (event.type)
+	{
+	case EV_KEY:
+		feedKey(role, event.code, event.value != 0);
+		break;
+	case EV_ABS:
+		feedAbs(role, event.code, event.value);
+		break;
+	case EV_MSC:
+		if (role == NodeRole::MOTION && event.code == MSC_TIMESTAMP)
+		{
+			_sensorTime = uint32_t(event.value);
+			_hasSensorTime = true;
+		}
+		break;
+	}
+	return false;
+}
+
+bool Decoder::needsResync(NodeRole role) const
+{
+	return _resync[size_t(role)];
+}
+
+void Decoder::resynced(NodeRole role)
+{
+	_resync[size_t(role)] = false;
+}
+
+int Decoder::takeReports(TimedImuState *reports, int maxReports)
+{
+	int count = std::min(int(_reportCount), maxReports);
+	std::copy_n(_reports.begin(), count, reports);
+	_reportCount = 0;
+	return count;
+}
+
+// Sticks from -1 to 1, and triggers and touches from 0 to 1
+float Decoder::normalized(NodeRole role, int code, int value) const
+{
+	const auto &range = _ranges[size_t(role)][code];
+	if (range.max <= range.min)
+	{
+		return 0.f;
+	}
+	float unit = float(value - range.min) / float(range.max - range.min);
+	bool centered = role == NodeRole::GAMEPAD && code != ABS_Z && code != ABS_RZ;
+	return centered ? 2.f * unit - 1.f : unit;
+}
+
+void Decoder::feedKey(NodeRole role, int code, bool pressed)
+{
+	if (role == NodeRole::TOUCHPAD)
+	{
+		if (code == BTN_LEFT)
+		{
+			setButton(_frame.buttons, JSOFFSET_TOUCHPAD_CLICK, pressed);
+		}
+		return;
+	}
+	if (role != NodeRole::GAMEPAD)
+	{
+		return;
+	}
+	// hid-nintendo reports SL and SR of a single Joy-Con as the shoulder buttons of the missing side
+	bool left = _controllerType == JS_TYPE_JOYCON_LEFT;
+	bool right = _controllerType == JS_TYPE_JOYCON_RIGHT;
+	switch (code)
+	{
+	case BTN_TL:
+		setButton(_frame.buttons, right ? JSOFFSET_SL : JSOFFSET_L, pressed);
+		return;
+	case BTN_TR:
+		setButton(_frame.buttons, left ? JSOFFSET_SL : JSOFFSET_R, pressed);
+		return;
+	case BTN_TL2:
+		if (right)
+			setButton(_frame.buttons, JSOFFSET_SR, pressed);
+		else if (!_analogTriggers)
+			_frame.leftTrigger = pressed ? 1.f : 0.f;
+		return;
+	case BTN_TR2:
+		if (left)
+			setButton(_frame.buttons, JSOFFSET_SR, pressed);
+		else if (!_analogTriggers)
+			_frame.rightTrigger = pressed ? 1.f : 0.f;
+		return;
+	}
+	for (auto [evdevCode, offset] : evdev2jsl)
+	{
+		if (evdevCode == code)
+		{
+			setButton(_frame.buttons, offset, pressed);
+			return;
+		}
+	}
+}
+
+void Decoder::feedAbs(NodeRole role, int code, int value)
+{
+	if (code < 0 || code >= int(kAxes))
+	{
+		return;
+	}
+	switch (role)
+	{
+	case NodeRole::GAMEPAD:
+		switch (code)
+		{
+		case ABS_X:
+			_frame.leftX = normalized(role, code, value);
+			break;
+		case ABS_Y:
+			_frame.leftY = -normalized(role, code, value); // Up is negative on evdev
+			break;
+		case ABS_RX:
+			_frame.rightX = normalized(role, code, value);
+			break;
+		case ABS_RY:
+			_frame.rightY = -normalized(role, code, value);
+			break;
+		case ABS_Z:
+			_frame.leftTrigger = normalized(role, code, value);
+			break;
+		case ABS_RZ:
+			_frame.rightTrigger = normalized(role, code, value);
+			break;
+		case ABS_HAT0X:
+			setButton(_frame.buttons, JSOFFSET_LEFT, value < 0);
+			setButton(_frame.buttons, JSOFFSET_RIGHT, value > 0);
+			break;
+		case ABS_HAT0Y:
+			setButton(_frame.buttons, JSOFFSET_UP, value < 0);
+			setButton(_frame.buttons, JSOFFSET_DOWN, value > 0);
+			break;
+		}
+		break;
+	case NodeRole::MOTION:
+	{
+		// The resolution is in units per g for the accelerometer and per degree per second for the gyro
+		float resolution = _ranges[size_t(role)][code].resolution;
+		float scaled = resolution > 0.f ? float(value) / resolution : float(value);
+		switch (code)
+		{
+		case ABS_X:
+			_frame.imu.accelX = scaled;
+			break;
+		case ABS_Y:
+			_frame.imu.accelY = scaled;
+			break;
+		case ABS_Z:
+			_frame.imu.accelZ = scaled;
+			break;
+		case ABS_RX:
+			_frame.imu.gyroX = scaled;
+			break;
+		case ABS_RY:
+			_frame.imu.gyroY = scaled;
+			break;
+		case ABS_RZ:
+			_frame.imu.gyroZ = scaled;
+			break;
+		}
+		break;
+	}
+	case NodeRole::TOUCHPAD:
+		switch (code)
+		{
+		case ABS_MT_SLOT:
+			_slot = value;
+			break;
+		case ABS_MT_TRACKING_ID:
+			if (_slot == 0)
+			{
+				_frame.touch.t0Down = value >= 0;
+				_frame.touch.t0Id = value;
+			}
+			else if (_slot == 1)
+			{
+				_frame.touch.t1Down = value >= 0;
+				_frame.touch.t1Id = value;
+			}
+			break;
+		case ABS_MT_POSITION_X:
+			if (_slot == 0)
+				_frame.touch.t0X = normalized(role, code, value);
+			else if (_slot == 1)
+				_frame.touch.t1X = normalized(role, code, value);
+			break;
+		case ABS_MT_POSITION_Y:
+			if (_slot == 0)
+				_frame.touch.t0Y = normalized(role, code, value);
+			else if (_slot == 1)
+				_frame.touch.t1Y = normalized(role, code, value);
+			break;
+		}
+		break;
+	}
+}
+
+void Decoder::endMotionReport(uint64_t eventNs)
+{
+	// The sensor's own clock is better than the time the kernel got the report, when there is one
+	if (_lastMotionNs == 0)
+	{
+		_motionTimeNs = eventNs;
+	}
+	else if (_hasSensorTime && _hasLastSensorTime)
+	{
+		_motionTimeNs += uint64_t(uint32_t(_sensorTime - _lastSensorTime)) * 1000; // Wraps around
+	}
+	else if (eventNs > _lastMotionNs)
+	{
+		_motionTimeNs += eventNs - _lastMotionNs;
+	}
+	_lastSensorTime = _sensorTime;
+	_hasLastSensorTime = _hasSensorTime;
+	_hasSensorTime = false;
+	_lastMotionNs = eventNs;
+	_frame.timestamp = eventNs;
+
+	float deltaTime = 0.f;
+	if (!_clock.step(_motionTimeNs, deltaTime))
+	{
+		return; // Same time as the previous report
+	}
+	TimedImuState report{ _frame.imu, deltaTime };
+	if (_reportCount < _reports.size())
+	{
+		_reports[_reportCount++] = report;
+	}
+	else
+	{
+		// Nobody is consuming the reports. Keep the latest one without losing the elapsed time.
+		report.deltaTime += _reports.back().deltaTime;
+		_reports.back() = report;
+	}
+}
+
+} // namespace Evdev
+
+namespace
+{
+
+struct EvdevDevice;
+
+struct Node
+{
+	~Node()
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+
+	NodeRole role = NodeRole::GAMEPAD;
+	int fd = -1;
+	bool writable = false;
+	EvdevDevice *device = nullptr;
+	std::vector<int> keys; // Key codes and axes the node has, to read its state again after dropped events
+	std::vector<int> axes;
+};
+
+struct EvdevDevice
+{
+	explicit EvdevDevice(int type)
+	  : decoder(type)
+	{
+	}
+
+	int handle = 0;
+	int controllerType = 0;
+	int splitType = JS_SPLIT_TYPE_FULL;
+	int vendorId = JS_VENDOR_UNKNOWN;
+	int productId = JS_PRODUCT_UNKNOWN;
+	std::string serial;
+	Decoder decoder;
+	std::vector<std::unique_ptr<Node>> nodes;
+	Node *gamepad = nullptr;
+	bool hasMotion = false;
+	bool hasTouchpad = false;
+	bool connected = true;
+
+	bool reported = false; // A report ended since the last callback
+	uint64_t reportNs = 0;
+	uint64_t callbackNs = 0;
+	TOUCH_STATE prevTouch{};
+
+	bool canRumble = false;
+	int rumbleId = -1;
+	uint16_t smallRumble = 0;
+	uint16_t bigRumble = 0;
+	uint16_t sentSmallRumble = 0;
+	uint16_t sentBigRumble = 0;
+};
+
+// An event node of a supported controller
+struct Probe
+{
+	std::unique_ptr<Node> node;
+	input_id id{};
+	std::string group;  // Same for all the nodes of a controller
+	std::string serial; // The Bluetooth address for hid-playstation and hid-nintendo, when there is one
+};
+
+std::string groupOf(const std::string &path, int fd)
+{
+	// The nodes of a controller share the HID device they were made from
+	std::error_code error;
+	auto eventName = std::filesystem::path(path).filename().string();
+	auto parent = std::filesystem::canonical("/sys/class/input/" + eventName + "/device/device", error);
+	if (!error)
+	{
+		return parent.string();
+	}
+	// Devices made with uinput have no parent
+	char text[256]{};
+	if (ioctl(fd, EVIOCGPHYS(sizeof(text) - 1), text) > 0 && text[0] != '\0')
+	{
+		return std::string("phys:") + text;
+	}
+	memset(text, 0, sizeof(text));
+	ioctl(fd, EVIOCGNAME(sizeof(text) - 1), text);
+	std::string name(text);
+	for (std::string_view suffix : { " Motion Sensors", " Touchpad", " IMU" })
+	{
+		if (name.ends_with(suffix))
+		{
+			name.resize(name.size() - suffix.size());
+		}
+	}
+	return "name:" + name;
+}
+
+std::optional<Probe> probe(const std::string &path)
+{
+	Probe probe;
+	probe.node = std::make_unique<Node>();
+	auto &node = *probe.node;
+	// Writing is only needed for rumble
+	node.fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	node.writable = node.fd >= 0;
+	if (node.fd < 0)
+	{
+		node.fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	}
+	if (node.fd < 0 || ioctl(node.fd, EVIOCGID, &probe.id) < 0 || ControllerType(probe.id.vendor, probe.id.product) == 0)
+	{
+		return std::nullopt;
+	}
+
+	Bits<INPUT_PROP_MAX> properties{};
+	Bits<KEY_MAX> keys{};
+	Bits<ABS_MAX> axes{};
+	ioctl(node.fd, EVIOCGPROP(sizeof(properties)), properties.data());
+	ioctl(node.fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys.data());
+	ioctl(node.fd, EVIOCGBIT(EV_ABS, sizeof(axes)), axes.data());
+	for (int code = 0; code <= KEY_MAX; ++code)
+	{
+		if (testBit<KEY_MAX>(keys, code))
+			node.keys.push_back(code);
+	}
+	for (int code = 0; code <= ABS_MAX; ++code)
+	{
+		if (testBit<ABS_MAX>(axes, code))
+			node.axes.push_back(code);
+	}
+
+	if (testBit<INPUT_PROP_MAX>(properties, INPUT_PROP_ACCELEROMETER))
+	{
+		node.role = NodeRole::MOTION;
+	}
+	else if (testBit<ABS_MAX>(axes, ABS_MT_POSITION_X))
+	{
+		node.role = NodeRole::TOUCHPAD;
+	}
+	else if (testBit<KEY_MAX>(keys, BTN_SOUTH) || testBit<KEY_MAX>(keys, BTN_DPAD_UP) || testBit<KEY_MAX>(keys, BTN_TL))
+	{
+		node.role = NodeRole::GAMEPAD;
+	}
+	else
+	{
+		return std::nullopt;
+	}
+	// Use the same clock as steady_clock for the event timestamps
+	int clock = CLOCK_MONOTONIC;
+	ioctl(node.fd, EVIOCSCLOCKID, &clock);
+	probe.group = groupOf(path, node.fd);
+	char uniq[64]{};
+	if (ioctl(node.fd, EVIOCGUNIQ(sizeof(uniq) - 1), uniq) > 0)
+	{
+		probe.serial = uniq;
+	}
+	return probe;
+}
+
+std::vector<Probe> scan()
+{
+	std::vector<std::string> paths;
+	std::error_code error;
+	for (auto &entry : std::filesystem::directory_iterator("/dev/input", error))
+	{
+		auto name = entry.path().filename().string();
+		if (name.starts_with("event"))
+		{
+			paths.push_back(entry.path().string());
+		}
+	}
+	// So that handles follow the order in which the controllers were plugged in
+	std::sort(paths.begin(), paths.end(), [](const std::string &lhs, const std::string &rhs)
+	  { return lhs.size() != rhs.size() ? lhs.size() < rhs.size() : lhs < rhs; });
+	std::vector<Probe> probes;
+	for (auto &path : paths)
+	{
+		if (auto found = probe(path))
+		{
+			probes.push_back(std::move(*found));
+		}
+	}
+	return probes;
+}
+
+// Polls every node with one epoll set, and runs the callbacks of a device when a report of one of its nodes ends.
+// The devices are only changed while the polling thread is stopped, and the getters are meant to be called
+// from the callbacks.
+class EvdevInstance : public JslWrapper
+{
+public:
+	EvdevInstance()
+	{
+		_epoll = epoll_create1(EPOLL_CLOEXEC);
+		_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.ptr = nullptr;
+		epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &event);
+	}
+
+	~EvdevInstance() override
+	{
+		stop();
+		_devices.clear();
+		close(_wake);
+		close(_epoll);
+	}
+
+	int ConnectDevices() override
+	{
+		stop();
+		_devices.clear(); // Closing the nodes takes them out of the epoll set
+
+		std::map<std::string, EvdevDevice *> groups;
+		for (auto &probe : scan())
+		{
+			auto &device = groups[probe.group];
+			if (!device)
+			{
+				int type = ControllerType(probe.id.vendor, probe.id.product);
+				_devices.push_back(std::make_unique<EvdevDevice>(type));
+				device = _devices.back().get();
+				device->controllerType = type;
+				device->splitType = type == JS_TYPE_JOYCON_LEFT ? JS_SPLIT_TYPE_LEFT :
+				  type == JS_TYPE_JOYCON_RIGHT                  ? JS_SPLIT_TYPE_RIGHT :
+				                                                  JS_SPLIT_TYPE_FULL;
+				device->vendorId = probe.id.vendor;
+				device->productId = probe.id.product;
+			}
+			if (device->serial.empty())
+			{
+				device->serial = probe.serial;
+			}
+			addNode(*device, std::move(probe.node));
+		}
+		// Motion or touchpad nodes whose gamepad node can't be read are of no use
+		std::erase_if(_devices, [](auto &device) { return device->gamepad == nullptr; });
+		for (size_t i = 0; i < _devices.size(); ++i)
+		{
+			_devices[i]->handle = int(i) + 1;
+			for (auto &node : _devices[i]->nodes)
+			{
+				epoll_event event{};
+				event.events = EPOLLIN;
+				event.data.ptr = node.get();
+				epoll_ctl(_epoll, EPOLL_CTL_ADD, node->fd, &event);
+			}
+		}
+		start();
+		return int(_devices.size());
+	}
+
+	int GetDeviceCount() override
+	{
+		int count = 0;
+		for (auto &probe : scan())
+		{
+			count += probe.node->role == NodeRole::GAMEPAD;
+		}
+		return count;
+	}
+
+	int GetConnectedDeviceHandles(int *deviceHandleArray, int size) override
+	{
+		int count = std::min(size, int(_devices.size()));
+		for (int i = 0; i < count; ++i)
+		{
+			deviceHandleArray[i] = _devices[i]->handle;
+		}
+		return count;
+	}
+
+	void DisconnectAndDisposeAll() override
+	{
+		stop();
+		_callback = nullptr;
+		_touchCallback = nullptr;
+		for (auto &device : _devices)
+		{
+			device->smallRumble = device->bigRumble = 0;
+			sendRumble(*device);
+		}
+		_devices.clear();
+	}
+
+	bool ProvidesTimeStep() override
+	{
+		return true;
+	}
+
+	JOY_SHOCK_STATE GetSimpleState(int deviceId) override
+	{
+		JOY_SHOCK_STATE state;
+		memset(&state, 0, sizeof(state));
+		if (auto *device = find(deviceId))
+		{
+			const auto &frame = device->decoder.frame();
+			state.buttons = frame.buttons;
+			state.lTrigger = frame.leftTrigger;
+			state.rTrigger = frame.rightTrigger;
+			state.stickLX = frame.leftX;
+			state.stickLY = frame.leftY;
+			state.stickRX = frame.rightX;
+			state.stickRY = frame.rightY;
+		}
+		return state;
+	}
+
+	IMU_STATE GetIMUState(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->decoder.frame().imu : IMU_STATE();
+	}
+
+	int GetIMUReports(int deviceId, TimedImuState *reports, int maxReports) override
+	{
+		auto *device = find(deviceId);
+		if (!device || !device->hasMotion)
+		{
+			return -1;
+		}
+		return device->decoder.takeReports(reports, maxReports);
+	}
+
+	ImuReportStats GetIMUReportStats(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->decoder.reportStats() : ImuReportStats();
+	}
+
+	bool GetDeviceFrame(int deviceId, DeviceFrame &frame) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		frame = device->decoder.frame();
+		return true;
+	}
+
+	MOTION_STATE GetMotionState(int deviceId) override
+	{
+		return MOTION_STATE();
+	}
+
+	TOUCH_STATE GetTouchState(int deviceId, bool previous = false) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return TOUCH_STATE();
+		}
+		return previous ? device->prevTouch : device->decoder.frame().touch;
+	}
+
+	bool GetTouchpadDimension(int deviceId, int &sizeX, int &sizeY) override
+	{
+		auto *device = find(deviceId);
+		if (!device)
+		{
+			return false;
+		}
+		// Same as the SDL backend
+		sizeX = device->hasTouchpad ? 1920 : 0;
+		sizeY = device->hasTouchpad ? 920 : 0;
+		return true;
+	}
+
+	int GetButtons(int deviceId) override
+	{
+		return GetSimpleState(deviceId).buttons;
+	}
+
+	float GetLeftX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLX;
+	}
+
+	float GetLeftY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickLY;
+	}
+
+	float GetRightX(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRX;
+	}
+
+	float GetRightY(int deviceId) override
+	{
+		return GetSimpleState(deviceId).stickRY;
+	}
+
+	float GetLeftTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).lTrigger;
+	}
+
+	float GetRightTrigger(int deviceId) override
+	{
+		return GetSimpleState(deviceId).rTrigger;
+	}
+
+	float GetGyroX(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroX;
+	}
+
+	float GetGyroY(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroY;
+	}
+
+	float GetGyroZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).gyroZ;
+	}
+
+	float GetAccelX(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelX;
+	}
+
+	float GetAccelY(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelY;
+	}
+
+	float GetAccelZ(int deviceId) override
+	{
+		return GetIMUState(deviceId).accelZ;
+	}
+
+	int GetTouchId(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Id : touch.t0Id;
+	}
+
+	bool GetTouchDown(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Down : touch.t0Down;
+	}
+
+	float GetTouchX(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1X : touch.t0X;
+	}
+
+	float GetTouchY(int deviceId, bool secondTouch = false) override
+	{
+		auto touch = GetTouchState(deviceId);
+		return secondTouch ? touch.t1Y : touch.t0Y;
+	}
+
+	float GetStickStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetTriggerStep(int deviceId) override
+	{
+		return float();
+	}
+
+	float GetPollRate(int deviceId) override
+	{
+		return float();
+	}
+
+	void ResetContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void StartContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void PauseContinuousCalibration(int deviceId) override
+	{
+	}
+
+	void GetCalibrationOffset(int deviceId, float &xOffset, float &yOffset, float &zOffset) override
+	{
+		xOffset = yOffset = zOffset = 0.f;
+	}
+
+	void SetCalibrationOffset(int deviceId, float xOffset, float yOffset, float zOffset) override
+	{
+	}
+
+	void SetCallback(void (*callback)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)) override
+	{
+		_callback = callback;
+	}
+
+	void SetTouchCallback(void (*callback)(int, TOUCH_STATE, TOUCH_STATE, float)) override
+	{
+		_touchCallback = callback;
+	}
+
+	int GetControllerType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->controllerType : 0;
+	}
+
+	int GetControllerSplitType(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->splitType : JS_SPLIT_TYPE_FULL;
+	}
+
+	int GetControllerVendor(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->vendorId : JS_VENDOR_UNKNOWN;
+	}
+
+	int GetControllerProduct(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->productId : JS_PRODUCT_UNKNOWN;
+	}
+
+	std::string GetControllerSerial(int deviceId) override
+	{
+		auto *device = find(deviceId);
+		return device ? device->serial : std::string();
+	}
+
+	int GetControllerColour(int deviceId) override
+	{
+		return int();
+	}
+
+	// The kernel drivers expose the lights as LED class devices rather than through evdev
+	void SetLightColour(int deviceId, int colour) override
+	{
+	}
+
+	// The next value is set here and sent after the callback returns
+	void SetRumble(int deviceId, int smallRumble, int bigRumble) override
+	{
+		if (auto *device = find(deviceId))
+		{
+			device->smallRumble = uint16_t(std::clamp(smallRumble, 0, int(UINT16_MAX)));
+			device->bigRumble = uint16_t(std::clamp(bigRumble, 0, int(UINT16_MAX)));
+		}
+	}
+
+	void SetPlayerNumber(int deviceId, int number) override
+	{
+	}
+
+private:
+	EvdevDevice *find(int deviceId)
+	{
+		return deviceId >= 1 && deviceId <= int(_devices.size()) ? _devices[deviceId - 1].get() : nullptr;
+	}
+
+	void addNode(EvdevDevice &device, std::unique_ptr<Node> node)
+	{
+		node->device = &device;
+		for (int axis : node->axes)
+		{
+			input_absinfo info;
+			if (ioctl(node->fd, EVIOCGABS(axis), &info) >= 0)
+			{
+				device.decoder.setRange(node->role, axis, info);
+			}
+		}
+		switch (node->role)
+		{
+		case NodeRole::GAMEPAD:
+		{
+			if (device.gamepad)
+			{
+				return; // Only one per controller
+			}
+			device.gamepad = node.get();
+			Bits<FF_MAX> effects{};
+			device.canRumble = node->writable && ioctl(node->fd, EVIOCGBIT(EV_FF, sizeof(effects)), effects.data()) >= 0 &&
+			  testBit<FF_MAX>(effects, FF_RUMBLE);
+			break;
+		}
+		case NodeRole::MOTION:
+			device.hasMotion = true;
+			break;
+		case NodeRole::TOUCHPAD:
+			device.hasTouchpad = true;
+			break;
+		}
+		resync(*node);
+		device.nodes.push_back(std::move(node));
+	}
+
+	// Read the whole state of the node, after dropped events or when it's opened
+	void resync(Node &node)
+	{
+		auto &decoder = node.device->decoder;
+		input_event event{};
+		Bits<KEY_MAX> keys{};
+		if (!node.keys.empty() && ioctl(node.fd, EVIOCGKEY(sizeof(keys)), keys.data()) >= 0)
+		{
+			event.type = EV_KEY;
+			for (int code : node.keys)
+			{
+				event.code = uint16_t(code);
+				event.value = testBit<KEY_MAX>(keys, code);
+				decoder.feed(node.role, event);
+			}
+		}
+		event.type = EV_ABS;
+		for (int code : node.axes)
+		{
+			input_absinfo info;
+			if (code != ABS_MT_SLOT && ioctl(node.fd, EVIOCGABS(code), &info) >= 0)
+			{
+				event.code = uint16_t(code);
+				event.value = info.value;
+				decoder.feed(node.role, event);
+			}
+		}
+		decoder.resynced(node.role);
+	}
+
+	void start()
+	{
+		if (!_poller.joinable())
+		{
+			_polling = true;
+			_poller = std::thread(&EvdevInstance::poll, this);
+		}
+	}
+
+	void stop()
+	{
+		_polling = false;
+		uint64_t one = 1;
+		write(_wake, &one, sizeof(one));
+		if (_poller.joinable())
+		{
+			_poller.join();
+		}
+		uint64_t count;
+		while (read(_wake, &count, sizeof(count)) > 0)
+		{
+		}
+	}
+
+	void poll()
+	{
+		std::array<epoll_event, 16> events;
+		while (_polling)
+		{
+			// Block until a report arrives
+			int count = epoll_wait(_epoll, events.data(), int(events.size()), -1);
+			if (count < 0 && errno != EINTR)
+			{
+				break;
+			}
+			for (int i = 0; i < count && _polling; ++i)
+			{
+				if (auto *node = static_cast<Node *>(events[i].data.ptr))
+				{
+					readNode(*node, events[i].events);
+				}
+			}
+			// Devices whose nodes ended a report together only get one callback
+			for (auto &device : _devices)
+			{
+				if (device->reported && _polling)
+				{
+					runCallbacks(*device);
+				}
+			}
+		}
+	}
+
+	void readNode(Node &node, uint32_t ready)
+	{
+		auto &device = *node.device;
+		std::array<input_event, 64> buffer;
+		ssize_t bytes = 0;
+		while ((bytes = read(node.fd, buffer.data(), sizeof(buffer))) > 0)
+		{
+			for (size_t i = 0; i < size_t(bytes) / sizeof(input_event); ++i)
+			{
+				if (device.decoder.feed(node.role, buffer[i]))
+				{
+					device.reported = true;
+					device.reportNs = std::max(device.reportNs, EventNs(buffer[i]));
+				}
+			}
+			if (device.decoder.needsResync(node.role))
+			{
+				resync(node);
+				device.reported = true;
+			}
+		}
+		if ((bytes < 0 && errno == ENODEV) || (ready & (EPOLLHUP | EPOLLERR)))
+		{
+			// Unplugged. AutoConnect or RECONNECT_CONTROLLERS will notice the lower device count.
+			epoll_ctl(_epoll, EPOLL_CTL_DEL, node.fd, nullptr);
+			close(node.fd);
+			node.fd = -1;
+			if (&node == device.gamepad)
+			{
+				device.connected = false;
+				device.reported = false;
+			}
+		}
+	}
+
+	void runCallbacks(EvdevDevice &device)
+	{
+		device.reported = false;
+		if (!device.connected)
+		{
+			return;
+		}
+		float deltaTime = device.callbackNs != 0 && device.reportNs > device.callbackNs ? float(device.reportNs - device.callbackNs) / 1e9f : 0.f;
+		device.callbackNs = device.reportNs;
+		const auto &frame = device.decoder.frame();
+		if (auto callback = _callback.load())
+		{
+			JOY_SHOCK_STATE state = GetSimpleState(device.handle);
+			callback(device.handle, state, state, frame.imu, frame.imu, deltaTime);
+		}
+		if (auto touchCallback = _touchCallback.load())
+		{
+			touchCallback(device.handle, frame.touch, device.prevTouch, deltaTime);
+		}
+		device.prevTouch = frame.touch;
+		sendRumble(device);
+	}
+
+	// Only sent when it changes. The effect plays until it's replaced.
+	void sendRumble(EvdevDevice &device)
+	{
+		if (!device.canRumble || !device.gamepad || device.gamepad->fd < 0 ||
+		  (device.bigRumble == device.sentBigRumble && device.smallRumble == device.sentSmallRumble))
+		{
+			return;
+		}
+		ff_effect effect{};
+		effect.type = FF_RUMBLE;
+		effect.id = int16_t(device.rumbleId);
+		effect.u.rumble.strong_magnitude = device.bigRumble;
+		effect.u.rumble.weak_magnitude = device.smallRumble;
+		if (ioctl(device.gamepad->fd, EVIOCSFF, &effect) < 0)
+		{
+			device.canRumble = false;
+			return;
+		}
+		device.rumbleId = effect.id;
+		input_event play{};
+		play.type = EV_FF;
+		play.code = uint16_t(effect.id);
+		play.value = device.bigRumble != 0 || device.smallRumble != 0;
+		write(device.gamepad->fd, &play, sizeof(play));
+		device.sentBigRumble = device.bigRumble;
+		device.sentSmallRumble = device.smallRumble;
+	}
+
+	int _epoll = -1;
+	int _wake = -1; // eventfd that interrupts epoll_wait to stop polling
+	std::vector<std::unique_ptr<EvdevDevice>> _devices;
+
+	std::atomic<void (*)(int, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float)> _callback = nullptr;
+	std::atomic<void (*)(int, TOUCH_STATE, TOUCH_STATE, float)> _touchCallback = nullptr;
+	std::atomic_bool _polling = false;
+	std::thread _poller;
+};
+
+} // namespace
+
+namespace Evdev
+{
+
+bool Requested(const std::vector<std::string> &arguments)
+{
+	return std::find(arguments.begin(), arguments.end(), "--evdev") != arguments.end();
+}
+
+JslWrapper *New()
+{
+	return new EvdevInstance();
+}
+
+} // namespace Evdev
@@ -1,4 +1,5 @@
 #include "Gamepad.h"
+#include "InputHelpers.h"
 
 size_t Gamepad::_count = 0;
 
@@ -66,6 +67,10 @@ public:
 
 Gamepad *Gamepad::getNew(ControllerScheme scheme, Callback notification)
 {
+	if (auto sink = getOutputSink())
+	{
+		return sink->newGamepad(scheme);
+	}
 	// return new GamepadImpl();
 	return nullptr;
 }
@@ -13,6 +13,7 @@
 
 #include <libevdev/libevdev-uinput.h>
 #include <fcntl.h>
+#include <cerrno>
 
 #include <dirent.h>
 #include <unistd.h>
@@ -324,7 +325,8 @@ public:
 
 public:
 	VirtualInputDevice(Device device)
-	  : device_{ libevdev_new() }
+	  : type_{ device }
+	  , device_{ libevdev_new() }
 	{
 		if (device == Device::MOUSE)
 		{
@@ -334,6 +336,11 @@ public:
 			libevdev_enable_event_code(device_, EV_REL, REL_X, nullptr);
 			libevdev_enable_event_code(device_, EV_REL, REL_Y, nullptr);
 			libevdev_enable_event_code(device_, EV_REL, REL_WHEEL, nullptr);
+			libevdev_enable_event_code(device_, EV_REL, REL_HWHEEL, nullptr);
+#ifdef REL_WHEEL_HI_RES
+			libevdev_enable_event_code(device_, EV_REL, REL_WHEEL_HI_RES, nullptr);
+			libevdev_enable_event_code(device_, EV_REL, REL_HWHEEL_HI_RES, nullptr);
+#endif
 
 			libevdev_enable_event_type(device_, EV_ABS);
 			libevdev_enable_event_code(device_, EV_ABS, ABS_X, nullptr);
@@ -374,38 +381,12 @@ public:
 public:
 	void press_key(WORD key) noexcept
 	{
-		auto error =
-		  libevdev_uinput_write_event(uinput_device_, EV_KEY, windows_key_to_evdev_key(key), 1);
-		if (error != 0)
-		{
-			std::fprintf(stderr, "Failed to to simulate key press: %s\n", std::strerror(-error));
-			return;
-		}
-
-		error = libevdev_uinput_write_event(uinput_device_, EV_SYN, SYN_REPORT, 0);
-		if (error != 0)
-		{
-			std::fprintf(stderr, "Failed to to simulate key press: %s\n", std::strerror(-error));
-			return;
-		}
+		key_event(windows_key_to_evdev_key(key), 1);
 	}
 
 	void release_key(WORD key) noexcept
 	{
-		auto error =
-		  libevdev_uinput_write_event(uinput_device_, EV_KEY, windows_key_to_evdev_key(key), 0);
-		if (error != 0)
-		{
-			std::fprintf(stderr, "Failed to to simulate key release: %s\n", std::strerror(-error));
-			return;
-		}
-
-		error = libevdev_uinput_write_event(uinput_device_, EV_SYN, SYN_REPORT, 0);
-		if (error != 0)
-		{
-			std::fprintf(stderr, "Failed to to simulate key release: %s\n", std::strerror(-error));
-			return;
-		}
+		key_event(windows_key_to_evdev_key(key), 0);
 	}
 
 	void click_key(WORD key) noexcept
@@ -416,72 +397,157 @@ public:
 
 	void mouse_move_relative(std::int32_t x, std::int32_t y) noexcept
 	{
-		auto error = libevdev_uinput_write_event(uinput_device_, EV_REL, REL_X, x);
-		if (error != 0)
+		auto &pending = this->pending();
+		pending.relX += x;
+		pending.relY += y;
+		flush_unless_batching(pending);
+	}
+
+	void mouse_move_absolute(std::int32_t x, std::int32_t y) noexcept
+	{
+		auto &pending = this->pending();
+		pending.hasAbs = true;
+		pending.absX = x;
+		pending.absY = y;
+		flush_unless_batching(pending);
+	}
+
+	// In high resolution wheel steps
+	void mouse_scroll(std::int32_t hiResX, std::int32_t hiResY) noexcept
+	{
+		auto &pending = this->pending();
+		pending.hwheelHiRes += hiResX;
+		pending.wheelHiRes += hiResY;
+		flush_unless_batching(pending);
+	}
+
+	// Write everything this thread queued for this device as one frame
+	void flush() noexcept
+	{
+		flush(pending());
+	}
+
+	static thread_local int batchDepth;
+
+private:
+	// Events queued by one thread. Motion is summed; keys keep their order.
+	struct PendingEvents
+	{
+		std::vector<input_event> keys;
+		std::int32_t relX = 0;
+		std::int32_t relY = 0;
+		std::int32_t wheelHiRes = 0;
+		std::int32_t hwheelHiRes = 0;
+		bool hasAbs = false;
+		std::int32_t absX = 0;
+		std::int32_t absY = 0;
+	};
+
+	PendingEvents &pending() noexcept
+	{
+		static thread_local PendingEvents pendingPerDevice[2];
+		return pendingPerDevice[int(type_)];
+	}
+
+	static input_event make_event(std::uint16_t type, std::uint16_t code, std::int32_t value) noexcept
+	{
+		input_event event{};
+		event.type = type;
+		event.code = code;
+		event.value = value;
+		return event;
+	}
+
+	void key_event(std::uint16_t code, std::int32_t value) noexcept
+	{
+		auto &pending = this->pending();
+		// A key that changes twice in one frame would look like it never changed: report the first change on its own
+		for (auto event = pending.keys.rbegin(); event != pending.keys.rend() && event->type != EV_SYN; ++event)
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			if (event->code == code)
+			{
+				pending.keys.push_back(make_event(EV_SYN, SYN_REPORT, 0));
+				break;
+			}
 		}
+		pending.keys.push_back(make_event(EV_KEY, code, value));
+		flush_unless_batching(pending);
+	}
 
-		error = libevdev_uinput_write_event(uinput_device_, EV_REL, REL_Y, y);
-		if (error != 0)
+	void flush_unless_batching(PendingEvents &pending) noexcept
+	{
+		if (batchDepth == 0)
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			flush(pending);
 		}
+	}
 
-		error = libevdev_uinput_write_event(uinput_device_, EV_SYN, SYN_REPORT, 0);
-		if (error != 0)
+	// Whole notches once the steps since the last notch add up to one. The rest stays for the next frame.
+	static std::int32_t take_notches(std::atomic<std::int32_t> &sinceNotch, std::int32_t hiRes) noexcept
+	{
+		auto before = sinceNotch.load();
+		std::int32_t after, notches;
+		do
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
-		}
+			after = before + hiRes;
+			notches = after / WHEEL_HI_RES_PER_NOTCH;
+		} while (!sinceNotch.compare_exchange_weak(before, after - notches * WHEEL_HI_RES_PER_NOTCH));
+		return notches;
 	}
 
-	void mouse_move_absolute(std::int32_t x, std::int32_t y) noexcept
+	void flush(PendingEvents &pending) noexcept
 	{
-		auto error = libevdev_uinput_write_event(uinput_device_, EV_ABS, ABS_X, x);
-		if (error != 0)
+		static thread_local std::vector<input_event> frame;
+		frame.assign(pending.keys.begin(), pending.keys.end());
+		if (pending.relX != 0)
+			frame.push_back(make_event(EV_REL, REL_X, pending.relX));
+		if (pending.relY != 0)
+			frame.push_back(make_event(EV_REL, REL_Y, pending.relY));
+		// Like the kernel does for high resolution mice, the legacy axes only get whole notches, and readers of
+		// the high resolution axes ignore them
+		if (pending.wheelHiRes != 0)
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			if (auto notches = take_notches(wheelSinceNotch_, pending.wheelHiRes))
+				frame.push_back(make_event(EV_REL, REL_WHEEL, notches));
+#ifdef REL_WHEEL_HI_RES
+			frame.push_back(make_event(EV_REL, REL_WHEEL_HI_RES, pending.wheelHiRes));
+#endif
 		}
-
-		error = libevdev_uinput_write_event(uinput_device_, EV_ABS, ABS_Y, y);
-		if (error != 0)
+		if (pending.hwheelHiRes != 0)
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			if (auto notches = take_notches(hwheelSinceNotch_, pending.hwheelHiRes))
+				frame.push_back(make_event(EV_REL, REL_HWHEEL, notches));
+#ifdef REL_HWHEEL_HI_RES
+			frame.push_back(make_event(EV_REL, REL_HWHEEL_HI_RES, pending.hwheelHiRes));
+#endif
 		}
-
-		error = libevdev_uinput_write_event(uinput_device_, EV_SYN, SYN_REPORT, 0);
-		if (error != 0)
+		if (pending.hasAbs)
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			frame.push_back(make_event(EV_ABS, ABS_X, pending.absX));
+			frame.push_back(make_event(EV_ABS, ABS_Y, pending.absY));
 		}
-	}
-
-	void mouse_scroll(std::int32_t amount) noexcept
-	{
-		auto error = libevdev_uinput_write_event(uinput_device_, EV_REL, REL_WHEEL, amount);
-		if (error != 0)
+		pending.keys.clear();
+		pending.relX = pending.relY = pending.wheelHiRes = pending.hwheelHiRes = 0;
+		pending.hasAbs = false;
+		if (frame.empty())
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse scroll: %s\n", std::strerror(-error));
 			return;
 		}
+		frame.push_back(make_event(EV_SYN, SYN_REPORT, 0));
 
-		error = libevdev_uinput_write_event(uinput_device_, EV_SYN, SYN_REPORT, 0);
-		if (error != 0)
+		const auto size = frame.size() * sizeof(input_event);
+		if (::write(libevdev_uinput_get_fd(uinput_device_), frame.data(), size) != ssize_t(size))
 		{
-			std::fprintf(stderr, "Failed to to simulate mouse move: %s\n", std::strerror(-error));
-			return;
+			std::fprintf(stderr, "Failed to to simulate input: %s\n", std::strerror(errno));
 		}
 	}
 
-private:
+	Device type_;
 	libevdev *device_;
 	libevdev_uinput *uinput_device_{ nullptr };
+	// High resolution wheel steps not yet sent as a legacy notch. Any thread may flush.
+	std::atomic<std::int32_t> wheelSinceNotch_ = 0;
+	std::atomic<std::int32_t> hwheelSinceNotch_ = 0;
 };
 
 // get the user's mouse sensitivity multiplier from the user. In Windows it's an int, but who cares?
@@ -498,14 +564,47 @@ VirtualInputDevice mouse{ VirtualInputDevice::Device::MOUSE };
 VirtualInputDevice keyboard{ VirtualInputDevice::Device::KEYBOARD };
 } // namespace
 
+thread_local int VirtualInputDevice::batchDepth = 0;
+
+static atomic<OutputSink *> outputSink = nullptr;
+
+void setOutputSink(OutputSink *sink)
+{
+	outputSink = sink;
+}
+
+OutputSink *getOutputSink()
+{
+	return outputSink;
+}
+
+void beginOutputFrame()
+{
+	++VirtualInputDevice::batchDepth;
+}
+
+void endOutputFrame()
+{
+	if (VirtualInputDevice::batchDepth > 0 && --VirtualInputDevice::batchDepth == 0)
+	{
+		mouse.flush();
+		keyboard.flush();
+	}
+}
+
 // send mouse button
 int pressMouse(WORD vkKey, bool isPressed)
 {
+	if (auto sink = outputSink.load())
+	{
+		sink->key(vkKey, isPressed);
+		return 0;
+	}
 	if (vkKey == V_WHEEL_UP)
 	{
 		if (isPressed)
 		{
-			mouse.mouse_scroll(1);
+			mouse.mouse_scroll(0, WHEEL_HI_RES_PER_NOTCH);
 		}
 
 		return 0;
@@ -515,7 +614,7 @@ int pressMouse(WORD vkKey, bool isPressed)
 	{
 		if (isPressed)
 		{
-			mouse.mouse_scroll(-1);
+			mouse.mouse_scroll(0, -WHEEL_HI_RES_PER_NOTCH);
 		}
 
 		return 0;
@@ -543,6 +642,11 @@ int pressKey(KeyCode vkKey, bool pressed)
 		// Highest mouse ID
 		return pressMouse(vkKey.code, pressed);
 	}
+	if (auto sink = outputSink.load())
+	{
+		sink->key(vkKey.code, pressed);
+		return 0;
+	}
 
 	if (pressed)
 	{
@@ -556,26 +660,23 @@ int pressKey(KeyCode vkKey, bool pressed)
 	return 0;
 }
 
-float accumulatedX = 0;
-float accumulatedY = 0;
-
-void moveMouse(float x, float y)
+void sendMouseMove(int x, int y)
 {
-	accumulatedX += x;
-	accumulatedY += y;
-
-	int applicableX = (int)accumulatedX;
-	int applicableY = (int)accumulatedY;
-
-	accumulatedX -= applicableX;
-	accumulatedY -= applicableY;
+	mouse.mouse_move_relative(x, y);
+}
 
-	mouse.mouse_move_relative(applicableX, applicableY);
-	// printf("%0.4f %0.4f\n", accumulatedX, accumulatedY);
+void sendMouseScroll(int hiResX, int hiResY)
+{
+	mouse.mouse_scroll(hiResX, hiResY);
 }
 
 void setMouseNorm(float x, float y)
 {
+	if (auto sink = outputSink.load())
+	{
+		sink->mouseAbsolute(x, y);
+		return;
+	}
 	mouse.mouse_move_absolute(std::roundf(65535.0f * x), std::roundf(65535.0f * y));
 }
 
@@ -11,11 +11,11 @@
 #include "SettingsManager.h"
 #include "JoyShock.h"
 #include "Telemetry.h"
-#include "NaturalCurve.h"
-#include "PowerCurve.h"
-#include "QuadraticCurve.h"
-#include "SigmoidCurve.h"
-#include "JumpCurve.h"
+#include "CurveEngine.h"
+#include "InputRecording.h"
+#include "OfflineRender.h"
+#include "LoadGenerator.h"
+#include "GyroCalibrationStore.h"
 #include <filesystem>
 #include <algorithm>
 #include <atomic>
@@ -26,6 +26,7 @@
 #ifdef _WIN32
 #include <shellapi.h>
 #else
+#include "linux/EvdevWrapper.h"
 #define UCHAR unsigned char
 #include <algorithm>
 #include <unistd.h>
@@ -34,7 +35,10 @@
 #pragma warning(disable : 4996) // Disable deprecated API warnings
 
 std::string NONAME;
-shared_ptr<JslWrapper> jsl;
+// REPLAY swaps the backend while the threads of the previous one may still be in a callback,
+// so the callbacks work on a copy taken when they start
+atomic<shared_ptr<JslWrapper>> jsl;
+shared_ptr<JslWrapper> liveJsl; // The controller backend while a replay stands in for it
 unique_ptr<TrayIcon> tray;
 unique_ptr<Whitelister> whitelister;
 
@@ -51,6 +55,7 @@ std::atomic_bool g_hasGyroOnAllBinding(false);
 vector<pair<int, int>> g_ignoreGyroVidPid;
 unique_ptr<PollingThread> minimizeThread;
 bool devicesCalibrating = false;
+unique_ptr<GyroCalibrationStore> gyroCalibrations; // Only for real controllers, not replays or synthetic devices
 unordered_map<int, shared_ptr<JoyShock>> handle_to_joyshock;
 
 int input_pipe_fd[2];
@@ -111,14 +116,16 @@ static void RefreshTelemetrySettings()
 {
 	auto telemetryEnabled = SettingsManager::get<Switch>(SettingID::TELEMETRY_ENABLED);
 	auto telemetryPort = SettingsManager::get<int>(SettingID::TELEMETRY_PORT);
-	if (!telemetryEnabled || !telemetryPort)
+	auto telemetryFormat = SettingsManager::get<TelemetryFormat>(SettingID::TELEMETRY_FORMAT);
+	if (!telemetryEnabled || !telemetryPort || !telemetryFormat)
 	{
 		return;
 	}
 
 	int portValue = std::clamp(telemetryPort->value(), 1, 65535);
 	const bool enabled = telemetryEnabled->value() == Switch::ON;
-	Telemetry::Configure(enabled, static_cast<uint16_t>(portValue));
+	const bool jsonFormat = telemetryFormat->value() == TelemetryFormat::JSON;
+	Telemetry::Configure(enabled, static_cast<uint16_t>(portValue), jsonFormat);
 }
 
 struct TOUCH_POINT
@@ -183,11 +190,13 @@ void touchCallback(int jcHandle, TOUCH_STATE newState, TOUCH_STATE prevState, fl
 	//}
 
 	shared_ptr<JoyShock> js = handle_to_joyshock[jcHandle];
+	shared_ptr<JslWrapper> backend = jsl.load();
 	int tpSizeX, tpSizeY;
-	if (!js || jsl->GetTouchpadDimension(jcHandle, tpSizeX, tpSizeY) == false)
+	if (!js || backend->GetTouchpadDimension(jcHandle, tpSizeX, tpSizeY) == false)
 		return;
 	FloatXY tpSize{ float(tpSizeX), float(tpSizeY) };
 
+	OutputFrame outputFrame;
 	lock_guard guard(js->_context->callback_lock);
 
 	TOUCH_POINT point0(newState.t0Down ? make_optional<FloatXY>(newState.t0X, newState.t0Y) : nullopt,
@@ -211,6 +220,7 @@ void touchCallback(int jcHandle, TOUCH_STATE newState, TOUCH_STATE prevState, fl
 		     currentlyActive = find_if(js->_context->chordStack.begin(), js->_context->chordStack.end(), IS_TOUCH_BUTTON))
 		{
 			js->_context->chordStack.erase(currentlyActive);
+			++js->_context->chordStackVersion;
 		}
 	}
 	if (mode == TouchpadMode::GRID_AND_STICK)
@@ -235,12 +245,11 @@ void touchCallback(int jcHandle, TOUCH_STATE newState, TOUCH_STATE prevState, fl
 			index1 = int(row * grid_size.value().x() + col);
 		}
 
-		for (size_t i = 0; i < grid_mappings.size(); ++i)
+		// The controller only has the grid buttons of the last grid size it took, and none at startup.
+		for (size_t i = 0; i < js->_gridButtons.size(); ++i)
 		{
 			auto optId = magic_enum::enum_cast<ButtonID>(int(FIRST_TOUCH_BUTTON + i));
-
-			// JSM can get touch button callbacks before the grid _buttons are setup at startup. Just skip then.
-			if (optId && js->_gridButtons.size() == grid_mappings.size())
+			if (optId)
 				js->handleButtonChange(*optId, i == index0 || i == index1);
 		}
 
@@ -286,7 +295,7 @@ void touchCallback(int jcHandle, TOUCH_STATE newState, TOUCH_STATE prevState, fl
 			TOUCH_POINT *downPoint = point0.isDown() ? &point0 : &point1;
 			FloatXY sens = js->getSetting<FloatXY>(SettingID::TOUCHPAD_SENS);
 			// if(downPoint->movX || downPoint->movY) cout << "Moving the cursor by " << dec << int(downPoint->movX) << " h and " << int(downPoint->movY) << " v\n";
-			moveMouse(downPoint->movX * sens.x(), downPoint->movY * sens.y());
+			moveMouse(downPoint->movX * sens.x(), downPoint->movY * sens.y(), js->_mouseRemainder);
 			// Ignore second touch point in this mode for now until gestures gets handled here
 		}
 		//}
@@ -302,17 +311,17 @@ void touchCallback(int jcHandle, TOUCH_STATE newState, TOUCH_STATE prevState, fl
 	}
 }
 
-void calibrateTriggers(shared_ptr<JoyShock> jc)
+void calibrateTriggers(JslWrapper *backend, shared_ptr<JoyShock> jc, const DeviceFrame &frame)
 {
-	if (jsl->GetButtons(jc->_handle) & (1 << JSOFFSET_HOME))
+	if (frame.buttons & (1 << JSOFFSET_HOME))
 	{
 		COUT << "Abandonning calibration\n";
 		triggerCalibrationStep = 0;
 		return;
 	}
 
-	auto rpos = jsl->GetRightTrigger(jc->_handle);
-	auto lpos = jsl->GetLeftTrigger(jc->_handle);
+	auto rpos = frame.rightTrigger;
+	auto lpos = frame.leftTrigger;
 	auto tick_time = *SettingsManager::get<float>(SettingID::TICK_TIME);
 	static auto &right_trigger_offset = *SettingsManager::getV<int>(SettingID::RIGHT_TRIGGER_OFFSET);
 	static auto &right_trigger_range = *SettingsManager::getV<int>(SettingID::RIGHT_TRIGGER_RANGE);
@@ -331,7 +340,7 @@ void calibrateTriggers(shared_ptr<JoyShock> jc)
 		triggerCalibrationStep++;
 		break;
 	case 2:
-		if (jsl->GetButtons(jc->_handle) & (1 << JSOFFSET_DOWN))
+		if (frame.buttons & (1 << JSOFFSET_DOWN))
 		{
 			triggerCalibrationStep++;
 		}
@@ -375,7 +384,7 @@ void calibrateTriggers(shared_ptr<JoyShock> jc)
 		triggerCalibrationStep++;
 		break;
 	case 7:
-		if (jsl->GetButtons(jc->_handle) & (1 << JSOFFSET_S))
+		if (frame.buttons & (1 << JSOFFSET_S))
 		{
 			triggerCalibrationStep++;
 		}
@@ -418,7 +427,7 @@ void calibrateTriggers(shared_ptr<JoyShock> jc)
 		tick_time.reset();
 		break;
 	}
-	jsl->SetTriggerEffect(jc->_handle, jc->_leftEffect, jc->_rightEffect);
+	backend->SetTriggerEffect(jc->_handle, jc->_leftEffect, jc->_rightEffect);
 }
 
 void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE lastState, IMU_STATE imuState, IMU_STATE lastImuState, float deltaTime)
@@ -427,23 +436,40 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	shared_ptr<JoyShock> jc = handle_to_joyshock[jcHandle];
 	if (jc == nullptr)
 		return;
+	shared_ptr<JslWrapper> backend = jsl.load();
+	OutputFrame outputFrame;
 	jc->_context->callback_lock.lock();
+	jc->_context->pendingChanges.apply();
+
+	// Everything read from the device this tick
+	DeviceFrame frame;
+	if (!backend->GetDeviceFrame(jc->_handle, frame))
+	{
+		jc->_context->callback_lock.unlock();
+		return;
+	}
 
 	auto timeNow = chrono::steady_clock::now();
-	deltaTime = ((float)chrono::duration_cast<chrono::microseconds>(timeNow - jc->_timeNow).count()) / 1000000.0f;
+	if (backend->ProvidesTimeStep())
+	{
+		// Tap, hold and flick timings follow the reports, so that a replay plays out as recorded at any speed
+		timeNow = jc->_timeNow + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(deltaTime));
+	}
+	else
+	{
+		deltaTime = ((float)chrono::duration_cast<chrono::microseconds>(timeNow - jc->_timeNow).count()) / 1000000.0f;
+	}
 	jc->_timeNow = timeNow;
 
 	if (triggerCalibrationStep)
 	{
-		calibrateTriggers(jc);
+		calibrateTriggers(backend.get(), jc, frame);
 		jc->_context->callback_lock.unlock();
 		return;
 	}
 
 	MotionIf &motion = *jc->_motion;
 
-	IMU_STATE imu = jsl->GetIMUState(jc->_handle);
-
 	if (SettingsManager::getV<Switch>(SettingID::AUTO_CALIBRATE_GYRO)->value() == Switch::ON)
 	{
 		motion.SetAutoCalibration(true, 1.2f, 0.015f);
@@ -452,10 +478,62 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	{
 		motion.SetAutoCalibration(false, 0.f, 0.f);
 	}
-	motion.ProcessMotion(imu.gyroX, imu.gyroY, imu.gyroZ, imu.accelX, imu.accelY, imu.accelZ, deltaTime);
 
+	IMU_STATE imu;
 	float inGyroX, inGyroY, inGyroZ;
-	motion.GetCalibratedGyro(inGyroX, inGyroY, inGyroZ);
+	// Gyro output covers the time spanned by the motion reports of this tick rather than the time between
+	// callbacks, so that scheduling jitter doesn't become aim error. Without timed reports, it's the same.
+	float motionDeltaTime = deltaTime;
+	static constexpr int MAX_IMU_REPORTS = 128;
+	array<TimedImuState, MAX_IMU_REPORTS> imuReports;
+	int numReports = backend->GetIMUReports(jc->_handle, imuReports.data(), MAX_IMU_REPORTS);
+	if (InputRecording::IsRecording())
+	{
+		InputRecording::DeviceInfo device{ jc->_handle, jc->_controllerType, jc->_splitType,
+			backend->GetControllerVendor(jc->_handle), backend->GetControllerProduct(jc->_handle) };
+		InputRecording::Record(device, frame, deltaTime, imuReports.data(), numReports);
+	}
+	if (numReports < 0)
+	{
+		// Only the latest report is available
+		imu = frame.imu;
+		motion.ProcessMotion(imu.gyroX, imu.gyroY, imu.gyroZ, imu.accelX, imu.accelY, imu.accelZ, deltaTime);
+		motion.GetCalibratedGyro(inGyroX, inGyroY, inGyroZ);
+	}
+	else if (numReports == 0)
+	{
+		// No new report since the last tick: keep the last gyro velocity. The time until the next report
+		// is counted when it arrives.
+		imu = frame.imu;
+		motion.GetCalibratedGyro(inGyroX, inGyroY, inGyroZ);
+		motionDeltaTime = jc->_timedMotion ? 0.f : deltaTime;
+	}
+	else
+	{
+		// Feed every report to the sensor fusion with its own timestep, and use the
+		// time weighted average of the calibrated gyro over this tick.
+		float sumX = 0.f, sumY = 0.f, sumZ = 0.f, sumTime = 0.f;
+		for (int i = 0; i < numReports; ++i)
+		{
+			const auto &report = imuReports[i];
+			motion.ProcessMotion(report.imu.gyroX, report.imu.gyroY, report.imu.gyroZ,
+			  report.imu.accelX, report.imu.accelY, report.imu.accelZ, report.deltaTime);
+			motion.GetCalibratedGyro(inGyroX, inGyroY, inGyroZ);
+			sumX += inGyroX * report.deltaTime;
+			sumY += inGyroY * report.deltaTime;
+			sumZ += inGyroZ * report.deltaTime;
+			sumTime += report.deltaTime;
+		}
+		if (sumTime > 0.f)
+		{
+			inGyroX = sumX / sumTime;
+			inGyroY = sumY / sumTime;
+			inGyroZ = sumZ / sumTime;
+			motionDeltaTime = sumTime;
+			jc->_timedMotion = true;
+		}
+		imu = imuReports[numReports - 1].imu;
+	}
 
 	float inGravX, inGravY, inGravZ;
 	motion.GetGravity(inGravX, inGravY, inGravZ);
@@ -675,13 +753,10 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	}
 	float gyroLength = sqrt(gyroX * gyroX + gyroY * gyroY);
 	// do gyro smoothing
-	// convert gyro smooth time to number of samples
 	auto tick_time = SettingsManager::get<float>(SettingID::TICK_TIME)->value();
-	auto numGyroSamples = jc->getSetting(SettingID::GYRO_SMOOTH_TIME) * 1000.f / tick_time;
-	if (numGyroSamples < 1)
-		numGyroSamples = 1; // need at least 1 sample
 	auto threshold = jc->getSetting(SettingID::GYRO_SMOOTH_THRESHOLD);
-	jc->getSmoothedGyro(gyroX, gyroY, gyroLength, threshold / 2.0f, threshold, int(numGyroSamples), gyroX, gyroY);
+	jc->getSmoothedGyro(gyroX, gyroY, gyroLength, threshold / 2.0f, threshold, jc->getSetting<GyroSmoothKernel>(SettingID::GYRO_SMOOTH_KERNEL),
+	  jc->getSetting(SettingID::GYRO_SMOOTH_TIME), jc->getSetting(SettingID::GYRO_SMOOTH_BETA), tick_time / 1000.f, gyroX, gyroY);
 	// COUT << "%d Samples for threshold: %0.4f\n", numGyroSamples, gyro_smooth_threshold * maxSmoothingSamples);
 
 	// now, honour gyro_cutoff_speed
@@ -721,8 +796,8 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 		break;
 	case GyroIgnoreMode::LEFT_STICK:
 	{
-		float leftX = jsl->GetLeftX(jc->_handle);
-		float leftY = jsl->GetLeftY(jc->_handle);
+		float leftX = frame.leftX;
+		float leftY = frame.leftY;
 		float leftLength = sqrtf(leftX * leftX + leftY * leftY);
 		float deadzoneInner = jc->getSetting(SettingID::LEFT_STICK_DEADZONE_INNER);
 		float deadzoneOuter = jc->getSetting(SettingID::LEFT_STICK_DEADZONE_OUTER);
@@ -761,8 +836,8 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	break;
 	case GyroIgnoreMode::RIGHT_STICK:
 	{
-		float rightX = jsl->GetRightX(jc->_handle);
-		float rightY = jsl->GetRightY(jc->_handle);
+		float rightX = frame.rightX;
+		float rightY = frame.rightY;
 		float rightLength = sqrtf(rightX * rightX + rightY * rightY);
 		float deadzoneInner = jc->getSetting(SettingID::RIGHT_STICK_DEADZONE_INNER);
 		float deadzoneOuter = jc->getSetting(SettingID::RIGHT_STICK_DEADZONE_OUTER);
@@ -853,7 +928,7 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 		blockGyro = true;
 	}
 
-	float decay = exp2f(-deltaTime * jc->getSetting(SettingID::TRACKBALL_DECAY));
+	float decay = exp2f(-motionDeltaTime * jc->getSetting(SettingID::TRACKBALL_DECAY));
 	int maxTrackballSamples = max(1, min(jc->NUM_LAST_GYRO_SAMPLES, (int)(1.f / deltaTime * 0.125f)));
 
 	if (!trackball_x_pressed && !trackball_y_pressed)
@@ -921,104 +996,70 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	pair<float, float> hiSensXY = jc->getSetting<FloatXY>(SettingID::MAX_GYRO_SENS);
 	const AccelCurve accelCurve = jc->getSetting<AccelCurve>(SettingID::ACCEL_CURVE);
 
-	// Curve-specific parameters
-	const float naturalVHalf = jc->getSetting(SettingID::ACCEL_NATURAL_VHALF);
-	const float powervRef = jc->getSetting(SettingID::ACCEL_POWER_VREF);
-	const float powerExponent = jc->getSetting(SettingID::ACCEL_POWER_EXPONENT);
-	const float sigmoidMid = jc->getSetting(SettingID::ACCEL_SIGMOID_MID);
-	const float sigmoidWidth = jc->getSetting(SettingID::ACCEL_SIGMOID_WIDTH);
-	const float jumpTau = jc->getSetting(SettingID::ACCEL_JUMP_TAU);
+	// The curve engine only recomputes its constants when one of these changes
+	static_assert(int(AccelCurve::LINEAR) == int(CurveShape::LINEAR) && int(AccelCurve::JUMP) == int(CurveShape::JUMP));
+	CurveParams curveParams;
+	curveParams.shape = accelCurve == AccelCurve::INVALID ? CurveShape::LINEAR : CurveShape(accelCurve);
+	curveParams.minThreshold = jc->getSetting(SettingID::MIN_GYRO_THRESHOLD);
+	curveParams.maxThreshold = jc->getSetting(SettingID::MAX_GYRO_THRESHOLD);
+	curveParams.naturalVHalf = jc->getSetting(SettingID::ACCEL_NATURAL_VHALF);
+	curveParams.powerVRef = jc->getSetting(SettingID::ACCEL_POWER_VREF);
+	curveParams.powerExponent = jc->getSetting(SettingID::ACCEL_POWER_EXPONENT);
+	curveParams.sigmoidMid = jc->getSetting(SettingID::ACCEL_SIGMOID_MID);
+	curveParams.sigmoidWidth = jc->getSetting(SettingID::ACCEL_SIGMOID_WIDTH);
+	curveParams.jumpTau = jc->getSetting(SettingID::ACCEL_JUMP_TAU);
+	jc->_accelCurve.configure(curveParams, SettingsManager::getV<Switch>(SettingID::ACCEL_CURVE_TABLE)->value() == Switch::ON);
 
 	// apply calibration factor
 	// get input velocity
 	float omega = sqrt(gyroX * gyroX + gyroY * gyroY);
 	// calculate position on minThreshold to maxThreshold scale
-	float minThreshold = jc->getSetting(SettingID::MIN_GYRO_THRESHOLD);
-	float maxThreshold = jc->getSetting(SettingID::MAX_GYRO_THRESHOLD);
+	float minThreshold = curveParams.minThreshold;
+	float maxThreshold = curveParams.maxThreshold;
 	const float omegaAdjusted = std::max(0.0f, omega - minThreshold);
-	const float denom = maxThreshold - minThreshold;
-	float normalizedPreCurve = (denom > 0.0f) ? std::clamp(omegaAdjusted / denom, 0.0f, 1.0f)
-	                                          : (omegaAdjusted > 0.0f ? 1.0f : 0.0f);
 
 	float appliedSensX = 0.0f;
 	float appliedSensY = 0.0f;
-	float normalizedPostCurve = normalizedPreCurve;
-
-	switch (accelCurve)
-	{
-	case AccelCurve::NATURAL:
-		appliedSensX = NaturalSensitivity(omegaAdjusted, lowSensXY.first, hiSensXY.first, naturalVHalf);
-		appliedSensY = NaturalSensitivity(omegaAdjusted, lowSensXY.second, hiSensXY.second, naturalVHalf);
-		break;
-	case AccelCurve::POWER:
-		appliedSensX = PowerSensitivity(omegaAdjusted, lowSensXY.first, hiSensXY.first, powervRef, powerExponent);
-		appliedSensY = PowerSensitivity(omegaAdjusted, lowSensXY.second, hiSensXY.second, powervRef, powerExponent);
-		break;
-	case AccelCurve::QUADRATIC:
-		appliedSensX = QuadraticSensitivity(omegaAdjusted, lowSensXY.first, hiSensXY.first, maxThreshold);
-		appliedSensY = QuadraticSensitivity(omegaAdjusted, lowSensXY.second, hiSensXY.second, maxThreshold);
-		break;
-	case AccelCurve::SIGMOID:
-		appliedSensX = SigmoidSensitivity(omegaAdjusted, lowSensXY.first, hiSensXY.first, sigmoidMid, sigmoidWidth);
-		appliedSensY = SigmoidSensitivity(omegaAdjusted, lowSensXY.second, hiSensXY.second, sigmoidMid, sigmoidWidth);
-		break;
-	case AccelCurve::JUMP:
-		appliedSensX = JumpSensitivity(omegaAdjusted, lowSensXY.first, hiSensXY.first, maxThreshold, jumpTau);
-		appliedSensY = JumpSensitivity(omegaAdjusted, lowSensXY.second, hiSensXY.second, maxThreshold, jumpTau);
-		break;
-	case AccelCurve::LINEAR:
-	case AccelCurve::INVALID:
-	default: {
-		const float t = normalizedPreCurve;
-		appliedSensX = lowSensXY.first * (1.0f - t) + hiSensXY.first * t;
-		appliedSensY = lowSensXY.second * (1.0f - t) + hiSensXY.second * t;
-		normalizedPostCurve = t;
-		break;
-	}
-	}
-
-	// Map post-curve sensitivities back to 0..1 for telemetry
-	const auto normalizeSens = [](float sens, float sMin, float sMax) -> float {
-		const float denom = sMax - sMin;
-		if (denom <= 0.0f)
-			return 0.0f;
-		return std::clamp((sens - sMin) / denom, 0.0f, 1.0f);
-	};
-	normalizedPostCurve = std::max(normalizeSens(appliedSensX, lowSensXY.first, hiSensXY.first),
-	  normalizeSens(appliedSensY, lowSensXY.second, hiSensXY.second));
+	jc->_accelCurve.evaluate(omegaAdjusted, lowSensXY.first, hiSensXY.first, lowSensXY.second, hiSensXY.second, appliedSensX, appliedSensY);
 
 	gyroXVelocity *= appliedSensX;
 	gyroYVelocity *= appliedSensY;
 
-	TelemetrySample telemetrySample;
-	telemetrySample.omega = omega;
-	// Report post-curve normalized value so the live dot follows the selected curve
-	telemetrySample.normalized = normalizedPostCurve;
-	telemetrySample.sensX = appliedSensX;
-	telemetrySample.sensY = appliedSensY;
-	telemetrySample.minThreshold = minThreshold;
-	telemetrySample.maxThreshold = maxThreshold;
-	telemetrySample.sMinX = lowSensXY.first;
-	telemetrySample.sMaxX = hiSensXY.first;
-	telemetrySample.sMinY = lowSensXY.second;
-	telemetrySample.sMaxY = hiSensXY.second;
-	for (const auto &entry : handle_to_joyshock)
+	if (Telemetry::IsSendDue())
 	{
-		const auto &device = entry.second;
-		TelemetryDevice dev;
-		dev.handle = device->_handle;
-		dev.controllerType = device->_controllerType;
-		dev.splitType = device->_splitType;
-		dev.vendorId = jsl->GetControllerVendor(device->_handle);
-		dev.productId = jsl->GetControllerProduct(device->_handle);
-		telemetrySample.devices.push_back(dev);
+		// Map post-curve sensitivities back to 0..1 for telemetry
+		const auto normalizeSens = [](float sens, float sMin, float sMax) -> float {
+			const float denom = sMax - sMin;
+			if (denom <= 0.0f)
+				return 0.0f;
+			return std::clamp((sens - sMin) / denom, 0.0f, 1.0f);
+		};
+		float normalizedPostCurve = std::max(normalizeSens(appliedSensX, lowSensXY.first, hiSensXY.first),
+		  normalizeSens(appliedSensY, lowSensXY.second, hiSensXY.second));
+
+		TelemetrySample telemetrySample;
+		telemetrySample.omega = omega;
+		// Report post-curve normalized value so the live dot follows the selected curve
+		telemetrySample.normalized = normalizedPostCurve;
+		telemetrySample.sensX = appliedSensX;
+		telemetrySample.sensY = appliedSensY;
+		telemetrySample.minThreshold = minThreshold;
+		telemetrySample.maxThreshold = maxThreshold;
+		telemetrySample.sMinX = lowSensXY.first;
+		telemetrySample.sMaxX = hiSensXY.first;
+		telemetrySample.sMinY = lowSensXY.second;
+		telemetrySample.sMaxY = hiSensXY.second;
+		telemetrySample.curve = magic_enum::enum_name(accelCurve).data();
+		Telemetry::MaybeSend(telemetrySample);
 	}
-	Telemetry::MaybeSend(telemetrySample);
 
 	jc->gyroXVelocity = gyroXVelocity;
 	jc->gyroYVelocity = gyroYVelocity;
 
-	jc->_timeNow = chrono::steady_clock::now();
+	if (!backend->ProvidesTimeStep())
+	{
+		jc->_timeNow = chrono::steady_clock::now();
+	}
 
 	// sticks!
 	jc->processed_gyro_stick = false;
@@ -1029,8 +1070,8 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	{
 		// let's do these sticks... don't want to constantly send input, so we need to compare them to last time
 		auto axisSign = jc->getSetting<AxisSignPair>(SettingID::LEFT_STICK_AXIS);
-		float calX = jsl->GetLeftX(jc->_handle) * float(axisSign.first);
-		float calY = jsl->GetLeftY(jc->_handle) * float(axisSign.second);
+		float calX = frame.leftX * float(axisSign.first);
+		float calY = frame.leftY * float(axisSign.second);
 
 		jc->processStick(calX, calY, jc->_leftStick, mouseCalibrationFactor, deltaTime, leftAny, lockMouse, camSpeedX, camSpeedY);
 		jc->_leftStick.lastX = calX;
@@ -1040,8 +1081,8 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	if (jc->_splitType != JS_SPLIT_TYPE_LEFT)
 	{
 		auto axisSign = jc->getSetting<AxisSignPair>(SettingID::RIGHT_STICK_AXIS);
-		float calX = jsl->GetRightX(jc->_handle) * float(axisSign.first);
-		float calY = jsl->GetRightY(jc->_handle) * float(axisSign.second);
+		float calX = frame.rightX * float(axisSign.first);
+		float calY = frame.rightY * float(axisSign.second);
 
 		jc->processStick(calX, calY, jc->_rightStick, mouseCalibrationFactor, deltaTime, rightAny, lockMouse, camSpeedX, camSpeedY);
 		jc->_rightStick.lastX = calX;
@@ -1151,7 +1192,7 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 		}
 	}
 
-	int buttons = jsl->GetButtons(jc->_handle);
+	int buttons = frame.buttons;
 	// button mappings
 	if (jc->_splitType != JS_SPLIT_TYPE_RIGHT)
 	{
@@ -1163,10 +1204,10 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 		jc->handleButtonChange(ButtonID::MINUS, buttons & (1 << JSOFFSET_MINUS));
 		jc->handleButtonChange(ButtonID::L3, buttons & (1 << JSOFFSET_LCLICK));
 
-		float lTrigger = jsl->GetLeftTrigger(jc->_handle);
+		float lTrigger = frame.leftTrigger;
 		jc->handleTriggerChange(ButtonID::ZL, ButtonID::ZLF, jc->getSetting<TriggerMode>(SettingID::ZL_MODE), lTrigger, jc->_leftEffect);
 
-		bool touch = jsl->GetTouchDown(jc->_handle, false) || jsl->GetTouchDown(jc->_handle, true);
+		bool touch = frame.touch.t0Down || frame.touch.t1Down;
 		switch (jc->_controllerType)
 		{
 		case JS_TYPE_DS:
@@ -1224,7 +1265,7 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 		jc->handleButtonChange(ButtonID::HOME, buttons & (1 << JSOFFSET_HOME));
 		jc->handleButtonChange(ButtonID::R3, buttons & (1 << JSOFFSET_RCLICK));
 
-		float rTrigger = jsl->GetRightTrigger(jc->_handle);
+		float rTrigger = frame.rightTrigger;
 		jc->handleTriggerChange(ButtonID::ZR, ButtonID::ZRF, jc->getSetting<TriggerMode>(SettingID::ZR_MODE), rTrigger, jc->_rightEffect);
 	}
 	else
@@ -1238,13 +1279,13 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	if (at == Switch::OFF)
 	{
 		AdaptiveTriggerSetting none;
-		jsl->SetTriggerEffect(jc->_handle, none, none);
+		backend->SetTriggerEffect(jc->_handle, none, none);
 	}
 	else
 	{
 		auto leftEffect = jc->getSetting<AdaptiveTriggerSetting>(SettingID::LEFT_TRIGGER_EFFECT);
 		auto rightEffect = jc->getSetting<AdaptiveTriggerSetting>(SettingID::RIGHT_TRIGGER_EFFECT);
-		jsl->SetTriggerEffect(jc->_handle, leftEffect.mode == AdaptiveTriggerMode::ON ? jc->_leftEffect : leftEffect,
+		backend->SetTriggerEffect(jc->_handle, leftEffect.mode == AdaptiveTriggerMode::ON ? jc->_leftEffect : leftEffect,
 		  rightEffect.mode == AdaptiveTriggerMode::ON ? jc->_rightEffect : rightEffect);
 	}
 
@@ -1253,9 +1294,13 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	                               {
 		                               return pair.first == ButtonID::MIC;
 	                               }) != jc->_context->activeTogglesQueue.cend();
-	for (auto controller : handle_to_joyshock)
+	if (currentMicToggleState != jc->_micLight)
 	{
-		jsl->SetMicLight(controller.first, currentMicToggleState ? 1 : 0);
+		jc->_micLight = currentMicToggleState;
+		for (auto &controller : handle_to_joyshock)
+		{
+			backend->SetMicLight(controller.first, currentMicToggleState ? 1 : 0);
+		}
 	}
 
 	GyroOutput gyroOutput = jc->getSetting<GyroOutput>(SettingID::GYRO_OUTPUT);
@@ -1285,7 +1330,7 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	{
 		// COUT << "GX: %0.4f GY: %0.4f GZ: %0.4f\n", imuState.gyroX, imuState.gyroY, imuState.gyroZ);
 		float mouseCalibration = jc->getSetting(SettingID::REAL_WORLD_CALIBRATION) / os_mouse_speed / jc->getSetting(SettingID::IN_GAME_SENS);
-		shapedSensitivityMoveMouse(gyroXVelocity * mouseCalibration, gyroYVelocity * mouseCalibration, deltaTime, camSpeedX, -camSpeedY);
+		shapedSensitivityMoveMouse(gyroXVelocity * mouseCalibration, gyroYVelocity * mouseCalibration, motionDeltaTime, camSpeedX, -camSpeedY, jc->_mouseRemainder);
 	}
 
 	if (jc->_context->_vigemController)
@@ -1295,7 +1340,7 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	auto newColor = jc->getSetting<Color>(SettingID::LIGHT_BAR);
 	if (jc->_light_bar != newColor)
 	{
-		jsl->SetLightColour(jc->_handle, newColor.raw);
+		backend->SetLightColour(jc->_handle, newColor.raw);
 		jc->_light_bar = newColor;
 	}
 	if (jc->_context->nn)
@@ -1305,15 +1350,78 @@ void joyShockPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE l
 	jc->_context->callback_lock.unlock();
 }
 
+// Devices are only reported to telemetry when they change, not with each sample
+static void PublishTelemetryRoster()
+{
+	TelemetryRoster roster;
+	for (const auto &entry : handle_to_joyshock)
+	{
+		if (roster.deviceCount >= roster.devices.size())
+			break;
+		const auto &device = entry.second;
+		TelemetryDevice &dev = roster.devices[roster.deviceCount++];
+		dev.handle = device->_handle;
+		dev.controllerType = device->_controllerType;
+		dev.splitType = device->_splitType;
+		dev.vendorId = device->_vendorId;
+		dev.productId = device->_productId;
+	}
+	Telemetry::SetRoster(roster);
+}
+
+GyroCalibrationStore::Key gyroCalibrationKey(int handle)
+{
+	shared_ptr<JslWrapper> backend = jsl.load();
+	return { backend->GetControllerVendor(handle), backend->GetControllerProduct(handle), backend->GetControllerSerial(handle) };
+}
+
+// Start the devices from the offsets of their last calibration
+void loadGyroCalibrations()
+{
+	if (!gyroCalibrations || !jsl.load()->IsLive())
+	{
+		return;
+	}
+	// As many samples as a few seconds of continuous calibration, so that it can still adjust the offset
+	static constexpr int STORED_CALIBRATION_WEIGHT = 1000;
+	for (auto &[handle, jc] : handle_to_joyshock)
+	{
+		if (auto offset = gyroCalibrations->find(gyroCalibrationKey(handle)))
+		{
+			jc->_motion->SetCalibrationOffset(offset->x, offset->y, offset->z, STORED_CALIBRATION_WEIGHT);
+			COUT << "Loaded the gyro calibration of device " << handle << '\n';
+		}
+	}
+}
+
+void saveGyroCalibrations()
+{
+	if (!gyroCalibrations || !jsl.load()->IsLive() || handle_to_joyshock.empty())
+	{
+		return;
+	}
+	for (auto &[handle, jc] : handle_to_joyshock)
+	{
+		GyroCalibrationStore::Offset offset;
+		jc->_motion->GetCalibrationOffset(offset.x, offset.y, offset.z);
+		gyroCalibrations->set(gyroCalibrationKey(handle), offset);
+	}
+	if (!gyroCalibrations->save())
+	{
+		CERR << "Cannot save the gyro calibration to " << gyroCalibrations->path() << '\n';
+	}
+}
+
 void connectDevices(bool mergeJoycons = true)
 {
 	handle_to_joyshock.clear();
 	this_thread::sleep_for(100ms);
-	int numConnected = jsl->ConnectDevices();
+	shared_ptr<JslWrapper> backend = jsl.load();
+	int numConnected = backend->ConnectDevices();
 	vector<int> deviceHandles(numConnected, 0);
 	if (numConnected > 0)
 	{
-		numConnected = jsl->GetConnectedDeviceHandles(&deviceHandles[0], numConnected);
+		numConnected = backend->GetConnectedDeviceHandles(&deviceHandles[0], numConnected);
 
 		if (numConnected < deviceHandles.size())
 		{
@@ -1323,7 +1431,7 @@ void connectDevices(bool mergeJoycons = true)
 
 		for (auto handle : deviceHandles) // Don't use foreach!
 		{
-			auto type = jsl->GetControllerSplitType(handle);
+			auto type = backend->GetControllerSplitType(handle);
 			auto otherJoyCon = find_if(handle_to_joyshock.begin(), handle_to_joyshock.end(),
 			  [type](auto &pair)
 			  {
@@ -1343,7 +1451,9 @@ void connectDevices(bool mergeJoycons = true)
 		}
 
 		UpdateIgnoredGyroDevices();
+		loadGyroCalibrations();
 	}
+	PublishTelemetryRoster();
 
 	if (numConnected == 1)
 	{
@@ -1417,6 +1527,8 @@ bool do_NO_GYRO_BUTTON()
 
 bool do_RESET_MAPPINGS(CmdRegistry *registry)
 {
+	// Listeners hear of the settings once, after OnReset.txt
+	SettingsTransaction transaction;
 	COUT << "Resetting all mappings to defaults\n";
 	static constexpr auto callReset = [](JSMButton &map)
 	{
@@ -1465,10 +1577,11 @@ bool do_RECONNECT_CONTROLLERS(string_view arguments, std::function<void()> loadO
 	// else remember last
 	 
 	COUT << "Reconnecting controllers: " << (mergeJoycons ? "MERGE" : "SPLIT") << '\n';
-	jsl->DisconnectAndDisposeAll();
+	shared_ptr<JslWrapper> backend = jsl.load();
+	backend->DisconnectAndDisposeAll();
 	connectDevices(mergeJoycons);
-	jsl->SetCallback(&joyShockPollCallback);
-	jsl->SetTouchCallback(&touchCallback);
+	backend->SetCallback(&joyShockPollCallback);
+	backend->SetTouchCallback(&touchCallback);
 
 	if (loadOnReconnect)
 		loadOnReconnect();
@@ -1529,6 +1642,17 @@ bool do_FINISH_GYRO_CALIBRATION()
 		iter->second->_motion->PauseContinuousCalibration();
 	}
 	devicesCalibrating = false;
+	saveGyroCalibrations();
+	return true;
+}
+
+bool do_MOTION_REPORT_STATS()
+{
+	for (auto iter = handle_to_joyshock.begin(); iter != handle_to_joyshock.end(); ++iter)
+	{
+		ImuReportStats stats = jsl.load()->GetIMUReportStats(iter->first);
+		COUT << "Device " << iter->first << ": " << stats.dropped << " motion reports lost, " << stats.duplicated << " repeated\n";
+	}
 	return true;
 }
 
@@ -1589,6 +1713,132 @@ bool do_SLEEP(string_view argument)
 	return true;
 }
 
+bool do_RECORD(string_view argument)
+{
+	if (argument.empty())
+	{
+		if (InputRecording::IsRecording())
+		{
+			COUT << "Recording stopped after " << InputRecording::Stop() << " ticks\n";
+		}
+		else
+		{
+			COUT << "Nothing is being recorded\n";
+		}
+		return true;
+	}
+	string error;
+	if (!InputRecording::Start(string(argument), error))
+	{
+		CERR << "Cannot record to " << argument << ": " << error << '\n';
+		return false;
+	}
+	COUT << "Recording controller input to " << argument << ". Enter RECORD on its own to stop.\n";
+	return true;
+}
+
+bool do_REPLAY(string_view arguments)
+{
+	if (arguments.empty())
+	{
+		if (!liveJsl)
+		{
+			COUT << "Nothing is being replayed\n";
+			return true;
+		}
+		// A callback still running on the replay keeps its own copy of it
+		jsl.load()->DisconnectAndDisposeAll();
+		jsl.store(move(liveJsl));
+		COUT << "Replay stopped. Back to the controllers.\n";
+	}
+	else
+	{
+		static constexpr string_view FAST = " FAST";
+		bool fast = arguments.size() > FAST.size() && arguments.ends_with(FAST);
+		string path(fast ? arguments.substr(0, arguments.size() - FAST.size()) : arguments);
+		string error;
+		shared_ptr<JslWrapper> replay(InputRecording::OpenReplay(path, !fast, error));
+		if (!replay)
+		{
+			CERR << "Cannot replay " << path << ": " << error << '\n';
+			return false;
+		}
+		jsl.load()->DisconnectAndDisposeAll();
+		shared_ptr<JslWrapper> previous = jsl.exchange(replay);
+		if (!liveJsl)
+		{
+			liveJsl = move(previous);
+		}
+		COUT << "Replaying " << path << (fast ? " as fast as possible" : "") << ". Enter REPLAY on its own to go back to the controllers.\n";
+	}
+	connectDevices();
+	shared_ptr<JslWrapper> backend = jsl.load();
+	backend->SetCallback(&joyShockPollCallback);
+	backend->SetTouchCallback(&touchCallback);
+	return true;
+}
+
+static OfflineRender::Benchmark *benchmark = nullptr;
+
+void benchmarkPollCallback(int jcHandle, JOY_SHOCK_STATE state, JOY_SHOCK_STATE lastState, IMU_STATE imuState, IMU_STATE lastImuState, float deltaTime)
+{
+	benchmark->begin();
+	joyShockPollCallback(jcHandle, state, lastState, imuState, lastImuState, deltaTime);
+	benchmark->end();
+}
+
+// Plays the recording through the one config of the job and writes what would have been sent to the OS,
+// or for a benchmark, times each tick and throws the output away
+int runRender(CmdRegistry &commandRegistry, const OfflineRender::Job &job, InputRecording::Replay &replay)
+{
+	const string &config = job.configs.front();
+	string outputPath;
+	if (!job.benchmark)
+	{
+		error_code error;
+		filesystem::create_directories(job.outputFolder, error);
+		outputPath = OfflineRender::OutputPath(job, config);
+	}
+	OfflineRender::Sink sink(outputPath, replay);
+	if (!job.benchmark && !sink.isOpen())
+	{
+		CERR << "Cannot write to " << outputPath << '\n';
+		return 1;
+	}
+	setOutputSink(&sink);
+
+	SettingsManager::getV<Switch>(SettingID::AUTOLOAD)->set(Switch::OFF);
+	do_RESET_MAPPINGS(&commandRegistry);
+	if (!commandRegistry.loadConfigFile(config))
+	{
+		CERR << "Cannot load " << config << '\n';
+		setOutputSink(nullptr);
+		return 1;
+	}
+	OfflineRender::Benchmark ticks;
+	benchmark = &ticks;
+	connectDevices();
+	replay.SetTouchCallback(&touchCallback);
+	replay.SetCallback(job.benchmark ? &benchmarkPollCallback : &joyShockPollCallback); // Starts the replay
+	while (!replay.finished())
+	{
+		this_thread::sleep_for(10ms);
+	}
+	replay.DisconnectAndDisposeAll();
+	handle_to_joyshock.clear();
+	setOutputSink(nullptr);
+	benchmark = nullptr;
+	if (job.benchmark)
+	{
+		COUT << "Benchmarked " << config << " with " << job.recording << '\n' << ticks.report();
+	}
+	else
+	{
+		COUT << "Rendered " << config << " to " << outputPath << '\n';
+	}
+	return 0;
+}
+
 bool do_README()
 {
 	auto err = ShowOnlineHelp();
@@ -1649,12 +1899,12 @@ void beforeShowTrayMenu()
 		  { WriteToConsole("RECONNECT_CONTROLLERS"); });
 		tray->AddMenuItem(
 		  U("AutoLoad"), [](bool isChecked)
-		  { SettingsManager::get<Switch>(SettingID::AUTOLOAD)->set(isChecked ? Switch::ON : Switch::OFF); },
+		  { SettingsManager::getV<Switch>(SettingID::AUTOLOAD)->set(isChecked ? Switch::ON : Switch::OFF); },
 		  bind(&PollingThread::isRunning, autoLoadThread.get()));
 
 		tray->AddMenuItem(
 		  U("AutoConnect"), [](bool isChecked)
-		  { SettingsManager::get<Switch>(SettingID::AUTOCONNECT)->set(isChecked ? Switch::ON : Switch::OFF); },
+		  { SettingsManager::getV<Switch>(SettingID::AUTOCONNECT)->set(isChecked ? Switch::ON : Switch::OFF); },
 		  bind(&PollingThread::isRunning, autoConnectThread.get()));
 
 		if (whitelister && whitelister->IsAvailable())
@@ -1716,12 +1966,13 @@ void beforeShowTrayMenu()
 void cleanUp()
 {
 	Telemetry::Shutdown();
+	InputRecording::Stop();
 	if (tray)
 	{
 		tray->Hide();
 	}
 	HideConsole();
-	jsl->DisconnectAndDisposeAll();
+	jsl.load()->DisconnectAndDisposeAll();
 	handle_to_joyshock.clear(); // Destroy Vigem Gamepads
 	ReleaseConsole();
 }
@@ -1796,6 +2047,11 @@ float filterTickTime(float c, float next)
 	return max(1.f, min(100.f, round(next)));
 }
 
+float filterMouseOutputRate(float c, float next)
+{
+	return next <= 0.f ? 0.f : max(100.f, min(8000.f, next));
+}
+
 Mapping filterMapping(Mapping current, Mapping next)
 {
 	auto virtual_controller = SettingsManager::getV<ControllerScheme>(SettingID::VIRTUAL_CONTROLLER);
@@ -1820,7 +2076,7 @@ TriggerMode filterTriggerMode(TriggerMode current, TriggerMode next)
 	// With SDL, I'm not sure if we have a reliable way to check if the device has analog or digital triggers. There's a function to query them, but I don't know if it works with the devices with custom readers (Switch, PS)
 	/*	for (auto &js : handle_to_joyshock)
 	{
-	    if (jsl->GetControllerType(js.first) != JS_TYPE_DS4 && next != TriggerMode::NO_FULL)
+	    if (jsl.load()->GetControllerType(js.first) != JS_TYPE_DS4 && next != TriggerMode::NO_FULL)
 	    {
 	        COUT_WARN << "WARNING: Dual Stage Triggers are only valid on analog triggers. Full pull bindings will be ignored on non DS4 controllers.\n";
 	        break;
@@ -1910,8 +2166,13 @@ GyroOutput filterGyroOutput(GyroOutput current, GyroOutput next)
 	return filterInvalidValue<GyroOutput, GyroOutput::INVALID>(current, next);
 }
 
-void updateRingModeFromStickMode(JSMVariable<RingMode> *stickRingMode, const StickMode &newValue)
+void updateRingModeFromStickMode(JSMVariable<RingMode> *stickRingMode, const JSMVariable<StickMode> *stickMode, const StickMode &newValue)
 {
+	if (stickRingMode->setAt() >= stickMode->changedAt())
+	{
+		// The ring mode was set since, so it wins
+		return;
+	}
 	if (newValue == StickMode::INNER_RING)
 	{
 		stickRingMode->set(RingMode::INNER);
@@ -1928,18 +2189,15 @@ ControllerScheme updateVirtualController(ControllerScheme prevScheme, Controller
 	bool success = true;
 	for (auto &js : handle_to_joyshock)
 	{
-		lock_guard guard(js.second->_context->callback_lock);
-		if (!js.second->_context->_vigemController ||
-		  js.second->_context->_vigemController->getType() != nextScheme)
+		auto &context = *js.second->_context;
+		if (context.virtualScheme != nextScheme)
 		{
-			if (nextScheme == ControllerScheme::NONE)
-			{
-				js.second->_context->_vigemController.reset(nullptr);
-			}
-			else
+			// The new controller is made here, and swapped in on the next tick
+			unique_ptr<Gamepad> gamepad;
+			if (nextScheme != ControllerScheme::NONE)
 			{
-				js.second->_context->_vigemController.reset(Gamepad::getNew(nextScheme, bind(&JoyShock::onVirtualControllerNotification, js.second.get(), placeholders::_1, placeholders::_2, placeholders::_3)));
-				success &= js.second->_context->_vigemController && js.second->_context->_vigemController->isInitialized(&error);
+				gamepad.reset(Gamepad::getNew(nextScheme, bind(&JoyShock::onVirtualControllerNotification, js.second.get(), placeholders::_1, placeholders::_2, placeholders::_3)));
+				success &= gamepad && gamepad->isInitialized(&error);
 				if (!error.empty())
 				{
 					CERR << error << '\n';
@@ -1947,10 +2205,16 @@ ControllerScheme updateVirtualController(ControllerScheme prevScheme, Controller
 				}
 				if (!success)
 				{
-					js.second->_context->_vigemController.release();
-					break;
+					gamepad.release();
 				}
 			}
+			context.virtualScheme = success ? nextScheme : ControllerScheme::NONE;
+			context.pendingChanges.publish([&context, gamepad = move(gamepad)]() mutable
+			  { context._vigemController = move(gamepad); });
+			if (!success)
+			{
+				break;
+			}
 		}
 	}
 	return success ? nextScheme : prevScheme;
@@ -1960,10 +2224,10 @@ void onVirtualControllerChange(const ControllerScheme &newScheme)
 {
 	for (auto &js : handle_to_joyshock)
 	{
-		// Display an error message if any vigem is no good.
-		lock_guard guard(js.second->_context->callback_lock);
-		if (!js.second->hasVirtualController())
+		// Display an error message if any vigem is no good. The controllers themselves are only swapped on the next tick.
+		if (js.second->_context->virtualScheme != newScheme)
 		{
+			CERR << "[ViGEm Client] The controller is of the wrong type!\n";
 			break;
 		}
 	}
@@ -1978,7 +2242,32 @@ void refreshAutoLoadHelp(JSMAssignment<Switch> *autoloadCmd)
 	autoloadCmd->setHelp(ss.str());
 }
 
-void onNewGridDimensions(CmdRegistry *registry, const FloatXY &newGridDims)
+// Runs the change on the input thread of every controller, at the start of its next tick. With now, runs it right
+// away under the lock of the input thread instead, after the changes still pending, for changes that must be done
+// before returning. An idle controller may not tick for a long time.
+static void changeEveryController(function<void(JoyShock &)> change, bool now)
+{
+	for (auto &js : handle_to_joyshock)
+	{
+		if (now)
+		{
+			lock_guard guard(js.second->_context->callback_lock);
+			js.second->_context->pendingChanges.apply();
+			change(*js.second);
+			continue;
+		}
+		js.second->_context->pendingChanges.publish([controller = weak_ptr<JoyShock>(js.second), change]
+		  {
+			  if (auto js = controller.lock())
+			  {
+				  change(*js);
+			  }
+		  });
+	}
+}
+
+// The controllers only take the grid a profile ends with, and the extra touch buttons are removed then.
+void onGridDimensionsCommitted(CmdRegistry *registry, const FloatXY &newGridDims)
 {
 	_ASSERT_EXPR(registry, U("You forgot to bind the command registry properly!"));
 	auto numberOfButtons = size_t(newGridDims.first * newGridDims.second);
@@ -1993,57 +2282,58 @@ void onNewGridDimensions(CmdRegistry *registry, const FloatXY &newGridDims)
 			successfulRemove = registry->Remove(name);
 		}
 
-		// For all joyshocks, remove extra touch DigitalButtons
-		for (auto &js : handle_to_joyshock)
-		{
-			lock_guard guard(js.second->_context->callback_lock);
-			js.second->updateGridSize();
-		}
+		// For all joyshocks, remove extra touch DigitalButtons. They refer to the variables, so they go first.
+		changeEveryController([numberOfButtons](JoyShock &js)
+		  { js.updateGridSize(numberOfButtons); }, true);
 
 		// Remove extra touch button variables
 		while (grid_mappings.size() > numberOfButtons)
 			grid_mappings.pop_back();
 	}
-	else if (numberOfButtons > grid_mappings.size())
+	else
 	{
-		// Add new touch button variables and commands
-		for (int id = FIRST_TOUCH_BUTTON + int(grid_mappings.size()); grid_mappings.size() < numberOfButtons; ++id)
-		{
-			JSMButton touchButton(*magic_enum::enum_cast<ButtonID>(id), Mapping::NO_MAPPING);
-			touchButton.setFilter(&filterMapping);
-			grid_mappings.push_back(touchButton);
-			registry->add(new JSMAssignment<Mapping>(grid_mappings.back()));
-		}
+		// For all joyshocks, add the new touch DigitalButtons
+		changeEveryController([numberOfButtons](JoyShock &js)
+		  { js.updateGridSize(numberOfButtons); }, false);
+	}
+}
 
-		// For all joyshocks, remove extra touch DigitalButtons
-		for (auto &js : handle_to_joyshock)
-		{
-			lock_guard guard(js.second->_context->callback_lock);
-			js.second->updateGridSize();
-		}
+// Later commands may bind the new touch buttons, so their commands are added as soon as the grid grows. The rest
+// waits for the grid size the transaction ends with, even if it's the one it started with.
+void onNewGridDimensions(CmdRegistry *registry, const JSMVariable<FloatXY> *gridSize, const FloatXY &newGridDims)
+{
+	_ASSERT_EXPR(registry, U("You forgot to bind the command registry properly!"));
+	auto numberOfButtons = size_t(newGridDims.first * newGridDims.second);
+
+	// Add new touch button variables and commands
+	for (int id = FIRST_TOUCH_BUTTON + int(grid_mappings.size()); grid_mappings.size() < numberOfButtons; ++id)
+	{
+		JSMButton touchButton(*magic_enum::enum_cast<ButtonID>(id), Mapping::NO_MAPPING);
+		touchButton.setFilter(&filterMapping);
+		grid_mappings.push_back(touchButton);
+		registry->add(new JSMAssignment<Mapping>(grid_mappings.back()));
 	}
-	// Else numbers are the same, possibly just reconfigured
+	SettingsTransaction::notify(&grid_mappings, [registry, gridSize]()
+	  { onGridDimensionsCommitted(registry, gridSize->value()); });
 }
 
-void onNewStickAxis(AxisMode newAxisMode, bool isVertical)
+// Both signs are applied together: once one of them is, the stick axes count as set after the other.
+void onNewStickAxis(const JSMVariable<AxisMode> *aimX, const JSMVariable<AxisMode> *aimY)
 {
 	static auto left_stick_axis = SettingsManager::get<AxisSignPair>(SettingID::LEFT_STICK_AXIS);
 	static auto right_stick_axis = SettingsManager::get<AxisSignPair>(SettingID::RIGHT_STICK_AXIS);
 	static auto motion_stick_axis = SettingsManager::get<AxisSignPair>(SettingID::MOTION_STICK_AXIS);
 	static auto touch_stick_axis = SettingsManager::get<AxisSignPair>(SettingID::TOUCH_STICK_AXIS);
-	if (isVertical)
+	for (auto stickAxis : { left_stick_axis, right_stick_axis, motion_stick_axis, touch_stick_axis })
 	{
-		left_stick_axis->set(AxisSignPair{ left_stick_axis->value().first, newAxisMode });
-		right_stick_axis->set(AxisSignPair{ right_stick_axis->value().first, newAxisMode });
-		motion_stick_axis->set(AxisSignPair{ motion_stick_axis->value().first, newAxisMode });
-		touch_stick_axis->set(AxisSignPair{ touch_stick_axis->value().first, newAxisMode });
-	}
-	else // is horizontal
-	{
-		left_stick_axis->set(AxisSignPair{ newAxisMode, left_stick_axis->value().second });
-		right_stick_axis->set(AxisSignPair{ newAxisMode, right_stick_axis->value().second });
-		motion_stick_axis->set(AxisSignPair{ newAxisMode, motion_stick_axis->value().second });
-		touch_stick_axis->set(AxisSignPair{ newAxisMode, touch_stick_axis->value().second });
+		// Skip the signs the stick axis was set since
+		bool horizontal = aimX->changedAt() > stickAxis->setAt();
+		bool vertical = aimY->changedAt() > stickAxis->setAt();
+		if (horizontal || vertical)
+		{
+			stickAxis->set(AxisSignPair{ horizontal ? aimX->value() : stickAxis->value().first,
+			  vertical ? aimY->value() : stickAxis->value().second });
+		}
 	}
 }
 
@@ -2236,7 +2526,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 
 	auto left_stick_mode = new JSMSetting<StickMode>(SettingID::LEFT_STICK_MODE, StickMode::NO_MOUSE);
 	left_stick_mode->setFilter(&filterStickMode);
-	left_stick_mode->addOnChangeListener(bind(&updateRingModeFromStickMode, left_ring_mode, placeholders::_1));
+	left_stick_mode->addOnCommitListener(bind(&updateRingModeFromStickMode, left_ring_mode, left_stick_mode, placeholders::_1));
 	SettingsManager::add(left_stick_mode);
 	commandRegistry->add((new JSMAssignment<StickMode>(*left_stick_mode))
 	                       ->setHelp("Set a mouse mode for the left stick. Valid values are the following:\nNO_MOUSE, AIM, FLICK, FLICK_ONLY, ROTATE_ONLY, MOUSE_RING, MOUSE_AREA, OUTER_RING, INNER_RING, SCROLL_WHEEL, LEFT_STICK, RIGHT_STICK"));
@@ -2249,7 +2539,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 
 	auto right_stick_mode = new JSMSetting<StickMode>(SettingID::RIGHT_STICK_MODE, StickMode::NO_MOUSE);
 	right_stick_mode->setFilter(&filterStickMode);
-	right_stick_mode->addOnChangeListener(bind(&updateRingModeFromStickMode, right_ring_mode, ::placeholders::_1));
+	right_stick_mode->addOnCommitListener(bind(&updateRingModeFromStickMode, right_ring_mode, right_stick_mode, ::placeholders::_1));
 	SettingsManager::add(right_stick_mode);
 	commandRegistry->add((new JSMAssignment<StickMode>(*right_stick_mode))
 	                       ->setHelp("Set a mouse mode for the right stick. Valid values are the following:\nNO_MOUSE, AIM, FLICK, FLICK_ONLY, ROTATE_ONLY, MOUSE_RING, MOUSE_AREA, OUTER_RING, INNER_RING LEFT_STICK, RIGHT_STICK"));
@@ -2262,7 +2552,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 
 	auto motion_stick_mode = new JSMSetting<StickMode>(SettingID::MOTION_STICK_MODE, StickMode::NO_MOUSE);
 	motion_stick_mode->setFilter(&filterMotionStickMode);
-	motion_stick_mode->addOnChangeListener(bind(&updateRingModeFromStickMode, motion_ring_mode, ::placeholders::_1));
+	motion_stick_mode->addOnCommitListener(bind(&updateRingModeFromStickMode, motion_ring_mode, motion_stick_mode, ::placeholders::_1));
 	SettingsManager::add(motion_stick_mode);
 	commandRegistry->add((new JSMAssignment<StickMode>(*motion_stick_mode))
 	                       ->setHelp("Set a mouse mode for the motion-stick -- the whole controller is treated as a stick. Valid values are the following:\nNO_MOUSE, AIM, FLICK, FLICK_ONLY, ROTATE_ONLY, MOUSE_RING, MOUSE_AREA, OUTER_RING, INNER_RING LEFT_STICK, RIGHT_STICK"));
@@ -2321,7 +2611,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<string>(*ignore_gyro_devices))
 	                       ->setParser(ignoreParser)
 	                       ->setHelp("Space-separated list of VID:PID pairs (hex) whose gyro should be ignored, e.g. IGNORE_GYRO_DEVICES = 0x054c:0x0ce6"));
-	ignore_gyro_devices->addOnChangeListener([](const string &) { UpdateIgnoredGyroDevices(); });
+	ignore_gyro_devices->addOnCommitListener([](const string &) { UpdateIgnoredGyroDevices(); });
 
 	auto zlMode = new JSMSetting<TriggerMode>(SettingID::ZL_MODE, TriggerMode::NO_FULL);
 	zlMode->setFilter(&filterTriggerMode);
@@ -2411,6 +2701,12 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<float>(*accel_jump_tau))
 	                       ->setHelp("Jump curve: rise length (smaller = steeper) before reaching peak sensitivity."));
 
+	auto accel_curve_table = new JSMVariable<Switch>(Switch::OFF);
+	accel_curve_table->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
+	SettingsManager::add(SettingID::ACCEL_CURVE_TABLE, accel_curve_table);
+	commandRegistry->add((new JSMAssignment<Switch>(magic_enum::enum_name(SettingID::ACCEL_CURVE_TABLE).data(), *accel_curve_table))
+	                       ->setHelp("When ON, the NATURAL, POWER, SIGMOID and JUMP curves are read from a precomputed table instead of being calculated on every tick. The difference in sensitivity is under 0.1%. Valid values are ON and OFF."));
+
 	auto stick_power = new JSMSetting<float>(SettingID::STICK_POWER, 1.0f);
 	stick_power->setFilter(&filterFloat);
 	SettingsManager::add(stick_power);
@@ -2473,15 +2769,17 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 
 	// Legacy command
 	auto aim_x_sign = new JSMSetting<AxisMode>(SettingID::STICK_AXIS_X, AxisMode::STANDARD);
-	aim_x_sign->setFilter(&filterInvalidValue<AxisMode, AxisMode::INVALID>)->addOnChangeListener(bind(onNewStickAxis, placeholders::_1, false));
+	aim_x_sign->setFilter(&filterInvalidValue<AxisMode, AxisMode::INVALID>);
 	SettingsManager::add(aim_x_sign);
 	commandRegistry->add(new JSMAssignment<AxisMode>(*aim_x_sign, true));
 
 	// Legacy command
 	auto aim_y_sign = new JSMSetting<AxisMode>(SettingID::STICK_AXIS_Y, AxisMode::STANDARD);
-	aim_y_sign->setFilter(&filterInvalidValue<AxisMode, AxisMode::INVALID>)->addOnChangeListener(bind(onNewStickAxis, placeholders::_1, true));
+	aim_y_sign->setFilter(&filterInvalidValue<AxisMode, AxisMode::INVALID>);
 	SettingsManager::add(aim_y_sign);
 	commandRegistry->add(new JSMAssignment<AxisMode>(*aim_y_sign, true));
+	aim_x_sign->addOnCommitListener(bind(onNewStickAxis, aim_x_sign, aim_y_sign));
+	aim_y_sign->addOnCommitListener(bind(onNewStickAxis, aim_x_sign, aim_y_sign));
 
 	auto gyro_x_sign = new JSMSetting<AxisMode>(SettingID::GYRO_AXIS_Y, AxisMode::STANDARD);
 	gyro_x_sign->setFilter(&filterInvalidValue<AxisMode, AxisMode::INVALID>);
@@ -2519,6 +2817,18 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<float>(*gyro_smooth_threshold))
 	                       ->setHelp("When the controller's angular velocity is below this threshold (in degrees per second), smoothing will be applied."));
 
+	auto gyro_smooth_kernel = new JSMSetting<GyroSmoothKernel>(SettingID::GYRO_SMOOTH_KERNEL, GyroSmoothKernel::WINDOW);
+	gyro_smooth_kernel->setFilter(&filterInvalidValue<GyroSmoothKernel, GyroSmoothKernel::INVALID>);
+	SettingsManager::add(gyro_smooth_kernel);
+	commandRegistry->add((new JSMAssignment<GyroSmoothKernel>(*gyro_smooth_kernel))
+	                       ->setHelp("How gyro smoothing is computed. WINDOW averages the last GYRO_SMOOTH_TIME seconds. EXPONENTIAL is a low pass with the same average delay. ONE_EURO is a low pass that lets fast movement through with less delay, tuned with GYRO_SMOOTH_BETA. Valid values are WINDOW, EXPONENTIAL and ONE_EURO."));
+
+	auto gyro_smooth_beta = new JSMSetting<float>(SettingID::GYRO_SMOOTH_BETA, 0.01f);
+	gyro_smooth_beta->setFilter(&filterPositive);
+	SettingsManager::add(gyro_smooth_beta);
+	commandRegistry->add((new JSMAssignment<float>(*gyro_smooth_beta))
+	                       ->setHelp("How quickly the ONE_EURO gyro smoothing kernel reduces smoothing as the gyro speed changes. 0 makes it a plain low pass."));
+
 	auto gyro_cutoff_speed = new JSMSetting<float>(SettingID::GYRO_CUTOFF_SPEED, 0.0f);
 	gyro_cutoff_speed->setFilter(&filterPositive);
 	SettingsManager::add(gyro_cutoff_speed);
@@ -2695,6 +3005,19 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<float>("TICK_TIME", *tick_time))
 	                       ->setHelp("Sets the time in milliseconds that JoyShockMaper waits before reading from each controller again."));
 
+	auto mouse_dpi_multiplier = new JSMVariable<float>(1.0f);
+	mouse_dpi_multiplier->setFilter(bind(&fmaxf, 0.0001f, ::placeholders::_2));
+	SettingsManager::add(SettingID::MOUSE_DPI_MULTIPLIER, mouse_dpi_multiplier);
+	commandRegistry->add((new JSMAssignment<float>(magic_enum::enum_name(SettingID::MOUSE_DPI_MULTIPLIER).data(), *mouse_dpi_multiplier))
+	                       ->setHelp("Multiplies all mouse movement sent to the system, on Windows as well as Linux. Raise it and divide the game's own sensitivity by the same amount for finer mouse steps at low sensitivity."));
+
+	auto mouse_output_rate = new JSMVariable<float>(0.f);
+	mouse_output_rate->setFilter(&filterMouseOutputRate);
+	mouse_output_rate->addOnCommitListener(&setMouseOutputRate);
+	SettingsManager::add(SettingID::MOUSE_OUTPUT_RATE, mouse_output_rate);
+	commandRegistry->add((new JSMAssignment<float>(magic_enum::enum_name(SettingID::MOUSE_OUTPUT_RATE).data(), *mouse_output_rate))
+	                       ->setHelp("Mouse updates per second, between 100 and 8000, sent from a thread of their own. Each tick's movement is spread evenly until the next tick, so games see smooth steps at any TICK_TIME. 0, the default, sends the movement on the tick."));
+
 	auto light_bar = new JSMSetting<Color>(SettingID::LIGHT_BAR, 0xFFFFFF);
 	// light_bar needs no filter or listener. The callback polls and updates the color.
 	SettingsManager::add(light_bar);
@@ -2707,16 +3030,22 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<FloatXY>(*scroll_sens))
 	                       ->setHelp("Scrolling sensitivity for sticks."));
 
+	auto hi_res_scroll = new JSMSetting<Switch>(SettingID::HI_RES_SCROLL, Switch::OFF);
+	hi_res_scroll->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
+	SettingsManager::add(hi_res_scroll);
+	commandRegistry->add((new JSMAssignment<Switch>(*hi_res_scroll))
+	                       ->setHelp("When ON, a SCROLL_WHEEL stick whose two directions are bound to nothing but SCROLLUP and SCROLLDOWN scrolls by fractions of a notch instead of pressing them. Those presses, and the chords, sim presses and console echo that go with them, are then skipped. OFF by default."));
+
 	auto autoloadSwitch = new JSMVariable<Switch>(Switch::ON);
 	autoLoadThread.reset(new JSM::AutoLoad(commandRegistry, autoloadSwitch->value() == Switch::ON)); // Start by default
-	autoloadSwitch->setFilter(&filterInvalidValue<Switch, Switch::INVALID>)->addOnChangeListener(bind(&updateThread, autoLoadThread.get(), placeholders::_1));
+	autoloadSwitch->setFilter(&filterInvalidValue<Switch, Switch::INVALID>)->addOnCommitListener(bind(&updateThread, autoLoadThread.get(), placeholders::_1));
 	SettingsManager::add(SettingID::AUTOLOAD, autoloadSwitch);
 	auto *autoloadCmd = new JSMAssignment<Switch>("AUTOLOAD", *autoloadSwitch);
 	commandRegistry->add(autoloadCmd);
 
 	auto autoConnectSwitch = new JSMVariable<Switch>(Switch::ON);
 	autoConnectThread.reset(new JSM::AutoConnect(jsl, autoConnectSwitch->value() == Switch::ON)); // Start by default
-	autoConnectSwitch->setFilter(&filterInvalidValue<Switch, Switch::INVALID>)->addOnChangeListener(bind(&updateThread, autoConnectThread.get(), placeholders::_1));
+	autoConnectSwitch->setFilter(&filterInvalidValue<Switch, Switch::INVALID>)->addOnCommitListener(bind(&updateThread, autoConnectThread.get(), placeholders::_1));
 	SettingsManager::add(SettingID::AUTOCONNECT, autoConnectSwitch);
 	commandRegistry->add((new JSMAssignment<Switch>("AUTOCONNECT", *autoConnectSwitch))->setHelp("Enable or disable device hotplugging. Valid values are ON and OFF."));
 
@@ -2726,7 +3055,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 		float floorX = floorf(next.x());
 		float floorY = floorf(next.y());
 		return floorX * floorY >= 1 && floorX * floorY <= 25 ? FloatXY{ floorX, floorY } : current; });
-	grid_size->addOnChangeListener(bind(&onNewGridDimensions, commandRegistry, placeholders::_1), true); // Call the listener now
+	grid_size->addOnChangeListener(bind(&onNewGridDimensions, commandRegistry, grid_size, placeholders::_1), true); // Call the listener now
 	SettingsManager::add(SettingID::GRID_SIZE, grid_size);
 	commandRegistry->add((new JSMAssignment<FloatXY>("GRID_SIZE", *grid_size))
 	                       ->setHelp("When TOUCHPAD_MODE is set to GRID_AND_STICK, this variable sets the number of rows and columns in the grid. The product of the two numbers need to be between 1 and 25."));
@@ -2744,7 +3073,7 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	                       ->setHelp("Sets the ring mode for the touch stick. Valid values are INNER and OUTER"));
 
 	auto touch_stick_mode = new JSMSetting<StickMode>(SettingID::TOUCH_STICK_MODE, StickMode::NO_MOUSE);
-	touch_stick_mode->setFilter(&filterInvalidValue<StickMode, StickMode::INVALID>)->addOnChangeListener(bind(&updateRingModeFromStickMode, touch_ring_mode, ::placeholders::_1));
+	touch_stick_mode->setFilter(&filterInvalidValue<StickMode, StickMode::INVALID>)->addOnCommitListener(bind(&updateRingModeFromStickMode, touch_ring_mode, touch_stick_mode, ::placeholders::_1));
 	SettingsManager::add(touch_stick_mode);
 	commandRegistry->add((new JSMAssignment<StickMode>(*touch_stick_mode))
 	                       ->setHelp("Set a mouse mode for the touchpad stick. Valid values are the following:\nNO_MOUSE, AIM, FLICK, FLICK_ONLY, ROTATE_ONLY, MOUSE_RING, MOUSE_AREA, OUTER_RING, INNER_RING"));
@@ -2778,14 +3107,14 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 			return true; 
 		}, nullptr, 1000, hide_minimized->value() == Switch::ON)); // Start by default
 	hide_minimized->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
-	hide_minimized->addOnChangeListener(bind(&updateThread, minimizeThread.get(), placeholders::_1));
+	hide_minimized->addOnCommitListener(bind(&updateThread, minimizeThread.get(), placeholders::_1));
 	SettingsManager::add(SettingID::HIDE_MINIMIZED, hide_minimized);
 	commandRegistry->add((new JSMAssignment<Switch>("HIDE_MINIMIZED", *hide_minimized))
 	                       ->setHelp("JSM will be hidden in the notification area when minimized if this setting is ON. Otherwise it stays in the taskbar."));
 
 	auto virtual_controller = new JSMVariable<ControllerScheme>(ControllerScheme::NONE);
 	virtual_controller->setFilter(&updateVirtualController);
-	virtual_controller->addOnChangeListener(&onVirtualControllerChange);
+	virtual_controller->addOnCommitListener(&onVirtualControllerChange);
 	SettingsManager::add(SettingID::VIRTUAL_CONTROLLER, virtual_controller);
 	commandRegistry->add((new JSMAssignment<ControllerScheme>(magic_enum::enum_name(SettingID::VIRTUAL_CONTROLLER).data(), *virtual_controller))
 	                       ->setHelp("Sets the vigem virtual controller type. Can be NONE (default), XBOX (360) or DS4 (PS4)."));
@@ -2803,10 +3132,16 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<Switch>(magic_enum::enum_name(SettingID::RUMBLE).data(), *rumble_enable))
 	                       ->setHelp("Disable the rumbling feature from vigem. Valid values are ON and OFF."));
 
+	auto rumble_keep_alive = new JSMVariable<float>(100.0f);
+	rumble_keep_alive->setFilter(&filterPositive);
+	SettingsManager::add(SettingID::RUMBLE_KEEP_ALIVE, rumble_keep_alive);
+	commandRegistry->add((new JSMAssignment<float>(magic_enum::enum_name(SettingID::RUMBLE_KEEP_ALIVE).data(), *rumble_keep_alive))
+	                       ->setHelp("Time in milliseconds between two rumble commands while the rumble doesn't change. Rumble changes are always sent right away, and stopped rumble is not repeated. 0 repeats ongoing rumble on every tick. Only used by the SDL build."));
+
 	auto telemetry_enabled = new JSMSetting<Switch>(SettingID::TELEMETRY_ENABLED, Switch::OFF);
 	telemetry_enabled->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
 	SettingsManager::add(SettingID::TELEMETRY_ENABLED, telemetry_enabled);
-	telemetry_enabled->addOnChangeListener([](const Switch &)
+	telemetry_enabled->addOnCommitListener([](const Switch &)
 	                                       { RefreshTelemetrySettings(); }, true);
 	commandRegistry->add((new JSMAssignment<Switch>("TELEMETRY_ENABLED", *telemetry_enabled))
 	                       ->setHelp("Enable or disable the UDP telemetry stream used by the viewer. Valid values are ON and OFF."));
@@ -2821,12 +3156,20 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 		                          }
 		                          return next;
 	                          });
-	telemetry_port->addOnChangeListener([](int)
+	telemetry_port->addOnCommitListener([](int)
 	                                    { RefreshTelemetrySettings(); });
 	SettingsManager::add(SettingID::TELEMETRY_PORT, telemetry_port);
 	commandRegistry->add((new JSMAssignment<int>("TELEMETRY_PORT", *telemetry_port))
 	                       ->setHelp("Set the UDP port that telemetry packets are sent to (default 8974). Valid range: 1024-65535."));
 
+	auto telemetry_format = new JSMSetting<TelemetryFormat>(SettingID::TELEMETRY_FORMAT, TelemetryFormat::BINARY);
+	telemetry_format->setFilter(&filterInvalidValue<TelemetryFormat, TelemetryFormat::INVALID>);
+	telemetry_format->addOnCommitListener([](TelemetryFormat)
+	                                      { RefreshTelemetrySettings(); });
+	SettingsManager::add(telemetry_format);
+	commandRegistry->add((new JSMAssignment<TelemetryFormat>(*telemetry_format))
+	                       ->setHelp("Set the encoding of telemetry packets. Valid values are BINARY (default) and JSON."));
+
 	auto adaptive_trigger = new JSMSetting<Switch>(SettingID::ADAPTIVE_TRIGGER, Switch::ON);
 	adaptive_trigger->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
 	SettingsManager::add(adaptive_trigger);
@@ -2887,6 +3230,24 @@ void initJsmSettings(CmdRegistry *commandRegistry)
 	commandRegistry->add((new JSMAssignment<Switch>("AUTO_CALIBRATE_GYRO", *auto_calibrate_gyro))
 	                       ->setHelp("Gyro calibration happens automatically when this setting is ON. Otherwise you'll need to calibrate the gyro manually when using gyro aiming."));
 
+	auto sensor_events = new JSMVariable<Switch>(Switch::OFF);
+	sensor_events->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
+	SettingsManager::add(SettingID::SENSOR_EVENTS, sensor_events);
+	commandRegistry->add((new JSMAssignment<Switch>(magic_enum::enum_name(SettingID::SENSOR_EVENTS).data(), *sensor_events))
+	                       ->setHelp("When ON, every gyro report received from the controller is processed with its own timestamp instead of only the latest one each tick. Only supported by the SDL build. Valid values are ON and OFF."));
+
+	auto per_device_polling = new JSMVariable<Switch>(Switch::OFF);
+	per_device_polling->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
+	SettingsManager::add(SettingID::PER_DEVICE_POLLING, per_device_polling);
+	commandRegistry->add((new JSMAssignment<Switch>(magic_enum::enum_name(SettingID::PER_DEVICE_POLLING).data(), *per_device_polling))
+	                       ->setHelp("When ON, each controller is processed on its own thread on a steady TICK_TIME schedule. Only affects the SDL build. Valid values are ON and OFF."));
+
+	auto realtime_polling = new JSMVariable<Switch>(Switch::OFF);
+	realtime_polling->setFilter(&filterInvalidValue<Switch, Switch::INVALID>);
+	SettingsManager::add(SettingID::REALTIME_POLLING, realtime_polling);
+	commandRegistry->add((new JSMAssignment<Switch>(magic_enum::enum_name(SettingID::REALTIME_POLLING).data(), *realtime_polling))
+	                       ->setHelp("When ON, the per device polling threads request real-time priority. Falls back to normal priority if the system refuses. Takes effect when the threads start. Valid values are ON and OFF."));
+
 	auto left_stick_undeadzone_inner = new JSMSetting<float>(SettingID::LEFT_STICK_UNDEADZONE_INNER, 0.f);
 	left_stick_undeadzone_inner->setFilter(&filterClamp01);
 	SettingsManager::add(left_stick_undeadzone_inner);
@@ -3045,8 +3406,64 @@ int main(int argc, char *argv[])
 	void *trayIconData = nullptr;
 	string module(argv[0]);
 #endif // _WIN32
-	jsl.reset(JslWrapper::getNew());
-	whitelister.reset(Whitelister::getNew(false));
+	vector<string> arguments;
+	for (int i = 0; i < argc; ++i)
+	{
+#if _WIN32
+		arguments.emplace_back(&argv[i][0], &argv[i][wcslen(argv[i])]);
+#else
+		arguments.emplace_back(argv[i]);
+#endif
+	}
+	auto render = OfflineRender::ParseArguments(arguments);
+	auto synthetic = LoadGenerator::ParseArguments(arguments);
+	InputRecording::Replay *replay = nullptr;
+	if (render)
+	{
+		if (render->configs.empty())
+		{
+			CERR << OfflineRender::USAGE;
+			return 1;
+		}
+		if (render->configs.size() > 1)
+		{
+			return OfflineRender::RunBatch(*render) == 0 ? 0 : 1;
+		}
+		string error;
+		replay = InputRecording::OpenReplay(render->recording, false, error);
+		if (!replay)
+		{
+			CERR << "Cannot replay " << render->recording << ": " << error << '\n';
+			return 1;
+		}
+		jsl = shared_ptr<JslWrapper>(replay);
+	}
+	else
+	{
+		if (!synthetic)
+		{
+#if _WIN32
+			jsl = shared_ptr<JslWrapper>(JslWrapper::getNew());
+#else
+			// Report driven rather than tick driven
+			jsl = shared_ptr<JslWrapper>(Evdev::Requested(arguments) ? Evdev::New() : JslWrapper::getNew());
+#endif
+		}
+		else if (synthetic->devices > 0)
+		{
+			jsl = shared_ptr<JslWrapper>(LoadGenerator::New(*synthetic, [](const LoadGenerator::Stats &stats)
+			  {
+				  Log(stats.overruns > 0 ? Log::Level::WARN : Log::Level::BASE)._str << stats.ticks << " ticks, " << stats.overruns << " overruns, "
+				    << stats.meanTickMs << "ms mean, " << stats.worstTickMs << "ms worst\n";
+			  }));
+		}
+		else
+		{
+			CERR << LoadGenerator::USAGE;
+			return 1;
+		}
+		whitelister.reset(Whitelister::getNew(false));
+	}
 
 	grid_mappings.reserve(int(ButtonID::T25) - FIRST_TOUCH_BUTTON); // This makes sure the items will never get copied and cause crashes
 	mappings.reserve(MAPPING_SIZE);
@@ -3057,7 +3474,10 @@ int main(int argc, char *argv[])
 		mappings.push_back(newButton);
 	}
 	// console
-	initConsole();
+	if (!render)
+	{
+		initConsole();
+	}
 	#ifndef _WIN32
 	// Set up the console to receive commands from the pipe
 	// This is only needed on non-Windows platforms
@@ -3065,7 +3485,10 @@ int main(int argc, char *argv[])
 	// and the console is set up in initConsole()
 	// The pipe is used to receive commands from the console
 	// to the main thread
-	initFifoCommandListener();
+	if (!render)
+	{
+		initFifoCommandListener();
+	}
 	#endif
 	COUT_BOLD << "Welcome to JoyShockMapper version " << version << "!\n";
 	// if (whitelister) COUT << "JoyShockMapper was successfully whitelisted!\n";
@@ -3126,7 +3549,10 @@ int main(int argc, char *argv[])
 	commandRegistry.add((new JSMMacro("IGNORE_OS_MOUSE_SPEED"))->SetMacro(bind(do_IGNORE_OS_MOUSE_SPEED))->setHelp("Disable JoyShockMapper's consideration of the the user's OS mouse sensitivity value."));
 	commandRegistry.add((new JSMMacro("CALCULATE_REAL_WORLD_CALIBRATION"))->SetMacro(bind(&do_CALCULATE_REAL_WORLD_CALIBRATION, placeholders::_2))->setHelp("Get JoyShockMapper to recommend you a REAL_WORLD_CALIBRATION value after performing the calibration sequence. Visit GyroWiki for details:\nhttp://gyrowiki.jibbsmart.com/blog:joyshockmapper-guide#calibrating"));
 	commandRegistry.add((new JSMMacro("SLEEP"))->SetMacro(bind(&do_SLEEP, placeholders::_2))->setHelp("Sleep for the given number of seconds, or one second if no number is given. Can't sleep more than 10 seconds per command."));
-	commandRegistry.add((new JSMMacro("FINISH_GYRO_CALIBRATION"))->SetMacro(bind(&do_FINISH_GYRO_CALIBRATION))->setHelp("Finish calibrating the gyro in all controllers."));
+	commandRegistry.add((new JSMMacro("RECORD"))->SetMacro(bind(&do_RECORD, placeholders::_2))->setHelp("Record everything the controllers send to the given file, for REPLAY. Enter RECORD on its own to stop recording."));
+	commandRegistry.add((new JSMMacro("REPLAY"))->SetMacro(bind(&do_REPLAY, placeholders::_2))->setHelp("Replace the controllers with a file made by RECORD. Add FAST after the file name to replay it as fast as possible instead of in real time. Enter REPLAY on its own to go back to the controllers."));
+	commandRegistry.add((new JSMMacro("FINISH_GYRO_CALIBRATION"))->SetMacro(bind(&do_FINISH_GYRO_CALIBRATION))->setHelp("Finish calibrating the gyro in all controllers, and keep the result for the next time they connect."));
+	commandRegistry.add((new JSMMacro("MOTION_REPORT_STATS"))->SetMacro(bind(&do_MOTION_REPORT_STATS))->setHelp("Show how many motion reports of each controller were lost or repeated, as told by their timestamps."));
 	commandRegistry.add((new JSMMacro("RESTART_GYRO_CALIBRATION"))->SetMacro(bind(&do_RESTART_GYRO_CALIBRATION))->setHelp("Start calibrating the gyro in all controllers."));
 	commandRegistry.add((new JSMMacro("SET_MOTION_STICK_NEUTRAL"))->SetMacro(bind(&do_SET_MOTION_STICK_NEUTRAL))->setHelp("Set the neutral orientation for motion stick to whatever the orientation of the controller is."));
 	commandRegistry.add((new JSMMacro("README"))->SetMacro(bind(&do_README))->setHelp("Open the latest JoyShockMapper README in your browser."));
@@ -3151,9 +3577,22 @@ int main(int argc, char *argv[])
 
 	Mapping::_isCommandValid = bind(&CmdRegistry::isCommandValid, &commandRegistry, placeholders::_1);
 
+	if (render)
+	{
+		int result = runRender(commandRegistry, *render, *replay);
+		cleanUp();
+		return result;
+	}
+
+	gyroCalibrations = make_unique<GyroCalibrationStore>(string(BASE_JSM_CONFIG_FOLDER()) + "GyroCalibration.txt");
+	if (!gyroCalibrations->load())
+	{
+		CERR << "Cannot read the gyro calibration from " << gyroCalibrations->path() << '\n';
+	}
 	connectDevices();
-	jsl->SetCallback(&joyShockPollCallback);
-	jsl->SetTouchCallback(&touchCallback);
+	shared_ptr<JslWrapper> backend = jsl.load();
+	backend->SetCallback(&joyShockPollCallback);
+	backend->SetTouchCallback(&touchCallback);
 	tray.reset(TrayIcon::getNew(trayIconData, &beforeShowTrayMenu));
 	if (tray)
 	{
@@ -1,10 +1,9 @@
 #include "InputHelpers.h"
+#include <atomic>
 #include <thread>
 
 #include <unordered_map>
 
-static float accumulatedX = 0;
-static float accumulatedY = 0;
 
 // Windows' mouse speed settings translate non-linearly to speed.
 // Thankfully, the mappings are available here: https://liquipedia.net/counterstrike/Mouse_settings#Windows_Sensitivity
@@ -44,6 +43,18 @@ float getMouseSpeed()
 	return 1.0;
 }
 
+static atomic<OutputSink *> outputSink = nullptr;
+
+void setOutputSink(OutputSink *sink)
+{
+	outputSink = sink;
+}
+
+OutputSink *getOutputSink()
+{
+	return outputSink;
+}
+
 // Map a VK id to mouse event id press (0) or release (1) and mouseData (2) complementary info
 unordered_map<WORD, tuple<DWORD, DWORD, DWORD>> mouseMaps = {
 	{ VK_LBUTTON, { MOUSEEVENTF_LEFTDOWN, MOUSEEVENTF_LEFTUP, 0 } },
@@ -58,6 +69,11 @@ unordered_map<WORD, tuple<DWORD, DWORD, DWORD>> mouseMaps = {
 // send mouse button
 int pressMouse(KeyCode vkKey, bool isPressed)
 {
+	if (auto sink = outputSink.load())
+	{
+		sink->key(vkKey.code, isPressed);
+		return 0;
+	}
 	// https://docs.microsoft.com/en-us/windows/win32/api/winuser/ns-winuser-mouseinput
 	auto val = mouseMaps[vkKey.code];
 
@@ -117,6 +133,11 @@ int pressKey(KeyCode vkKey, bool pressed)
 		return 0;
 	if (vkKey.code <= V_WHEEL_DOWN) // Highest mouse ID
 		return pressMouse(vkKey, pressed);
+	if (auto sink = outputSink.load())
+	{
+		sink->key(vkKey.code, pressed);
+		return 0;
+	}
 
 	INPUT input;
 	memset(&input, 0, sizeof(INPUT));
@@ -143,30 +164,51 @@ int pressKey(KeyCode vkKey, bool pressed)
 	return SendInput(1, &input, sizeof(input));
 }
 
-void moveMouse(float x, float y)
+void sendMouseMove(int x, int y)
 {
-	accumulatedX += x;
-	accumulatedY += y;
-
-	int applicableX = (int)accumulatedX;
-	int applicableY = (int)accumulatedY;
-
-	accumulatedX -= applicableX;
-	accumulatedY -= applicableY;
-	//COUT << setprecision(4) << accumulatedX << ' ' << accumulatedY << '\n';
-
 	INPUT input;
 	input.type = INPUT_MOUSE;
 	input.mi.mouseData = 0;
 	input.mi.time = 0;
-	input.mi.dx = applicableX;
-	input.mi.dy = applicableY;
+	input.mi.dx = x;
+	input.mi.dy = y;
 	input.mi.dwFlags = MOUSEEVENTF_MOVE;
 	SendInput(1, &input, sizeof(input));
 }
 
+void sendMouseScroll(int hiResX, int hiResY)
+{
+	// WHEEL_DELTA is a notch. Smaller deltas scroll smoothly in applications that read them, and the others add
+	// them up into notches themselves.
+	INPUT inputs[2] = {};
+	int count = 0;
+	if (hiResY != 0)
+	{
+		inputs[count].type = INPUT_MOUSE;
+		inputs[count].mi.mouseData = DWORD(hiResY);
+		inputs[count].mi.dwFlags = MOUSEEVENTF_WHEEL;
+		++count;
+	}
+	if (hiResX != 0)
+	{
+		inputs[count].type = INPUT_MOUSE;
+		inputs[count].mi.mouseData = DWORD(hiResX);
+		inputs[count].mi.dwFlags = MOUSEEVENTF_HWHEEL;
+		++count;
+	}
+	if (count > 0)
+	{
+		SendInput(count, inputs, sizeof(INPUT));
+	}
+}
+
 void setMouseNorm(float x, float y)
 {
+	if (auto sink = outputSink.load())
+	{
+		sink->mouseAbsolute(x, y);
+		return;
+	}
 	INPUT input;
 	input.type = INPUT_MOUSE;
 	input.mi.mouseData = 0;
@@ -177,6 +219,14 @@ void setMouseNorm(float x, float y)
 	SendInput(1, &input, sizeof(input));
 }
 
+void beginOutputFrame()
+{
+}
+
+void endOutputFrame()
+{
+}
+
 BOOL WriteToConsole(string_view command)
 {
 	static const INPUT_RECORD ESC_DOWN = { KEY_EVENT, { TRUE, 1, VK_ESCAPE, WORD(MapVirtualKey(VK_ESCAPE, MAPVK_VK_TO_VSC)), VK_ESCAPE, 0 } };
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ChordTable.h"
+
+// Models under test:
+//
+//   ChordTable<Key, Value, KeyCount>.emplace(key, args...) / find(key) / erase(key) / clear()
+//     -> the value of each key, constructed once and kept at the same address until it is erased
+//   ChordTable.entries()
+//     -> the entries in key order, whatever order they were emplaced in
+
+
+enum class Button {
+    INVALID = -2,
+    NONE,
+    A,
+    B,
+    C,
+};
+
+// Only A, B and C use the bitmap
+using Table = ChordTable<Button, std::string, 3>;
+
+
+TEST_CASE("An empty table finds nothing") {
+    Table table;
+
+    REQUIRE(table.empty());
+    REQUIRE(table.find(Button::A) == nullptr);
+    REQUIRE(table.entry(Button::NONE) == nullptr);
+}
+
+TEST_CASE("Emplaced values are found by their key") {
+    Table table;
+    table.emplace(Button::A, "a");
+    table.emplace(Button::C, 3, 'c');
+
+    REQUIRE(table.size() == 2);
+    REQUIRE(*table.find(Button::A) == "a");
+    REQUIRE(*table.find(Button::C) == "ccc");
+    REQUIRE(table.find(Button::B) == nullptr);
+    REQUIRE(table.entry(Button::C)->first == Button::C);
+}
+
+TEST_CASE("Emplacing a key that is there keeps its value") {
+    Table table;
+    auto &value = table.emplace(Button::B, "first");
+    auto &again = table.emplace(Button::B, "second");
+
+    REQUIRE(&value == &again);
+    REQUIRE(again == "first");
+    REQUIRE(table.size() == 1);
+}
+
+TEST_CASE("Values keep their address as the table grows") {
+    Table table;
+    auto *value = &table.emplace(Button::A, "a");
+    table.emplace(Button::B, "b");
+    table.emplace(Button::C, "c");
+    table.emplace(Button::NONE, "none");
+    table.erase(Button::B);
+
+    REQUIRE(table.find(Button::A) == value);
+}
+
+TEST_CASE("Erased values aren't found anymore") {
+    Table table;
+    table.emplace(Button::A, "a");
+    table.emplace(Button::B, "b");
+
+    REQUIRE(table.erase(Button::A));
+    REQUIRE_FALSE(table.erase(Button::A));
+    REQUIRE(table.find(Button::A) == nullptr);
+    REQUIRE(*table.find(Button::B) == "b");
+
+    table.emplace(Button::A, "again");
+    REQUIRE(*table.find(Button::A) == "again");
+}
+
+TEST_CASE("Keys outside of the bitmap are found too") {
+    Table table;
+    table.emplace(Button::INVALID, "invalid");
+    table.emplace(Button::NONE, "none");
+
+    REQUIRE(*table.find(Button::INVALID) == "invalid");
+    REQUIRE(*table.find(Button::NONE) == "none");
+    REQUIRE(table.find(Button::A) == nullptr);
+
+    REQUIRE(table.erase(Button::NONE));
+    REQUIRE(table.find(Button::NONE) == nullptr);
+    REQUIRE(*table.find(Button::INVALID) == "invalid");
+}
+
+TEST_CASE("A cleared table finds nothing") {
+    Table table;
+    table.emplace(Button::A, "a");
+    table.emplace(Button::NONE, "none");
+    table.clear();
+
+    REQUIRE(table.empty());
+    REQUIRE(table.find(Button::A) == nullptr);
+    REQUIRE(table.find(Button::NONE) == nullptr);
+}
+
+TEST_CASE("Entries are kept in key order") {
+    Table table;
+    table.emplace(Button::C, "c");
+    table.emplace(Button::A, "a");
+    table.emplace(Button::INVALID, "invalid");
+    table.emplace(Button::B, "b");
+    table.erase(Button::A);
+    table.emplace(Button::NONE, "none");
+
+    std::vector<Button> keys;
+    for (auto &entry : table.entries()) {
+        keys.push_back(entry.first);
+    }
+    REQUIRE(keys == std::vector<Button>{ Button::INVALID, Button::NONE, Button::B, Button::C });
+}
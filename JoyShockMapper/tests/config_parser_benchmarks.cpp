@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include <vector>
+#include "ConfigParser.h"
+
+// Cost of splitting a large profile, line by line, the way CmdRegistry::loadConfigFile does:
+//
+//   parseLine            every line
+//   parseAssignment      the arguments of every line that has them
+//   nextMappingToken     every key of every mapping value
+//
+// Tokenizer against the former regular expressions. Run `jsm_benchmarks [benchmark]` for timings.
+
+
+// A profile with every kind of line: settings, mappings with modifiers, chords, sim and diagonal presses, comments
+static std::vector<std::string> largeProfile(size_t lines) {
+    static const std::vector<std::string> kinds = {
+        "GYRO_SENS = 2.5 2.5",
+        "LEFT_STICK_MODE = AIM # aim with the left stick",
+        "R = RMOUSE",
+        "ZR = LMOUSE\\ LMOUSE/",
+        "ZL,GYRO_SENS = 1",
+        "E+S = ^SPACE",
+        "N*W = !\"SLEEP 0.5\"\\ R'",
+        "# A comment line about the next block",
+        "UP = 1 2_",
+        "TOUCH_STICK_AXIS = STANDARD INVERTED",
+        "LIGHT_BAR = 255 0 128",
+        "",
+    };
+    std::vector<std::string> profile;
+    profile.reserve(lines);
+    for (size_t i = 0; i < lines; ++i) {
+        profile.push_back(kinds[i % kinds.size()]);
+    }
+    return profile;
+}
+
+template<typename Parse, typename Assign, typename Next>
+static size_t splitProfile(const std::vector<std::string> &profile, Parse parse, Assign assign, Next next) {
+    size_t parts = 0;
+    for (const auto &text : profile) {
+        ConfigParser::Line line;
+        parse(text, ",+*", line);
+        std::string_view value;
+        if (assign(line.arguments, value)) {
+            ConfigParser::MappingToken token;
+            for (std::string_view rest = value; next(rest, token); rest = token.rest) {
+                ++parts;
+            }
+        }
+        ++parts;
+    }
+    return parts;
+}
+
+
+TEST_CASE("Profile load cost", "[.][benchmark]") {
+    auto profile = largeProfile(2000);
+
+    BENCHMARK("2000 lines, tokenizer") {
+        return splitProfile(profile, ConfigParser::Tokenizer::parseLine, ConfigParser::Tokenizer::parseAssignment, ConfigParser::Tokenizer::nextMappingToken);
+    };
+
+    BENCHMARK("2000 lines, regular expressions") {
+        return splitProfile(profile, ConfigParser::Regex::parseLine, ConfigParser::Regex::parseAssignment, ConfigParser::Regex::nextMappingToken);
+    };
+}
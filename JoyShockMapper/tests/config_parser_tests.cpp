@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ConfigParser.h"
+
+using namespace ConfigParser;
+
+// Models under test:
+//
+//   parseLine("  [combo op] name arguments [# label]", ops)
+//     -> the parts, where combo and name are [+-]?\w* and op is one of ops
+//   parseAssignment(" = value") -> value
+//   nextMappingToken("[!^-]key[\/+'_] rest")
+//     -> key is a "quoted string", the longest word that ends with a capital or a digit, or one other character
+//   isCommandName(name) -> + - or a word
+//
+// The Tokenizer and the Regex versions give the same parts for the same text.
+
+
+static const std::vector<std::string> kLines = {
+    "",
+    "   ",
+    "GYRO_SENS = 2.5",
+    "GYRO_SENS=2.5",
+    "  LEFT_STICK_MODE = AIM   # aim with the left stick",
+    "R,GYRO_SENS = 1",
+    "ZL , ZR = A",
+    "R+S = LMOUSE",
+    "E*W = SPACE",
+    "+ = F1",
+    "- = F2",
+    "+,- = F3",
+    "-,+ = F4",
+    "A = ^B C_ # toggle B, hold C",
+    "RESET_MAPPINGS",
+    "RECONNECT_CONTROLLERS MERGE",
+    "# just a comment",
+    "#",
+    "W = \"AUTOLOAD ON\" # quoted",
+    "TOUCH_STICK_AXIS = STANDARD INVERTED",
+    "LIGHT_BAR = 255 0 128",
+    "UP,DOWN,LEFT = A",
+    "N = !\"SLEEP 1\"\\ B",
+    "$$$ = A",
+    "GRID_SIZE = 3 3 #",
+    "S + = B",
+    "A=  ",
+    "ZL,RIGHT_STICK_MODE = FLICK # modeshift",
+    "T1*T2 = ESC",
+    "lower_case = x",
+};
+
+static const std::vector<std::string> kOps = { ",+*", ",+" };
+
+static const std::vector<std::string> kAssignments = {
+    "= 1", "  =  2.5  ", "=", "= DEFAULT", "1", " 1 = 2", "=\"SLEEP 1\"", "",
+};
+
+static const std::vector<std::string> kMappings = {
+    "A", "A B", "!A", "^B", "-C", "-", "--", "A\\", "B/", "C+", "D'", "E_", "F1", "LMOUSE RMOUSE", "GYRO_OFF",
+    "\"SLEEP 1\"", "!\"SLEEP 1\"\\ \"SLEEP 2\"/", "\"unclosed", "abc", "Ab", "A_b", "  A", " ", "NONE", "x1y",
+    "SPACE' LSHIFT_", "^", "!!", "=", "CALIBRATE/ RECENTER",
+};
+
+static bool same(const Line &a, const Line &b) {
+    return a.combo == b.combo && a.op == b.op && a.name == b.name && a.arguments == b.arguments && a.label == b.label;
+}
+
+static bool same(const MappingToken &a, const MappingToken &b) {
+    return a.action == b.action && a.key == b.key && a.event == b.event && a.rest == b.rest;
+}
+
+
+TEST_CASE("A line splits into its parts") {
+    Line line;
+    REQUIRE(Tokenizer::parseLine("  LEFT_STICK_MODE = AIM   # aim with the left stick", ",+*", line));
+    REQUIRE(line.combo.empty());
+    REQUIRE(line.op == '\0');
+    REQUIRE(line.name == "LEFT_STICK_MODE");
+    REQUIRE(line.arguments == "= AIM   ");
+    REQUIRE(line.label == "aim with the left stick");
+
+    REQUIRE(Tokenizer::parseLine("ZL , ZR = A", ",+*", line));
+    REQUIRE(line.combo == "ZL");
+    REQUIRE(line.op == ',');
+    REQUIRE(line.name == "ZR");
+    REQUIRE(line.arguments == "= A");
+
+    REQUIRE(Tokenizer::parseLine("+,- = F3", ",+*", line));
+    REQUIRE(line.combo == "+");
+    REQUIRE(line.name == "-");
+}
+
+TEST_CASE("Only the given ops join a combo") {
+    Line line;
+    REQUIRE(Tokenizer::parseLine("E*W = SPACE", ",+", line));
+    REQUIRE(line.combo.empty());
+    REQUIRE(line.name == "E");
+    REQUIRE(line.arguments == "*W = SPACE");
+}
+
+TEST_CASE("A mapping value splits into keys and modifiers") {
+    MappingToken token;
+    REQUIRE(Tokenizer::nextMappingToken("!\"SLEEP 1\"\\ B", token));
+    REQUIRE(token.action == '!');
+    REQUIRE(token.key == "\"SLEEP 1\"");
+    REQUIRE(token.event == '\\');
+    REQUIRE(token.rest == "B");
+
+    REQUIRE(Tokenizer::nextMappingToken("A_b", token));
+    REQUIRE(token.key == "A");
+    REQUIRE(token.event == '_');
+    REQUIRE(token.rest == "b");
+
+    // A lone - is the key, not the release modifier
+    REQUIRE(Tokenizer::nextMappingToken("-", token));
+    REQUIRE(token.action == '\0');
+    REQUIRE(token.key == "-");
+
+    REQUIRE_FALSE(Tokenizer::nextMappingToken("abc", token));
+    REQUIRE_FALSE(Tokenizer::nextMappingToken("", token));
+}
+
+TEST_CASE("The tokenizer splits lines like the regular expression") {
+    for (const auto &ops : kOps) {
+        for (const auto &text : kLines) {
+            Line tokenized, matched;
+            bool tokenizedOk = Tokenizer::parseLine(text, ops, tokenized);
+            bool matchedOk = Regex::parseLine(text, ops, matched);
+            CAPTURE(text, ops);
+            REQUIRE(tokenizedOk == matchedOk);
+            REQUIRE(same(tokenized, matched));
+        }
+    }
+}
+
+TEST_CASE("The tokenizer splits assignments like the regular expression") {
+    for (const auto &text : kAssignments) {
+        std::string_view tokenized = "unset", matched = "unset";
+        CAPTURE(text);
+        REQUIRE(Tokenizer::parseAssignment(text, tokenized) == Regex::parseAssignment(text, matched));
+        REQUIRE(tokenized == matched);
+    }
+}
+
+TEST_CASE("The tokenizer splits mapping values like the regular expression") {
+    for (const auto &text : kMappings) {
+        // Every token of the value, like Mapping's operator>> reads them
+        std::string_view tokenizedRest = text, matchedRest = text;
+        for (int count = 0; count < 10; ++count) {
+            MappingToken tokenized, matched;
+            bool tokenizedOk = Tokenizer::nextMappingToken(tokenizedRest, tokenized);
+            bool matchedOk = Regex::nextMappingToken(matchedRest, matched);
+            CAPTURE(text, count);
+            REQUIRE(tokenizedOk == matchedOk);
+            if (!tokenizedOk) {
+                break;
+            }
+            REQUIRE(same(tokenized, matched));
+            tokenizedRest = tokenized.rest;
+            matchedRest = matched.rest;
+        }
+    }
+}
+
+TEST_CASE("Command names are +, - or words") {
+    for (std::string_view name : { "+", "-", "A", "GYRO_SENS", "T25", "", "+A", "A B", "A,B", "*" }) {
+        CAPTURE(name);
+        REQUIRE(Tokenizer::isCommandName(name) == Regex::isCommandName(name));
+    }
+    REQUIRE(Tokenizer::isCommandName("GYRO_SENS"));
+    REQUIRE_FALSE(Tokenizer::isCommandName("A,B"));
+}
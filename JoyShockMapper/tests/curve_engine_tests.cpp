@@ -0,0 +1,190 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "CurveEngine.h"
+#include "NaturalCurve.h"
+#include "PowerCurve.h"
+#include "QuadraticCurve.h"
+#include "SigmoidCurve.h"
+#include "JumpCurve.h"
+
+using Catch::Approx;
+
+// Model under test:
+//
+//   CurveEngine::configure(params, useTable)
+//   CurveEngine::evaluate(omegaAdjusted, sMinX, sMaxX, sMinY, sMaxY, sensX, sensY)
+//
+// Must match the per-axis curve functions, as called by joyShockPollCallback:
+//   NATURAL   -> NaturalSensitivity(omegaAdjusted, sMin, sMax, naturalVHalf)
+//   POWER     -> PowerSensitivity(omegaAdjusted, sMin, sMax, powerVRef, powerExponent)
+//   QUADRATIC -> QuadraticSensitivity(omegaAdjusted, sMin, sMax, maxThreshold)
+//   SIGMOID   -> SigmoidSensitivity(omegaAdjusted, sMin, sMax, sigmoidMid, sigmoidWidth)
+//   JUMP      -> JumpSensitivity(omegaAdjusted, sMin, sMax, maxThreshold, jumpTau)
+//   LINEAR    -> lerp(sMin, sMax, clamp(omegaAdjusted / (maxThreshold - minThreshold), 0, 1))
+//
+// Exactly (within float rounding) without the table, within a small tolerance with it.
+
+
+static CurveParams makeParams(CurveShape shape) {
+    CurveParams params;
+    params.shape = shape;
+    params.minThreshold = 5.0f;
+    params.maxThreshold = 75.0f;
+    params.naturalVHalf = 30.0f;
+    params.powerVRef = 40.0f;
+    params.powerExponent = 1.5f;
+    params.sigmoidMid = 40.0f;
+    params.sigmoidWidth = 10.0f;
+    params.jumpTau = 12.0f;
+    return params;
+}
+
+static float reference(const CurveParams &p, float omegaAdjusted, float sMin, float sMax) {
+    switch (p.shape) {
+    case CurveShape::NATURAL:
+        return NaturalSensitivity(omegaAdjusted, sMin, sMax, p.naturalVHalf);
+    case CurveShape::POWER:
+        return PowerSensitivity(omegaAdjusted, sMin, sMax, p.powerVRef, p.powerExponent);
+    case CurveShape::QUADRATIC:
+        return QuadraticSensitivity(omegaAdjusted, sMin, sMax, p.maxThreshold);
+    case CurveShape::SIGMOID:
+        return SigmoidSensitivity(omegaAdjusted, sMin, sMax, p.sigmoidMid, p.sigmoidWidth);
+    case CurveShape::JUMP:
+        return JumpSensitivity(omegaAdjusted, sMin, sMax, p.maxThreshold, p.jumpTau);
+    default: {
+        const float denom = p.maxThreshold - p.minThreshold;
+        const float t = denom > 0.0f ? std::clamp(omegaAdjusted / denom, 0.0f, 1.0f) : (omegaAdjusted > 0.0f ? 1.0f : 0.0f);
+        return sMin * (1.0f - t) + sMax * t;
+    }
+    }
+}
+
+static void requireMatches(const CurveParams &params, bool useTable, float margin) {
+    CurveEngine engine;
+    engine.configure(params, useTable);
+    for (float omega = 0.0f; omega < 500.0f; omega += 0.37f) {
+        float sensX, sensY;
+        engine.evaluate(omega, 0.5f, 3.0f, 1.0f, 2.0f, sensX, sensY);
+        REQUIRE(sensX == Approx(reference(params, omega, 0.5f, 3.0f)).margin(margin));
+        REQUIRE(sensY == Approx(reference(params, omega, 1.0f, 2.0f)).margin(margin));
+    }
+}
+
+static const CurveShape allShapes[] = {
+    CurveShape::LINEAR, CurveShape::NATURAL, CurveShape::POWER,
+    CurveShape::QUADRATIC, CurveShape::SIGMOID, CurveShape::JUMP,
+};
+
+
+// ---------------------------------------------------------
+// 1. Agreement with the curve functions
+// ---------------------------------------------------------
+
+TEST_CASE("CurveEngine matches the curve functions") {
+    for (auto shape : allShapes) {
+        requireMatches(makeParams(shape), false, 1e-5f);
+    }
+}
+
+TEST_CASE("CurveEngine table stays close to the curve functions") {
+    for (auto shape : allShapes) {
+        requireMatches(makeParams(shape), true, 1e-3f);
+    }
+}
+
+TEST_CASE("CurveEngine matches the curve functions on degenerate parameters") {
+    auto natural = makeParams(CurveShape::NATURAL);
+    natural.naturalVHalf = 0.0f;
+    requireMatches(natural, true, 1e-5f);
+
+    auto power = makeParams(CurveShape::POWER);
+    power.powerExponent = 0.0f;
+    requireMatches(power, true, 1e-5f);
+    power = makeParams(CurveShape::POWER);
+    power.powerVRef = -1.0f;
+    requireMatches(power, true, 1e-5f);
+    power = makeParams(CurveShape::POWER);
+    power.powerExponent = 0.5f; // Too steep at 0 for the table, which must fall back to the exact curve
+    requireMatches(power, true, 1e-5f);
+
+    auto sigmoid = makeParams(CurveShape::SIGMOID);
+    sigmoid.sigmoidWidth = 0.0f;
+    requireMatches(sigmoid, false, 1e-5f);
+
+    auto jump = makeParams(CurveShape::JUMP);
+    jump.jumpTau = 0.0f;
+    requireMatches(jump, true, 1e-5f);
+
+    auto linear = makeParams(CurveShape::LINEAR);
+    linear.maxThreshold = linear.minThreshold;
+    requireMatches(linear, false, 1e-5f);
+}
+
+
+// ---------------------------------------------------------
+// 2. Reconfiguration
+// ---------------------------------------------------------
+
+TEST_CASE("CurveEngine picks up parameter changes") {
+    CurveEngine engine;
+    auto params = makeParams(CurveShape::NATURAL);
+    engine.configure(params, true);
+    float before = engine.shape(30.0f);
+
+    params.naturalVHalf = 60.0f;
+    engine.configure(params, true);
+    REQUIRE(engine.shape(30.0f) < before);
+    REQUIRE(engine.shape(60.0f) == Approx(0.5f).margin(1e-3f));
+}
+
+
+// ---------------------------------------------------------
+// 3. Benchmarks (hidden: run with `jsm_tests [benchmark]`)
+// ---------------------------------------------------------
+
+TEST_CASE("Curve evaluation cost", "[.][benchmark]") {
+    std::vector<float> omegas;
+    for (int i = 0; i < 1024; ++i) {
+        omegas.push_back(float(i % 400) * 0.5f);
+    }
+
+    for (auto shape : { CurveShape::NATURAL, CurveShape::POWER, CurveShape::SIGMOID, CurveShape::JUMP }) {
+        auto params = makeParams(shape);
+        CurveEngine exact;
+        exact.configure(params, false);
+        CurveEngine table;
+        table.configure(params, true);
+
+        BENCHMARK("curve functions, X and Y, shape " + std::to_string(int(shape))) {
+            float sum = 0.0f;
+            for (float omega : omegas) {
+                sum += reference(params, omega, 0.5f, 3.0f) + reference(params, omega, 1.0f, 2.0f);
+            }
+            return sum;
+        };
+
+        BENCHMARK("engine, shape " + std::to_string(int(shape))) {
+            float sum = 0.0f;
+            for (float omega : omegas) {
+                float sensX, sensY;
+                exact.evaluate(omega, 0.5f, 3.0f, 1.0f, 2.0f, sensX, sensY);
+                sum += sensX + sensY;
+            }
+            return sum;
+        };
+
+        BENCHMARK("engine with table, shape " + std::to_string(int(shape))) {
+            float sum = 0.0f;
+            for (float omega : omegas) {
+                float sensX, sensY;
+                table.evaluate(omega, 0.5f, 3.0f, 1.0f, 2.0f, sensX, sensY);
+                sum += sensX + sensY;
+            }
+            return sum;
+        };
+    }
+}
@@ -0,0 +1,328 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "linux/EvdevWrapper.h"
+
+// Models under test:
+//
+//   Evdev::Decoder(controller type).feed(node role, event)
+//     -> the DeviceFrame of the controller, and one timed IMU report per SYN_REPORT of its motion node
+//
+//   Evdev::New()
+//     -> a JslWrapper that finds the controllers in /dev/input and runs the callbacks when a report ends.
+//        Tested with uinput devices, and skipped when /dev/uinput can't be opened.
+
+
+static input_event event(uint16_t type, uint16_t code, int32_t value, uint64_t us = 0) {
+    input_event ev{};
+    ev.input_event_sec = us / 1000000;
+    ev.input_event_usec = us % 1000000;
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    return ev;
+}
+
+static input_absinfo range(int min, int max, int resolution = 0) {
+    input_absinfo info{};
+    info.minimum = min;
+    info.maximum = max;
+    info.resolution = resolution;
+    return info;
+}
+
+static bool report(Evdev::Decoder &decoder, Evdev::NodeRole role, uint64_t us) {
+    return decoder.feed(role, event(EV_SYN, SYN_REPORT, 0, us));
+}
+
+
+// ---------------------------------------------------------
+// 1. Devices
+// ---------------------------------------------------------
+
+TEST_CASE("Only controllers with a kernel driver are supported") {
+    REQUIRE(Evdev::ControllerType(0x054C, 0x09CC) == JS_TYPE_DS4);
+    REQUIRE(Evdev::ControllerType(0x054C, 0x0CE6) == JS_TYPE_DS);
+    REQUIRE(Evdev::ControllerType(0x057E, 0x2006) == JS_TYPE_JOYCON_LEFT);
+    REQUIRE(Evdev::ControllerType(0x057E, 0x2009) == JS_TYPE_PRO_CONTROLLER);
+    REQUIRE(Evdev::ControllerType(0x045E, 0x02EA) == 0);
+}
+
+TEST_CASE("The backend is only used on request") {
+    REQUIRE_FALSE(Evdev::Requested({ "JoyShockMapper", "config.txt" }));
+    REQUIRE(Evdev::Requested({ "JoyShockMapper", "--evdev", "config.txt" }));
+}
+
+
+// ---------------------------------------------------------
+// 2. Gamepad node
+// ---------------------------------------------------------
+
+TEST_CASE("Buttons, sticks and triggers are normalized") {
+    Evdev::Decoder decoder(JS_TYPE_DS);
+    for (int axis : { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ }) {
+        decoder.setRange(Evdev::NodeRole::GAMEPAD, axis, range(0, 255));
+    }
+    auto pad = Evdev::NodeRole::GAMEPAD;
+    REQUIRE_FALSE(decoder.feed(pad, event(EV_KEY, BTN_SOUTH, 1)));
+    decoder.feed(pad, event(EV_KEY, BTN_TR, 1));
+    decoder.feed(pad, event(EV_ABS, ABS_X, 255));
+    decoder.feed(pad, event(EV_ABS, ABS_Y, 0));
+    decoder.feed(pad, event(EV_ABS, ABS_RZ, 255));
+    decoder.feed(pad, event(EV_ABS, ABS_HAT0X, -1));
+    REQUIRE(report(decoder, pad, 1000));
+
+    const auto &frame = decoder.frame();
+    REQUIRE(frame.buttons == (JSMASK_S | JSMASK_R | JSMASK_LEFT));
+    REQUIRE(frame.leftX == Catch::Approx(1.f));
+    REQUIRE(frame.leftY == Catch::Approx(1.f)); // Up
+    REQUIRE(frame.rightTrigger == Catch::Approx(1.f));
+    REQUIRE(frame.leftTrigger == Catch::Approx(0.f));
+
+    decoder.feed(pad, event(EV_ABS, ABS_HAT0X, 0));
+    decoder.feed(pad, event(EV_KEY, BTN_SOUTH, 0));
+    report(decoder, pad, 2000);
+    REQUIRE(decoder.frame().buttons == JSMASK_R);
+}
+
+TEST_CASE("SL and SR of a single Joy-Con are the shoulder buttons of the other side") {
+    Evdev::Decoder decoder(JS_TYPE_JOYCON_LEFT);
+    auto pad = Evdev::NodeRole::GAMEPAD;
+    decoder.feed(pad, event(EV_KEY, BTN_TR, 1));
+    decoder.feed(pad, event(EV_KEY, BTN_TR2, 1));
+    decoder.feed(pad, event(EV_KEY, BTN_TL2, 1));
+    report(decoder, pad, 1000);
+    REQUIRE(decoder.frame().buttons == (JSMASK_SL | JSMASK_SR));
+    REQUIRE(decoder.frame().leftTrigger == 1.f); // No analog triggers
+}
+
+TEST_CASE("Events after a SYN_DROPPED are ignored until the node is read again") {
+    Evdev::Decoder decoder(JS_TYPE_DS4);
+    auto pad = Evdev::NodeRole::GAMEPAD;
+    decoder.feed(pad, event(EV_SYN, SYN_DROPPED, 0));
+    decoder.feed(pad, event(EV_KEY, BTN_SOUTH, 1));
+    REQUIRE_FALSE(report(decoder, pad, 1000));
+    REQUIRE(decoder.frame().buttons == 0);
+    REQUIRE(decoder.needsResync(pad));
+    REQUIRE(decoder.droppedReports() == 1);
+
+    decoder.resynced(pad);
+    REQUIRE_FALSE(decoder.needsResync(pad));
+    decoder.feed(pad, event(EV_KEY, BTN_SOUTH, 1));
+    REQUIRE(report(decoder, pad, 2000));
+    REQUIRE(decoder.frame().buttons == JSMASK_S);
+}
+
+
+// ---------------------------------------------------------
+// 3. Motion and touchpad nodes
+// ---------------------------------------------------------
+
+TEST_CASE("Motion is scaled by the axis resolution") {
+    Evdev::Decoder decoder(JS_TYPE_DS);
+    auto motion = Evdev::NodeRole::MOTION;
+    decoder.setRange(motion, ABS_Y, range(-32768, 32767, 8192));
+    decoder.setRange(motion, ABS_RX, range(-2097152, 2097152, 1024));
+    decoder.feed(motion, event(EV_ABS, ABS_Y, 8192));
+    decoder.feed(motion, event(EV_ABS, ABS_RX, -4096));
+    REQUIRE(report(decoder, motion, 1000));
+    REQUIRE(decoder.frame().imu.accelY == Catch::Approx(1.f));
+    REQUIRE(decoder.frame().imu.gyroX == Catch::Approx(-4.f));
+}
+
+TEST_CASE("Time steps come from the sensor clock when there is one") {
+    Evdev::Decoder decoder(JS_TYPE_DS);
+    auto motion = Evdev::NodeRole::MOTION;
+    // Kernel times 4ms apart, sensor times 1ms apart and wrapping around
+    decoder.feed(motion, event(EV_MSC, MSC_TIMESTAMP, int32_t(0xFFFFFE0C)));
+    report(decoder, motion, 10000);
+    decoder.feed(motion, event(EV_MSC, MSC_TIMESTAMP, 1000 - 500));
+    report(decoder, motion, 14000);
+    // Without a sensor time, the kernel time is used
+    report(decoder, motion, 18000);
+
+    TimedImuState reports[Evdev::Decoder::kMaxReports];
+    REQUIRE(decoder.takeReports(reports, Evdev::Decoder::kMaxReports) == 3);
+    REQUIRE(reports[0].deltaTime == 0.f);
+    REQUIRE(reports[1].deltaTime == Catch::Approx(0.001f));
+    REQUIRE(reports[2].deltaTime == Catch::Approx(0.004f));
+    REQUIRE(decoder.frame().timestamp == 18000000);
+    REQUIRE(decoder.takeReports(reports, Evdev::Decoder::kMaxReports) == 0);
+}
+
+TEST_CASE("Motion reports with the same sensor time are only taken once") {
+    Evdev::Decoder decoder(JS_TYPE_DS);
+    auto motion = Evdev::NodeRole::MOTION;
+    for (int32_t sensorTime : { 1000, 2000, 2000, 5000 }) {
+        decoder.feed(motion, event(EV_MSC, MSC_TIMESTAMP, sensorTime));
+        report(decoder, motion, 10000 + sensorTime);
+    }
+    TimedImuState reports[Evdev::Decoder::kMaxReports];
+    REQUIRE(decoder.takeReports(reports, Evdev::Decoder::kMaxReports) == 3);
+    REQUIRE(reports[2].deltaTime == Catch::Approx(0.003f));
+    REQUIRE(decoder.reportStats().duplicated == 1);
+    REQUIRE(decoder.reportStats().dropped == 2);
+}
+
+TEST_CASE("Reports nobody takes are merged into the latest one") {
+    Evdev::Decoder decoder(JS_TYPE_DS4);
+    auto motion = Evdev::NodeRole::MOTION;
+    for (size_t i = 0; i <= Evdev::Decoder::kMaxReports + 4; ++i) {
+        report(decoder, motion, 1000 * (i + 1));
+    }
+    TimedImuState reports[Evdev::Decoder::kMaxReports];
+    REQUIRE(decoder.takeReports(reports, Evdev::Decoder::kMaxReports) == int(Evdev::Decoder::kMaxReports));
+    float total = 0.f;
+    for (auto &timed : reports) {
+        total += timed.deltaTime;
+    }
+    REQUIRE(total == Catch::Approx(0.001f * (Evdev::Decoder::kMaxReports + 4)));
+}
+
+TEST_CASE("The first two touch slots are the two touches") {
+    Evdev::Decoder decoder(JS_TYPE_DS4);
+    auto touchpad = Evdev::NodeRole::TOUCHPAD;
+    decoder.setRange(touchpad, ABS_MT_POSITION_X, range(0, 1919));
+    decoder.setRange(touchpad, ABS_MT_POSITION_Y, range(0, 941));
+    decoder.feed(touchpad, event(EV_ABS, ABS_MT_SLOT, 1));
+    decoder.feed(touchpad, event(EV_ABS, ABS_MT_TRACKING_ID, 7));
+    decoder.feed(touchpad, event(EV_ABS, ABS_MT_POSITION_X, 1919));
+    decoder.feed(touchpad, event(EV_ABS, ABS_MT_POSITION_Y, 0));
+    decoder.feed(touchpad, event(EV_KEY, BTN_LEFT, 1));
+    report(decoder, touchpad, 1000);
+
+    const auto &touch = decoder.frame().touch;
+    REQUIRE_FALSE(touch.t0Down);
+    REQUIRE(touch.t1Down);
+    REQUIRE(touch.t1Id == 7);
+    REQUIRE(touch.t1X == Catch::Approx(1.f));
+    REQUIRE(touch.t1Y == Catch::Approx(0.f));
+    REQUIRE(decoder.frame().buttons == JSMASK_TOUCHPAD_CLICK);
+}
+
+
+// ---------------------------------------------------------
+// 4. uinput devices
+// ---------------------------------------------------------
+
+// A fake DualSense made of a gamepad node and a motion node, like hid-playstation makes
+class FakeDualSense {
+public:
+    FakeDualSense() {
+        _pad = create("Fake DualSense", false);
+        _motion = _pad >= 0 ? create("Fake DualSense Motion Sensors", true) : -1;
+    }
+
+    ~FakeDualSense() {
+        for (int fd : { _pad, _motion }) {
+            if (fd >= 0) {
+                ioctl(fd, UI_DEV_DESTROY);
+                close(fd);
+            }
+        }
+    }
+
+    bool ok() const {
+        return _pad >= 0 && _motion >= 0;
+    }
+
+    void emit(bool motion, uint16_t type, uint16_t code, int32_t value) {
+        input_event ev = event(type, code, value);
+        write(motion ? _motion : _pad, &ev, sizeof(ev));
+    }
+
+private:
+    static int create(const char *name, bool motion) {
+        int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+        if (fd < 0) {
+            return -1;
+        }
+        ioctl(fd, UI_SET_EVBIT, EV_ABS);
+        if (motion) {
+            ioctl(fd, UI_SET_EVBIT, EV_MSC);
+            ioctl(fd, UI_SET_MSCBIT, MSC_TIMESTAMP);
+            ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_ACCELEROMETER);
+        } else {
+            ioctl(fd, UI_SET_EVBIT, EV_KEY);
+            ioctl(fd, UI_SET_KEYBIT, BTN_SOUTH);
+        }
+        for (int axis : { ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ }) {
+            uinput_abs_setup setup{};
+            setup.code = axis;
+            setup.absinfo = motion ? range(-32768, 32767, axis < ABS_RX ? 8192 : 1024) : range(0, 255);
+            ioctl(fd, UI_SET_ABSBIT, axis);
+            ioctl(fd, UI_ABS_SETUP, &setup);
+        }
+        uinput_setup setup{};
+        setup.id.bustype = BUS_USB;
+        setup.id.vendor = 0x054C;
+        setup.id.product = 0x0CE6;
+        std::strncpy(setup.name, name, UINPUT_MAX_NAME_SIZE - 1);
+        if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int _pad = -1;
+    int _motion = -1;
+};
+
+static JslWrapper *polling = nullptr;
+static std::atomic<int> lastButtons = 0;
+static std::atomic<float> lastGyroX = 0.f;
+static std::atomic<float> lastDeltaTime = 0.f;
+
+static void pollCallback(int handle, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float deltaTime) {
+    DeviceFrame frame;
+    if (polling->GetDeviceFrame(handle, frame)) {
+        lastButtons = frame.buttons;
+        lastGyroX = frame.imu.gyroX;
+        lastDeltaTime = deltaTime;
+    }
+}
+
+template<typename Condition>
+static bool waitFor(Condition condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!condition() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return condition();
+}
+
+TEST_CASE("Reports of uinput controllers run the callbacks") {
+    FakeDualSense fake;
+    if (!fake.ok()) {
+        SKIP("/dev/uinput is not available");
+    }
+    std::unique_ptr<JslWrapper> evdev(Evdev::New());
+    polling = evdev.get();
+    // udev makes the nodes shortly after the devices
+    REQUIRE(waitFor([&evdev] { return evdev->ConnectDevices() > 0; }));
+    REQUIRE(evdev->ProvidesTimeStep());
+    evdev->SetCallback(&pollCallback);
+
+    fake.emit(false, EV_KEY, BTN_SOUTH, 1);
+    fake.emit(false, EV_SYN, SYN_REPORT, 0);
+    REQUIRE(waitFor([] { return lastButtons == JSMASK_S; }));
+
+    fake.emit(true, EV_ABS, ABS_RX, 2048);
+    fake.emit(true, EV_MSC, MSC_TIMESTAMP, 1000);
+    fake.emit(true, EV_SYN, SYN_REPORT, 0);
+    fake.emit(true, EV_MSC, MSC_TIMESTAMP, 5000);
+    fake.emit(true, EV_SYN, SYN_REPORT, 0);
+    REQUIRE(waitFor([] { return lastGyroX == 2.f; }));
+
+    evdev->DisconnectAndDisposeAll();
+    polling = nullptr;
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <chrono>
+#include <numbers>
+#include "FlickCurve.h"
+
+using Catch::Approx;
+using namespace std::chrono_literals;
+
+// Models under test:
+//
+//   FlickCurve(start, angle, flickTime, timeExponent)
+//     -> duration = flickTime * (|angle| / pi) ^ timeExponent
+//        percentDone(t) = (t - start) / duration, from 0 to 1
+//        rotation(t) = angle * (1 - (1 - percentDone(t))^2)
+
+
+using Clock = FlickCurve::Clock;
+static constexpr float kPi = std::numbers::pi_v<float>;
+
+// The rotation sent when the curve is sampled every tick until it is done, like the poll loop does
+static float sampledRotation(const FlickCurve &curve, Clock::time_point start, Clock::duration tick, int &samples) {
+    float sent = 0.f;
+    float previous = 0.f;
+    samples = 0;
+    for (auto now = start; now < curve.end() + tick; now += tick) {
+        float rotation = curve.rotation(now);
+        sent += rotation - previous;
+        previous = rotation;
+        ++samples;
+    }
+    return sent;
+}
+
+
+TEST_CASE("A flick eases out to its angle over the flick time") {
+    auto start = Clock::now();
+    FlickCurve curve(start, kPi / 2.f, 0.1f, 0.f);
+    REQUIRE(curve.end() - start == std::chrono::duration_cast<Clock::duration>(100ms));
+    REQUIRE(curve.rotation(start) == 0.f);
+    REQUIRE(curve.percentDone(start + 50ms) == Approx(0.5f));
+    REQUIRE(curve.rotation(start + 50ms) == Approx(kPi / 2.f * 0.75f));
+    REQUIRE(curve.rotation(start + 100ms) == Approx(kPi / 2.f));
+    REQUIRE(curve.rotation(start + 1s) == Approx(kPi / 2.f));
+}
+
+TEST_CASE("The time exponent scales the time with the size of the flick") {
+    auto start = Clock::now();
+    FlickCurve half(start, -kPi / 2.f, 0.1f, 1.f);
+    REQUIRE(half.percentDone(start + 25ms) == Approx(0.5f));
+    REQUIRE(half.percentDone(start + 50ms) == 1.f);
+    REQUIRE(half.rotation(start + 50ms) == Approx(-kPi / 2.f));
+    FlickCurve none(start, 0.f, 0.1f, 1.f);
+    REQUIRE(none.rotation(start + 50ms) == 0.f);
+}
+
+TEST_CASE("No flick time turns at once") {
+    auto start = Clock::now();
+    FlickCurve curve(start, 1.f, 0.f, 0.f);
+    REQUIRE(curve.end() == start);
+    REQUIRE(curve.rotation(start) == 1.f);
+}
+
+TEST_CASE("The tick time doesn't change the rotation of a flick") {
+    auto start = Clock::now();
+    FlickCurve curve(start, 2.f, 0.1f, 0.f);
+    int slowSamples = 0;
+    int fastSamples = 0;
+    float slow = sampledRotation(curve, start, 4ms, slowSamples);
+    float fast = sampledRotation(curve, start, 1ms, fastSamples);
+    REQUIRE(slowSamples < fastSamples);
+    REQUIRE(slow == Approx(2.f));
+    REQUIRE(fast == Approx(2.f));
+    // Same easing half way there
+    REQUIRE(curve.rotation(start + 48ms) == Approx(2.f * (1.f - 0.52f * 0.52f)));
+}
+
+TEST_CASE("A default curve is done with no rotation") {
+    FlickCurve curve;
+    REQUIRE(curve.percentDone(Clock::now()) == 1.f);
+    REQUIRE(curve.rotation(Clock::now()) == 0.f);
+}
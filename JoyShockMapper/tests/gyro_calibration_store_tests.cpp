@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "GyroCalibrationStore.h"
+
+using Catch::Approx;
+
+// Models under test:
+//
+//   GyroCalibrationStore(path).set(key, offset) / save() / load() / find(key)
+//     -> the offsets of each vendor id, product id and serial, as they were when saved
+
+
+static std::string storePath(const char *name) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+
+TEST_CASE("Offsets are found by vendor, product and serial") {
+    GyroCalibrationStore store(storePath("jsm_calibration_find.txt"));
+    store.set({ 0x054C, 0x0CE6, "a0:ab:51:00:11:22" }, { 0.5f, -0.25f, 1.f });
+    store.set({ 0x054C, 0x0CE6, "" }, { 2.f, 2.f, 2.f });
+
+    auto found = store.find({ 0x054C, 0x0CE6, "a0:ab:51:00:11:22" });
+    REQUIRE(found);
+    REQUIRE(found->x == 0.5f);
+    REQUIRE(found->y == -0.25f);
+    REQUIRE(store.find({ 0x054C, 0x0CE6, "" })->x == 2.f);
+    REQUIRE_FALSE(store.find({ 0x054C, 0x0CE6, "another" }));
+    REQUIRE_FALSE(store.find({ 0x054C, 0x09CC, "" }));
+}
+
+TEST_CASE("Offsets are the same after saving and loading") {
+    std::string path = storePath("jsm_calibration_round_trip.txt");
+    {
+        GyroCalibrationStore store(path);
+        REQUIRE(store.load()); // No file yet
+        store.set({ 0x057E, 0x2009, "" }, { 0.123456789f, -3.5f, 0.f });
+        store.set({ 0x054C, 0x05C4, "serial with spaces" }, { 1.f, 2.f, 3.f });
+        REQUIRE(store.save());
+    }
+    GyroCalibrationStore loaded(path);
+    REQUIRE(loaded.load());
+    auto pro = loaded.find({ 0x057E, 0x2009, "" });
+    REQUIRE(pro);
+    REQUIRE(pro->x == 0.123456789f);
+    REQUIRE(pro->y == -3.5f);
+    auto ds4 = loaded.find({ 0x054C, 0x05C4, "serial with spaces" });
+    REQUIRE(ds4);
+    REQUIRE(ds4->z == 3.f);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Lines that can't be read are skipped") {
+    std::string path = storePath("jsm_calibration_bad_lines.txt");
+    {
+        std::ofstream file(path);
+        file << "054c 0ce6 - 1 2 3\n"
+             << "garbage\n"
+             << "057e 2009 abc 1 2\n"
+             << "054c 09cc xyz 4 5 6\n";
+    }
+    GyroCalibrationStore store(path);
+    REQUIRE(store.load());
+    REQUIRE(store.find({ 0x054C, 0x0CE6, "" })->y == Approx(2.f));
+    REQUIRE_FALSE(store.find({ 0x057E, 0x2009, "abc" }));
+    REQUIRE(store.find({ 0x054C, 0x09CC, "xyz" })->z == Approx(6.f));
+    std::filesystem::remove(path);
+}
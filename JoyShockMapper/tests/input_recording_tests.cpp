@@ -0,0 +1,175 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "InputRecording.h"
+
+// Models under test:
+//
+//   InputRecording::Start / Record / Stop
+//     -> a file of one record per Record call
+//
+//   InputRecording::OpenReplay(path, realTime)
+//     -> a JslWrapper whose devices are the ones in the recording, and that runs the poll and touch
+//        callbacks once per record with the recorded frame, IMU reports and time step, then reports finished()
+
+
+static std::string tempPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static DeviceFrame makeFrame(int i) {
+    DeviceFrame frame{};
+    frame.buttons = 1 << (i % 20);
+    frame.leftX = 0.1f * i;
+    frame.leftY = -0.2f * i;
+    frame.rightX = 0.3f;
+    frame.rightY = -0.4f;
+    frame.leftTrigger = 0.5f;
+    frame.rightTrigger = 1.0f;
+    frame.imu = { 0.0f, 1.0f, 0.0f, 10.0f * i, -5.0f, 2.5f };
+    frame.touch.t0Down = i % 2 == 0;
+    frame.touch.t0X = 0.25f;
+    frame.touch.t0Y = 0.75f;
+    frame.timestamp = 1000000ull * i;
+    return frame;
+}
+
+// What the poll callback saw
+struct ReplayedTick {
+    int handle;
+    DeviceFrame frame;
+    int numReports;
+    std::vector<TimedImuState> reports;
+    float deltaTime;
+};
+
+static JslWrapper *replaying = nullptr;
+static std::vector<ReplayedTick> replayed;
+
+static void pollCallback(int handle, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float deltaTime) {
+    ReplayedTick tick{ handle, {}, 0, std::vector<TimedImuState>(8), deltaTime };
+    replaying->GetDeviceFrame(handle, tick.frame);
+    tick.numReports = replaying->GetIMUReports(handle, tick.reports.data(), int(tick.reports.size()));
+    replayed.push_back(tick);
+}
+
+static bool waitForTicks(size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (replayed.size() < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return replayed.size() >= count;
+}
+
+
+// ---------------------------------------------------------
+// 1. Round trip
+// ---------------------------------------------------------
+
+TEST_CASE("A recording replays the recorded frames") {
+    auto path = tempPath("jsm_recording_test.jsmr");
+    std::string error;
+    REQUIRE(InputRecording::Start(path, error));
+    REQUIRE(InputRecording::IsRecording());
+
+    InputRecording::DeviceInfo left{ 1, 3, 1, 0x057e, 0x2006 };
+    InputRecording::DeviceInfo right{ 2, 3, 2, 0x057e, 0x2007 };
+    TimedImuState reports[2] = { { { 0.f, 1.f, 0.f, 1.f, 2.f, 3.f }, 0.004f }, { { 0.f, 1.f, 0.f, 4.f, 5.f, 6.f }, 0.004f } };
+    InputRecording::Record(left, makeFrame(0), 0.008f, reports, 2);
+    InputRecording::Record(right, makeFrame(1), 0.008f, nullptr, -1);
+    InputRecording::Record(left, makeFrame(2), 0.009f, nullptr, 0);
+    REQUIRE(InputRecording::Stop() == 3);
+    REQUIRE_FALSE(InputRecording::IsRecording());
+
+    std::unique_ptr<InputRecording::Replay> replay(InputRecording::OpenReplay(path, false, error));
+    REQUIRE(replay);
+    REQUIRE(replay->ProvidesTimeStep());
+    REQUIRE_FALSE(replay->IsLive());
+    REQUIRE(replay->ConnectDevices() == 2);
+    int handles[2];
+    REQUIRE(replay->GetConnectedDeviceHandles(handles, 2) == 2);
+    REQUIRE(handles[0] == 1);
+    REQUIRE(handles[1] == 2);
+    REQUIRE(replay->GetControllerType(1) == 3);
+    REQUIRE(replay->GetControllerSplitType(2) == 2);
+    REQUIRE(replay->GetControllerProduct(2) == 0x2007);
+
+    replaying = replay.get();
+    replayed.clear();
+    replay->SetCallback(&pollCallback);
+    REQUIRE(waitForTicks(3));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!replay->finished() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(replay->finished());
+    REQUIRE(replay->position() > 0.0);
+    replay->DisconnectAndDisposeAll();
+
+    REQUIRE(replayed.size() == 3);
+    REQUIRE(replayed[0].handle == 1);
+    REQUIRE(replayed[1].handle == 2);
+    REQUIRE(replayed[2].handle == 1);
+    for (int i = 0; i < 3; ++i) {
+        auto expected = makeFrame(i);
+        auto &frame = replayed[i].frame;
+        REQUIRE(frame.buttons == expected.buttons);
+        REQUIRE(frame.leftX == expected.leftX);
+        REQUIRE(frame.leftY == expected.leftY);
+        REQUIRE(frame.rightTrigger == expected.rightTrigger);
+        REQUIRE(frame.imu.gyroX == expected.imu.gyroX);
+        REQUIRE(frame.touch.t0Down == expected.touch.t0Down);
+        REQUIRE(frame.touch.t0Y == expected.touch.t0Y);
+        REQUIRE(frame.timestamp == expected.timestamp);
+    }
+    REQUIRE(replayed[0].numReports == 2);
+    REQUIRE(replayed[0].reports[1].imu.gyroZ == 6.f);
+    REQUIRE(replayed[0].reports[1].deltaTime == 0.004f);
+    REQUIRE(replayed[1].numReports == -1);
+    REQUIRE(replayed[2].numReports == 0);
+    REQUIRE(replayed[2].deltaTime == 0.009f);
+
+    replaying = nullptr;
+    replay.reset();
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Nothing is recorded when not recording") {
+    REQUIRE_FALSE(InputRecording::IsRecording());
+    InputRecording::Record({}, makeFrame(0), 0.001f, nullptr, -1);
+    REQUIRE(InputRecording::Stop() == 0);
+}
+
+
+// ---------------------------------------------------------
+// 2. Invalid files
+// ---------------------------------------------------------
+
+TEST_CASE("Replay rejects files that aren't recordings") {
+    std::string error;
+    REQUIRE(InputRecording::OpenReplay(tempPath("jsm_recording_missing.jsmr"), true, error) == nullptr);
+    REQUIRE_FALSE(error.empty());
+
+    auto path = tempPath("jsm_recording_garbage.jsmr");
+    {
+        std::ofstream garbage(path, std::ios::binary);
+        garbage << "This is not a recording";
+    }
+    error.clear();
+    REQUIRE(InputRecording::OpenReplay(path, true, error) == nullptr);
+    REQUIRE_FALSE(error.empty());
+
+    // A header without any record
+    REQUIRE(InputRecording::Start(path, error));
+    InputRecording::Stop();
+    error.clear();
+    REQUIRE(InputRecording::OpenReplay(path, true, error) == nullptr);
+    REQUIRE_FALSE(error.empty());
+    std::remove(path.c_str());
+}
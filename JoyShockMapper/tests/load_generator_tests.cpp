@@ -0,0 +1,243 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LoadGenerator.h"
+
+// Models under test:
+//
+//   LoadGenerator::ParseArguments(command line)
+//     -> the config that follows --synthetic, if any
+//
+//   LoadGenerator::New(config)
+//     -> a JslWrapper with config.devices made up controllers, whose input only depends on the seed,
+//        and that reports its polling stats once per second
+//
+//   LoadGenerator::Generate(generator, tick)
+//     -> the devices as polling leaves them at tick, whichever ticks were skipped on the way
+
+
+static JslWrapper *generating = nullptr;
+static std::mutex tickLock;
+static std::vector<std::pair<int, DeviceFrame>> ticks;
+
+static void pollCallback(int handle, JOY_SHOCK_STATE, JOY_SHOCK_STATE, IMU_STATE, IMU_STATE, float) {
+    DeviceFrame frame;
+    generating->GetDeviceFrame(handle, frame);
+    std::lock_guard guard(tickLock);
+    ticks.emplace_back(handle, frame);
+}
+
+static size_t tickCount() {
+    std::lock_guard guard(tickLock);
+    return ticks.size();
+}
+
+static bool waitFor(size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (tickCount() < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return tickCount() >= count;
+}
+
+// Frames of every device at each of the ticks, without polling
+static std::vector<DeviceFrame> generate(const LoadGenerator::Config &config, const std::vector<uint64_t> &ticks) {
+    std::unique_ptr<JslWrapper> generator(LoadGenerator::New(config));
+    std::vector<DeviceFrame> frames;
+    for (uint64_t tick : ticks) {
+        LoadGenerator::Generate(generator.get(), tick);
+        for (int handle = 1; handle <= config.devices; ++handle) {
+            DeviceFrame frame;
+            generator->GetDeviceFrame(handle, frame);
+            frames.push_back(frame);
+        }
+    }
+    return frames;
+}
+
+static void requireSameFrame(const DeviceFrame &a, const DeviceFrame &b) {
+    REQUIRE(a.buttons == b.buttons);
+    REQUIRE(a.leftX == b.leftX);
+    REQUIRE(a.rightTrigger == b.rightTrigger);
+    REQUIRE(a.imu.gyroY == b.imu.gyroY);
+    REQUIRE(a.imu.accelZ == b.imu.accelZ);
+    REQUIRE(a.timestamp == b.timestamp);
+}
+
+// Frames of the first ticks of a generator
+static bool run(const LoadGenerator::Config &config, size_t count, std::vector<std::pair<int, DeviceFrame>> &frames) {
+    std::unique_ptr<JslWrapper> generator(LoadGenerator::New(config));
+    generating = generator.get();
+    ticks.clear();
+    generator->SetCallback(&pollCallback);
+    bool ticked = waitFor(count);
+    generator->DisconnectAndDisposeAll();
+    generating = nullptr;
+    frames.assign(ticks.begin(), ticks.begin() + std::min(count, ticks.size()));
+    return ticked;
+}
+
+
+// ---------------------------------------------------------
+// 1. Command line
+// ---------------------------------------------------------
+
+TEST_CASE("Synthetic devices are only made on request") {
+    REQUIRE_FALSE(LoadGenerator::ParseArguments({ "JoyShockMapper", "config.txt" }));
+}
+
+TEST_CASE("The options follow the number of devices") {
+    auto config = LoadGenerator::ParseArguments({ "JoyShockMapper", "--synthetic", "16", "TYPE=DS", "RATE=500", "NOISE=2",
+                                                  "STICKS=SWEEP", "BUTTONS=50", "SEED=7", "config.txt" });
+    REQUIRE(config);
+    REQUIRE(config->devices == 16);
+    REQUIRE(config->controllerType == JS_TYPE_DS);
+    REQUIRE(config->rate == 500.f);
+    REQUIRE(config->gyroNoise == 2.f);
+    REQUIRE(config->sticks == LoadGenerator::StickPattern::SWEEP);
+    REQUIRE(config->buttonRate == 50.f);
+    REQUIRE(config->seed == 7);
+}
+
+TEST_CASE("Invalid options give a config without devices") {
+    auto missing = LoadGenerator::ParseArguments({ "JoyShockMapper", "--synthetic" });
+    REQUIRE(missing);
+    REQUIRE(missing->devices == 0);
+
+    auto unknown = LoadGenerator::ParseArguments({ "JoyShockMapper", "--synthetic", "4", "TYPE=XBOX" });
+    REQUIRE(unknown);
+    REQUIRE(unknown->devices == 0);
+
+    auto negative = LoadGenerator::ParseArguments({ "JoyShockMapper", "--synthetic", "4", "RATE=-1" });
+    REQUIRE(negative);
+    REQUIRE(negative->devices == 0);
+}
+
+
+// ---------------------------------------------------------
+// 2. Devices
+// ---------------------------------------------------------
+
+TEST_CASE("Mixed devices cycle through DS4, DualSense and Joy-Con pairs") {
+    LoadGenerator::Config config;
+    config.devices = 5;
+    std::unique_ptr<JslWrapper> generator(LoadGenerator::New(config));
+    REQUIRE_FALSE(generator->IsLive());
+    REQUIRE(generator->ConnectDevices() == 5);
+    int handles[8];
+    REQUIRE(generator->GetConnectedDeviceHandles(handles, 8) == 5);
+    REQUIRE(handles[0] == 1);
+    REQUIRE(handles[4] == 5);
+    REQUIRE(generator->GetControllerType(1) == JS_TYPE_DS4);
+    REQUIRE(generator->GetControllerType(2) == JS_TYPE_DS);
+    REQUIRE(generator->GetControllerType(3) == JS_TYPE_JOYCON_LEFT);
+    REQUIRE(generator->GetControllerSplitType(3) == JS_SPLIT_TYPE_LEFT);
+    REQUIRE(generator->GetControllerType(4) == JS_TYPE_JOYCON_RIGHT);
+    REQUIRE(generator->GetControllerSplitType(4) == JS_SPLIT_TYPE_RIGHT);
+    REQUIRE(generator->GetControllerType(5) == JS_TYPE_DS4);
+    REQUIRE(generator->GetControllerType(6) == 0);
+
+    int sizeX = 0, sizeY = 0;
+    REQUIRE(generator->GetTouchpadDimension(2, sizeX, sizeY));
+    REQUIRE(sizeX > 0);
+    REQUIRE(generator->GetTouchpadDimension(3, sizeX, sizeY));
+    REQUIRE(sizeX == 0);
+}
+
+static LoadGenerator::Config randomConfig() {
+    LoadGenerator::Config config;
+    config.devices = 3;
+    config.rate = 200.f;
+    config.gyroNoise = 5.f;
+    config.sticks = LoadGenerator::StickPattern::RANDOM;
+    config.buttonRate = 100.f;
+    return config;
+}
+
+TEST_CASE("The same seed makes the same input") {
+    auto config = randomConfig();
+    std::vector<uint64_t> ticks;
+    for (uint64_t tick = 0; tick < 15; ++tick) {
+        ticks.push_back(tick);
+    }
+    auto first = generate(config, ticks);
+    auto second = generate(config, ticks);
+    REQUIRE(first.size() == 45);
+    for (size_t i = 0; i < first.size(); ++i) {
+        requireSameFrame(first[i], second[i]);
+    }
+
+    config.seed = 2;
+    auto other = generate(config, ticks);
+    bool differs = false;
+    for (size_t i = 0; i < first.size(); ++i) {
+        differs |= first[i].imu.gyroZ != other[i].imu.gyroZ;
+    }
+    REQUIRE(differs);
+}
+
+TEST_CASE("Skipped ticks don't change the input of the next ones") {
+    auto config = randomConfig();
+    std::vector<uint64_t> every;
+    for (uint64_t tick = 0; tick <= 40; ++tick) {
+        every.push_back(tick);
+    }
+    auto all = generate(config, every);
+    // As if polling had skipped ticks 1 to 4, 7 to 19 and 21 to 39
+    std::vector<uint64_t> overrun = { 0, 5, 6, 20, 40 };
+    auto late = generate(config, overrun);
+    for (size_t i = 0; i < overrun.size(); ++i) {
+        for (int device = 0; device < config.devices; ++device) {
+            requireSameFrame(late[i * config.devices + device], all[overrun[i] * config.devices + device]);
+        }
+    }
+}
+
+TEST_CASE("Joy-Con only use their own stick and buttons") {
+    LoadGenerator::Config config;
+    config.devices = 2;
+    config.controllerType = JS_TYPE_JOYCON_LEFT;
+    config.rate = 200.f;
+    config.buttonRate = 2000.f;
+    std::vector<std::pair<int, DeviceFrame>> frames;
+    REQUIRE(run(config, 6, frames));
+    for (auto &[handle, frame] : frames) {
+        if (handle == 1) {
+            REQUIRE(frame.rightX == 0.f);
+            REQUIRE(frame.rightTrigger == 0.f);
+            REQUIRE((frame.buttons & (JSMASK_N | JSMASK_E | JSMASK_S | JSMASK_W | JSMASK_R | JSMASK_ZR)) == 0);
+        } else {
+            REQUIRE(frame.leftX == 0.f);
+            REQUIRE(frame.leftTrigger == 0.f);
+            REQUIRE((frame.buttons & (JSMASK_UP | JSMASK_DOWN | JSMASK_LEFT | JSMASK_RIGHT | JSMASK_L | JSMASK_ZL)) == 0);
+        }
+    }
+}
+
+TEST_CASE("Polling stats are reported every second") {
+    LoadGenerator::Config config;
+    config.devices = 2;
+    config.rate = 100.f;
+    std::atomic<uint64_t> reportedTicks = 0;
+    std::unique_ptr<JslWrapper> generator(LoadGenerator::New(config, [&reportedTicks](const LoadGenerator::Stats &stats) {
+        reportedTicks = stats.ticks;
+    }));
+    generating = generator.get();
+    ticks.clear();
+    generator->SetCallback(&pollCallback);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (reportedTicks == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    generator->DisconnectAndDisposeAll();
+    generating = nullptr;
+    // Passes over both devices, about as many as the rate
+    REQUIRE(reportedTicks > 50);
+    REQUIRE(reportedTicks < 150);
+}
@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <utility>
+#include "InputHelpers.h"
+#include "SettingsManager.h"
+
+// Models under test:
+//
+//   moveMouse(x, y, remainder) with MOUSE_DPI_MULTIPLIER registered like main.cpp does
+//     -> whole counts scaled by the multiplier, sent to the output sink if there is one and to the OS otherwise,
+//        with the sub-count movement kept in the remainder of the controller
+//
+//   setMouseOutputRate(hz)
+//     -> the same counts, sent from the output thread
+//
+//   scrollMouse(notchesX, notchesY, remainder)
+//     -> high resolution wheel steps, 120 per notch, with what's smaller than a step kept in the remainder
+
+
+// Stand in for the platform: what moveMouse sends to the OS adds up here
+static std::atomic<int> sentX = 0;
+static std::atomic<int> sentY = 0;
+static int scrolledX = 0;
+static int scrolledY = 0;
+static OutputSink *sink = nullptr;
+
+void sendMouseMove(int x, int y) {
+    sentX += x;
+    sentY += y;
+}
+
+void sendMouseScroll(int hiResX, int hiResY) {
+    scrolledX += hiResX;
+    scrolledY += hiResY;
+}
+
+OutputSink *getOutputSink() {
+    return sink;
+}
+
+struct MoveSink : OutputSink {
+    int x = 0;
+    int y = 0;
+    int wheelY = 0;
+
+    void key(uint16_t, bool) override {}
+    void mouseMove(int moveX, int moveY) override {
+        x += moveX;
+        y += moveY;
+    }
+    void mouseScroll(int, int hiResY) override {
+        wheelY += hiResY;
+    }
+    void mouseAbsolute(float, float) override {}
+    Gamepad *newGamepad(ControllerScheme) override {
+        return nullptr;
+    }
+};
+
+// MOUSE_DPI_MULTIPLIER is a plain variable, not a chorded setting
+static void setDpiMultiplier(float multiplier) {
+    auto setting = SettingsManager::getV<float>(SettingID::MOUSE_DPI_MULTIPLIER);
+    if (!setting) {
+        setting = new JSMVariable<float>(1.0f);
+        SettingsManager::add(SettingID::MOUSE_DPI_MULTIPLIER, setting);
+    }
+    setting->set(multiplier);
+    sentX = 0;
+    sentY = 0;
+    scrolledX = 0;
+    scrolledY = 0;
+}
+
+
+TEST_CASE("Whole counts are sent and the rest is kept for the next move") {
+    setDpiMultiplier(1.0f);
+    MouseRemainder remainder;
+
+    moveMouse(2.5f, -1.5f, remainder);
+    REQUIRE(sentX == 2);
+    REQUIRE(sentY == -1);
+    REQUIRE(remainder.x == 0.5f);
+    REQUIRE(remainder.y == -0.5f);
+
+    moveMouse(0.75f, -0.75f, remainder);
+    REQUIRE(sentX == 3);
+    REQUIRE(sentY == -2);
+}
+
+TEST_CASE("Moves are scaled by the DPI multiplier before they're rounded") {
+    setDpiMultiplier(4.0f);
+    MouseRemainder remainder;
+
+    moveMouse(0.25f, 0.5f, remainder);
+    moveMouse(0.25f, 0.5f, remainder);
+    REQUIRE(sentX == 2);
+    REQUIRE(sentY == 4);
+    REQUIRE(remainder.x == 0.0f);
+}
+
+TEST_CASE("Controllers keep their own remainder") {
+    setDpiMultiplier(1.0f);
+    MouseRemainder first, second;
+
+    moveMouse(0.5f, 0.f, first);
+    moveMouse(0.5f, 0.f, second);
+    REQUIRE(sentX == 0);
+
+    moveMouse(0.5f, 0.f, first);
+    REQUIRE(sentX == 1);
+    REQUIRE(second.x == 0.5f);
+}
+
+TEST_CASE("An output sink takes the counts instead of the OS") {
+    setDpiMultiplier(2.0f);
+    MoveSink moves;
+    sink = &moves;
+    MouseRemainder remainder;
+
+    moveMouse(3.f, -1.f, remainder);
+    sink = nullptr;
+    REQUIRE(moves.x == 6);
+    REQUIRE(moves.y == -2);
+    REQUIRE(sentX == 0);
+}
+
+TEST_CASE("The output thread sends the same scaled counts") {
+    setDpiMultiplier(2.0f);
+    MouseRemainder remainder;
+
+    setMouseOutputRate(1000.f);
+    moveMouse(10.f, -5.f, remainder);
+    // Stopping the thread sends what is still pending
+    setMouseOutputRate(0.f);
+    REQUIRE(sentX == 20);
+    REQUIRE(sentY == -10);
+}
+
+TEST_CASE("Scrolling sends fractions of a notch") {
+    setDpiMultiplier(4.0f);
+    MouseRemainder remainder;
+
+    scrollMouse(0.f, 0.25f, remainder);
+    REQUIRE(scrolledY == 30);
+    scrollMouse(-0.5f, -1.f, remainder);
+    REQUIRE(scrolledX == -60);
+    REQUIRE(scrolledY == -90);
+    // Not scaled like mouse moves
+    REQUIRE(sentX == 0);
+}
+
+TEST_CASE("Scrolling smaller than a step adds up") {
+    setDpiMultiplier(1.0f);
+    MouseRemainder remainder;
+
+    scrollMouse(0.f, 1.f / 240.f, remainder);
+    REQUIRE(scrolledY == 0);
+    scrollMouse(0.f, 1.f / 240.f, remainder);
+    REQUIRE(scrolledY == 1);
+}
+
+TEST_CASE("An output sink takes the scrolling instead of the OS") {
+    setDpiMultiplier(1.0f);
+    MoveSink moves;
+    sink = &moves;
+    MouseRemainder remainder;
+
+    scrollMouse(0.f, -2.f, remainder);
+    sink = nullptr;
+    REQUIRE(moves.wheelY == -240);
+    REQUIRE(scrolledY == 0);
+}
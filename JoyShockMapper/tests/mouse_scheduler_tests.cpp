@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "MouseScheduler.h"
+
+using namespace std::chrono_literals;
+
+// Models under test:
+//
+//   MouseScheduler::submit(source, x, y, now) then step(t) for t after now
+//     -> the movement of a tick comes out in whole counts, spread evenly until the next tick is expected,
+//        and nothing is lost: the counts add up to the movement, minus the sub-pixel remainder
+//
+//   MouseScheduler::setRate(hz)
+//     -> a thread that calls Send about hz times per second while there is movement to send
+
+
+using Clock = MouseScheduler::Clock;
+
+// Step every period after start until end, and collect what came out at each step
+static std::vector<std::pair<int, int>> run(MouseScheduler &scheduler, Clock::time_point start, Clock::time_point end, Clock::duration period) {
+    std::vector<std::pair<int, int>> steps;
+    for (auto now = start + period; now <= end; now += period) {
+        steps.push_back(scheduler.step(now));
+    }
+    return steps;
+}
+
+// A source that has ticked every 4ms until start
+static void tickEvery4ms(MouseScheduler &scheduler, const void *source, Clock::time_point start) {
+    for (int tick = 10; tick > 0; --tick) {
+        scheduler.submit(source, 0.f, 0.f, start - tick * 4ms);
+    }
+}
+
+
+TEST_CASE("A tick's movement is spread until the next tick") {
+    MouseScheduler scheduler([](int, int) {});
+    int source = 0;
+    auto start = Clock::now();
+    tickEvery4ms(scheduler, &source, start);
+    scheduler.submit(&source, 40.f, -20.f, start);
+
+    auto steps = run(scheduler, start, start + 4ms, 500us);
+    REQUIRE(steps.size() == 8);
+    int totalX = 0, totalY = 0;
+    for (auto [x, y] : steps) {
+        REQUIRE(x == 5);
+        REQUIRE((y == -2 || y == -3));
+        totalX += x;
+        totalY += y;
+    }
+    REQUIRE(totalX == 40);
+    REQUIRE(totalY == -20);
+    REQUIRE(scheduler.step(start + 5ms) == std::pair(0, 0));
+}
+
+TEST_CASE("Sub-pixel movement adds up across ticks") {
+    MouseScheduler scheduler([](int, int) {});
+    int source = 0;
+    auto start = Clock::now();
+    tickEvery4ms(scheduler, &source, start);
+    int total = 0;
+    for (int tick = 0; tick < 12; ++tick) {
+        auto tickAt = start + tick * 4ms;
+        scheduler.submit(&source, 0.25f, 0.f, tickAt);
+        for (auto [x, y] : run(scheduler, tickAt, tickAt + 4ms, 2ms)) {
+            total += x;
+        }
+    }
+    REQUIRE(total == 3);
+}
+
+TEST_CASE("Movement left when the next tick comes early is spread with it") {
+    MouseScheduler scheduler([](int, int) {});
+    int source = 0;
+    auto start = Clock::now();
+    tickEvery4ms(scheduler, &source, start);
+    scheduler.submit(&source, 8.f, 0.f, start);
+    int total = 0;
+    for (auto [x, y] : run(scheduler, start, start + 2ms, 1ms)) {
+        total += x;
+    }
+    REQUIRE(total == 4);
+    scheduler.submit(&source, 8.f, 0.f, start + 2ms);
+    for (auto [x, y] : run(scheduler, start + 2ms, start + 10ms, 1ms)) {
+        total += x;
+    }
+    REQUIRE(total == 16);
+}
+
+TEST_CASE("Sources keep their own remainder") {
+    MouseScheduler scheduler([](int, int) {});
+    int left = 0, right = 0;
+    auto start = Clock::now();
+    scheduler.submit(&left, 0.6f, 0.f, start);
+    scheduler.submit(&right, 0.6f, 0.f, start);
+    // Two remainders of 0.6 don't make a count together
+    REQUIRE(scheduler.step(start + 200ms) == std::pair(0, 0));
+    scheduler.submit(&left, 0.6f, 0.f, start + 200ms);
+    REQUIRE(scheduler.step(start + 400ms) == std::pair(1, 0));
+}
+
+TEST_CASE("The thread sends at the rate") {
+    std::atomic<int> sends = 0;
+    std::atomic<int> total = 0;
+    MouseScheduler scheduler([&](int x, int) {
+        ++sends;
+        total += x;
+    });
+    int source = 0;
+    scheduler.setRate(1000.f);
+    REQUIRE(scheduler.running());
+    auto start = Clock::now();
+    scheduler.submit(&source, 0.f, 0.f, start - 50ms);
+    scheduler.submit(&source, 1000.f, 0.f, start); // Spread over 50ms
+    // The spread movement comes out over several sends
+    for (int wait = 0; wait < 1000 && sends < 3; ++wait) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(sends >= 3);
+    scheduler.setRate(0.f);
+    REQUIRE_FALSE(scheduler.running());
+    // Stopping sends what was still pending
+    REQUIRE(total == 1000);
+}
+
+TEST_CASE("A path is read on every step until it ends") {
+    MouseScheduler scheduler([](int, int) {});
+    int source = 0;
+    auto start = Clock::now();
+    // 1 count per ms for 10ms
+    scheduler.play(&source, [start](Clock::time_point now) {
+        return std::pair{ std::chrono::duration<float, std::milli>(now - start).count(), 0.f };
+    }, start + 10ms);
+    REQUIRE(scheduler.step(start + 2ms) == std::pair(2, 0));
+    REQUIRE(scheduler.step(start + 3ms) == std::pair(1, 0));
+    REQUIRE(scheduler.step(start + 20ms) == std::pair(7, 0));
+    REQUIRE(scheduler.step(start + 30ms) == std::pair(0, 0));
+}
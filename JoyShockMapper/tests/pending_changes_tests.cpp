@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "PendingChanges.h"
+
+// Models under test:
+//
+//   PendingChanges::publish(change) from any number of threads, then apply() on one
+//     -> every change runs once, on the thread that applies, in the order each thread published them
+
+
+TEST_CASE("Changes run in the order they were published") {
+    PendingChanges changes;
+    std::vector<int> ran;
+    for (int i = 0; i < 5; ++i) {
+        changes.publish([&ran, i] { ran.push_back(i); });
+    }
+    REQUIRE(ran.empty());
+    REQUIRE(changes.apply() == 5);
+    REQUIRE((ran == std::vector<int>{ 0, 1, 2, 3, 4 }));
+    REQUIRE(changes.apply() == 0);
+}
+
+TEST_CASE("A change can own what it hands over") {
+    PendingChanges changes;
+    std::unique_ptr<int> target;
+    changes.publish([&target, value = std::make_unique<int>(7)]() mutable { target = std::move(value); });
+    changes.apply();
+    REQUIRE(target);
+    REQUIRE(*target == 7);
+}
+
+TEST_CASE("Changes that are never applied are dropped") {
+    auto owned = std::make_shared<int>(0);
+    {
+        PendingChanges changes;
+        changes.publish([owned] {});
+        REQUIRE(owned.use_count() == 2);
+    }
+    REQUIRE(owned.use_count() == 1);
+}
+
+TEST_CASE("Publishers don't wait for the thread that applies") {
+    PendingChanges changes;
+    constexpr int kPublishers = 4;
+    constexpr int kEach = 10000;
+    std::vector<std::vector<int>> ran(kPublishers);
+    std::vector<std::thread> publishers;
+    for (int p = 0; p < kPublishers; ++p) {
+        publishers.emplace_back([&changes, &ran, p] {
+            for (int i = 0; i < kEach; ++i) {
+                changes.publish([&ran, p, i] { ran[p].push_back(i); });
+            }
+        });
+    }
+    size_t applied = 0;
+    while (applied < kPublishers * kEach) {
+        applied += changes.apply();
+    }
+    for (auto &publisher : publishers) {
+        publisher.join();
+    }
+    for (auto &sequence : ran) {
+        REQUIRE(sequence.size() == kEach);
+        bool ordered = true;
+        for (int i = 0; i < kEach; ++i) {
+            ordered &= sequence[i] == i;
+        }
+        REQUIRE(ordered);
+    }
+}
@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MotionIf.h"
+#include "Smoothing.h"
+#include "CurveEngine.h"
+#include "LoadGenerator.h"
+#include "AllocationCounter.h"
+
+// Per tick cost of the gyro path of joyShockPollCallback, stage by stage and end to end:
+//
+//   motion fusion  MotionIf::ProcessMotion + GetCalibratedGyro
+//   smoothing      RunningWindow over GYRO_SMOOTH_TIME at TICK_TIME
+//   accel curve    CurveEngine::evaluate for X and Y
+//
+// fed with the motion reports of a DS4 made up by LoadGenerator. Only this gyro path runs with ctest, which fails if a
+// tick allocates. The timings are hidden from the default run: `jsm_benchmarks [benchmark]` reports ns per tick.
+//
+// The whole pipeline, sticks, buttons, settings lookups and the poll callback included, needs the settings registry
+// of main.cpp, so JoyShockMapper itself times it on a short recording:
+//
+//   JoyShockMapper --benchmark tests/data/pipeline.jsmr tests/data/pipeline_benchmark.txt
+//
+// Configure with JSM_COUNT_ALLOCATIONS=ON for that to count allocations as well.
+
+
+// ---------------------------------------------------------
+// Generated input
+// ---------------------------------------------------------
+
+// IMU report in deg/s and g
+struct ImuReport {
+    float gyroX, gyroY, gyroZ;
+    float accelX, accelY, accelZ;
+};
+
+// 4 seconds of a DS4 at 250 Hz, the same on every run
+static const std::vector<ImuReport> &generatedReports() {
+    static std::vector<ImuReport> reports;
+    if (reports.empty()) {
+        LoadGenerator::Config config;
+        config.devices = 1;
+        config.controllerType = JS_TYPE_DS4;
+        config.rate = 250.f;
+        std::unique_ptr<JslWrapper> generator(LoadGenerator::New(config));
+        for (uint64_t tick = 0; tick < 1000; ++tick) {
+            LoadGenerator::Generate(generator.get(), tick);
+            DeviceFrame frame;
+            generator->GetDeviceFrame(1, frame);
+            auto &imu = frame.imu;
+            reports.push_back({ imu.gyroX, imu.gyroY, imu.gyroZ, imu.accelX, imu.accelY, imu.accelZ });
+        }
+    }
+    return reports;
+}
+
+struct GyroPipeline {
+    static constexpr float TICK_SECONDS = 0.004f;
+
+    std::unique_ptr<MotionIf> motion{ MotionIf::getNew() };
+    RunningWindow<256> smoothX;
+    RunningWindow<256> smoothY;
+    CurveEngine curve;
+    float outputX = 0.0f;
+    float outputY = 0.0f;
+
+    explicit GyroPipeline(bool curveTable) {
+        CurveParams params;
+        params.shape = CurveShape::SIGMOID;
+        params.minThreshold = 0.0f;
+        params.maxThreshold = 75.0f;
+        params.sigmoidMid = 20.0f;
+        params.sigmoidWidth = 8.0f;
+        curve.configure(params, curveTable);
+        motion->SetAutoCalibration(true, 1.0f, 0.02f);
+    }
+
+    void tick(const ImuReport &report) {
+        motion->ProcessMotion(report.gyroX, report.gyroY, report.gyroZ, report.accelX, report.accelY, report.accelZ, TICK_SECONDS);
+        float gyroX, gyroY, gyroZ;
+        motion->GetCalibratedGyro(gyroX, gyroY, gyroZ);
+        gyroX = smoothX.push(gyroX, 32);
+        gyroY = smoothY.push(gyroY, 32);
+        float sensX, sensY;
+        curve.evaluate(std::sqrt(gyroX * gyroX + gyroY * gyroY), 1.0f, 3.0f, 1.0f, 3.0f, sensX, sensY);
+        outputX += gyroX * sensX * TICK_SECONDS;
+        outputY += gyroY * sensY * TICK_SECONDS;
+    }
+};
+
+
+// ---------------------------------------------------------
+// 1. Allocations
+// ---------------------------------------------------------
+
+TEST_CASE("Gyro pipeline doesn't allocate", "[benchmark]") {
+    auto &reports = generatedReports();
+    for (bool table : { false, true }) {
+        GyroPipeline pipeline(table);
+        pipeline.tick(reports[0]); // Let anything lazily initialized happen first
+
+        size_t before = *AllocationCount();
+        for (auto &report : reports) {
+            pipeline.tick(report);
+        }
+        size_t allocations = *AllocationCount() - before;
+        INFO((table ? "curve table" : "exact curve"));
+        REQUIRE(allocations == 0);
+    }
+}
+
+
+// ---------------------------------------------------------
+// 2. Time per tick
+// ---------------------------------------------------------
+
+TEST_CASE("Gyro pipeline cost per tick", "[.][benchmark]") {
+    auto &reports = generatedReports();
+    size_t next = 0;
+
+    auto motion = std::unique_ptr<MotionIf>(MotionIf::getNew());
+    BENCHMARK("motion fusion") {
+        auto &report = reports[next++ % reports.size()];
+        motion->ProcessMotion(report.gyroX, report.gyroY, report.gyroZ, report.accelX, report.accelY, report.accelZ, GyroPipeline::TICK_SECONDS);
+        float x, y, z;
+        motion->GetCalibratedGyro(x, y, z);
+        return x + y + z;
+    };
+
+    RunningWindow<256> window;
+    BENCHMARK("smoothing, 32 sample window") {
+        return window.push(reports[next++ % reports.size()].gyroX, 32);
+    };
+
+    GyroPipeline exact(false);
+    BENCHMARK("full tick") {
+        exact.tick(reports[next++ % reports.size()]);
+        return exact.outputX;
+    };
+
+    GyroPipeline table(true);
+    BENCHMARK("full tick, curve table") {
+        table.tick(reports[next++ % reports.size()]);
+        return table.outputX;
+    };
+}
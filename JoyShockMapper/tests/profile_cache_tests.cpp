@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "ProfileCache.h"
+
+// Models under test:
+//
+//   ProfileCache::stamp(path, modified, content) / unchanged(stamp)
+//     -> whether a file still has the content it had when it was stamped
+//
+//   ProfileCache.store(profile) / find(path)
+//     -> the profile compiled from a file, as long as the file is unchanged
+
+
+static std::filesystem::path writeProfile(const char *name, const std::string &content) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << content;
+    return path;
+}
+
+static std::shared_ptr<ProfileCache::Profile> compile(const std::filesystem::path &path, int *runs) {
+    std::ifstream file(path, std::ios::binary);
+    std::string content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    auto profile = std::make_shared<ProfileCache::Profile>();
+    profile->file = ProfileCache::stamp(path, std::filesystem::last_write_time(path), content);
+    profile->steps.push_back([runs] { ++*runs; });
+    return profile;
+}
+
+
+TEST_CASE("An untouched file is unchanged") {
+    auto path = writeProfile("jsm_profile_untouched.txt", "RESET_MAPPINGS\nS = A\n");
+    int runs = 0;
+    auto stamp = compile(path, &runs)->file;
+
+    REQUIRE(ProfileCache::unchanged(stamp));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("A file with content of another size is changed") {
+    auto path = writeProfile("jsm_profile_longer.txt", "S = A\n");
+    int runs = 0;
+    auto stamp = compile(path, &runs)->file;
+    writeProfile("jsm_profile_longer.txt", "S = SPACE\n");
+
+    REQUIRE_FALSE(ProfileCache::unchanged(stamp));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("A file with other content of the same size is changed") {
+    auto path = writeProfile("jsm_profile_edited.txt", "S = A\n");
+    int runs = 0;
+    auto stamp = compile(path, &runs)->file;
+    writeProfile("jsm_profile_edited.txt", "S = B\n");
+    std::filesystem::last_write_time(path, stamp.modified + std::chrono::seconds(2));
+
+    REQUIRE_FALSE(ProfileCache::unchanged(stamp));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("A removed file is changed") {
+    auto path = writeProfile("jsm_profile_removed.txt", "S = A\n");
+    int runs = 0;
+    auto stamp = compile(path, &runs)->file;
+    std::filesystem::remove(path);
+
+    REQUIRE_FALSE(ProfileCache::unchanged(stamp));
+}
+
+TEST_CASE("A file saved with the same content is unchanged") {
+    auto path = writeProfile("jsm_profile_saved.txt", "S = A\n");
+    int runs = 0;
+    auto stamp = compile(path, &runs)->file;
+    auto saved = stamp.modified + std::chrono::seconds(2);
+    std::filesystem::last_write_time(path, saved);
+
+    REQUIRE(ProfileCache::unchanged(stamp));
+    // The hash isn't needed next time
+    REQUIRE(stamp.modified == saved);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("The hash tells apart content of the same size") {
+    REQUIRE(ProfileCache::hash("S = A\n") == ProfileCache::hash("S = A\n"));
+    REQUIRE(ProfileCache::hash("S = A\n") != ProfileCache::hash("S = B\n"));
+    REQUIRE(ProfileCache::hash("AB") != ProfileCache::hash("BA"));
+}
+
+TEST_CASE("Stored profiles are found until their file changes") {
+    auto path = writeProfile("jsm_profile_cached.txt", "S = A\n");
+    ProfileCache cache;
+    int runs = 0;
+    REQUIRE_FALSE(cache.find(path));
+
+    cache.store(compile(path, &runs));
+    auto profile = cache.find(path);
+    REQUIRE(profile);
+    for (auto &step : profile->steps) {
+        step();
+    }
+    REQUIRE(runs == 1);
+
+    writeProfile("jsm_profile_cached.txt", "S = SPACE\n");
+    REQUIRE_FALSE(cache.find(path));
+    // Changed profiles are dropped
+    REQUIRE(cache.size() == 0);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Storing a profile again replaces it") {
+    auto path = writeProfile("jsm_profile_replaced.txt", "S = A\n");
+    ProfileCache cache;
+    int first = 0, second = 0;
+    cache.store(compile(path, &first));
+    cache.store(compile(path, &second));
+
+    REQUIRE(cache.size() == 1);
+    for (auto &step : cache.find(path)->steps) {
+        step();
+    }
+    REQUIRE(first == 0);
+    REQUIRE(second == 1);
+    std::filesystem::remove(path);
+}
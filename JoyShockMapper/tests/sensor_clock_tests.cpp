@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "SensorClock.h"
+
+using Catch::Approx;
+
+// Models under test:
+//
+//   SensorClock::step(timestampNs, deltaTime)
+//     -> deltaTime = time since the previous report, 0 for the first one.
+//        Reports that aren't newer than the previous one are refused and counted as duplicated.
+//        A gap well over the usual interval counts the reports that should have been in it as dropped,
+//        unless the following gaps are as long: then the rate went down and nothing was dropped.
+
+
+TEST_CASE("Time steps come from the timestamps") {
+    SensorClock clock;
+    float deltaTime = -1.f;
+    REQUIRE(clock.step(5000000, deltaTime));
+    REQUIRE(deltaTime == 0.f);
+    REQUIRE(clock.step(9000000, deltaTime));
+    REQUIRE(deltaTime == Approx(0.004f));
+    REQUIRE(clock.step(13000000, deltaTime));
+    REQUIRE(deltaTime == Approx(0.004f));
+    REQUIRE(clock.stats().dropped == 0);
+    REQUIRE(clock.stats().duplicated == 0);
+}
+
+TEST_CASE("Repeated reports are refused") {
+    SensorClock clock;
+    float deltaTime = 0.f;
+    clock.step(1000000, deltaTime);
+    clock.step(2000000, deltaTime);
+    REQUIRE_FALSE(clock.step(2000000, deltaTime));
+    REQUIRE_FALSE(clock.step(1500000, deltaTime));
+    REQUIRE(clock.stats().duplicated == 2);
+    // The next report is timed from the last one that was taken
+    REQUIRE(clock.step(3000000, deltaTime));
+    REQUIRE(deltaTime == Approx(0.001f));
+}
+
+TEST_CASE("Gaps count the reports missing from them") {
+    SensorClock clock;
+    float deltaTime = 0.f;
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 20; ++i) {
+        timestamp += 1000000;
+        clock.step(timestamp, deltaTime);
+    }
+    REQUIRE(clock.stats().dropped == 0);
+
+    timestamp += 4000000; // 3 missing
+    REQUIRE(clock.step(timestamp, deltaTime));
+    REQUIRE(deltaTime == Approx(0.004f)); // The whole gap is still integrated
+    REQUIRE(clock.stats().dropped == 3);
+
+    // Jitter isn't a drop
+    timestamp += 1300000;
+    clock.step(timestamp, deltaTime);
+    timestamp += 700000;
+    clock.step(timestamp, deltaTime);
+    REQUIRE(clock.stats().dropped == 3);
+}
+
+TEST_CASE("The usual interval follows slower reports") {
+    SensorClock clock;
+    float deltaTime = 0.f;
+    clock.step(0, deltaTime);
+    clock.step(1000000, deltaTime);
+    // The first interval was short. Once the reports come every 1.4ms for a while, they aren't drops.
+    uint64_t timestamp = 1000000;
+    for (int i = 0; i < 100; ++i) {
+        timestamp += 1400000;
+        clock.step(timestamp, deltaTime);
+    }
+    uint64_t dropped = clock.stats().dropped;
+    timestamp += 1400000;
+    clock.step(timestamp, deltaTime);
+    REQUIRE(clock.stats().dropped == dropped);
+
+    clock.reset();
+    REQUIRE(clock.stats().dropped == 0);
+}
+
+TEST_CASE("A lasting slower rate isn't counted as drops") {
+    SensorClock clock;
+    float deltaTime = 0.f;
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 20; ++i) {
+        timestamp += 1000000;
+        clock.step(timestamp, deltaTime);
+    }
+    // From 1000 down to 250 reports per second
+    for (int i = 0; i < 20; ++i) {
+        timestamp += 4000000;
+        clock.step(timestamp, deltaTime);
+    }
+    REQUIRE(clock.stats().dropped == 0);
+
+    // Drops are still seen at the new rate
+    timestamp += 8000000;
+    clock.step(timestamp, deltaTime);
+    REQUIRE(clock.stats().dropped == 1);
+}
@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SettingsTransaction.h"
+#include "JSMVariable.hpp"
+
+// Models under test:
+//
+//   SettingsTransaction() / ~SettingsTransaction()
+//   SettingsTransaction::notify(owner, notify) / forget(owner)
+//     -> notifications of the owners that changed, once per owner when the outermost transaction ends
+//   JSMVariable::changedAt() / setAt()
+//     -> a commit listener deriving one variable from another leaves alone a value set after the change
+
+
+// Notifies like JSMVariable does for its commit listeners
+struct Setting {
+    int value = 0;
+    std::vector<int> heard;
+    std::function<void(int)> listener;
+
+    ~Setting() {
+        SettingsTransaction::forget(this);
+    }
+
+    void set(int next) {
+        int old = value;
+        value = next;
+        if (value != old) {
+            SettingsTransaction::notify(this, [this, old] {
+                if (value != old) {
+                    heard.push_back(value);
+                    if (listener) {
+                        listener(value);
+                    }
+                }
+            });
+        }
+    }
+};
+
+
+TEST_CASE("Changes notify right away outside of a transaction") {
+    Setting setting;
+    setting.set(1);
+    setting.set(2);
+
+    REQUIRE(setting.heard == std::vector<int>{ 1, 2 });
+}
+
+TEST_CASE("A transaction notifies once with the final value") {
+    Setting setting;
+    {
+        SettingsTransaction transaction;
+        setting.set(1);
+        setting.set(2);
+        setting.set(3);
+        REQUIRE(setting.heard.empty());
+    }
+    REQUIRE(setting.heard == std::vector<int>{ 3 });
+}
+
+TEST_CASE("A setting changed back during a transaction doesn't notify") {
+    Setting setting;
+    {
+        SettingsTransaction transaction;
+        setting.set(1);
+        setting.set(0);
+    }
+    REQUIRE(setting.heard.empty());
+}
+
+TEST_CASE("Nested transactions notify when the outermost one ends") {
+    Setting setting;
+    {
+        SettingsTransaction outer;
+        {
+            SettingsTransaction inner;
+            setting.set(1);
+        }
+        REQUIRE(setting.heard.empty());
+        setting.set(2);
+    }
+    REQUIRE(setting.heard == std::vector<int>{ 2 });
+}
+
+TEST_CASE("Settings notify in the order they first changed") {
+    std::vector<std::string> order;
+    Setting first, second;
+    first.listener = [&](int) { order.push_back("first"); };
+    second.listener = [&](int) { order.push_back("second"); };
+    {
+        SettingsTransaction transaction;
+        second.set(1);
+        first.set(1);
+        second.set(2);
+    }
+    REQUIRE(order == std::vector<std::string>{ "second", "first" });
+}
+
+TEST_CASE("A deleted setting isn't notified") {
+    auto setting = std::make_unique<Setting>();
+    Setting other;
+    {
+        SettingsTransaction transaction;
+        setting->set(1);
+        other.set(1);
+        setting.reset();
+    }
+    REQUIRE(other.heard == std::vector<int>{ 1 });
+}
+
+TEST_CASE("A setting deleted by a listener isn't notified") {
+    auto deleted = std::make_unique<Setting>();
+    Setting setting;
+    setting.listener = [&](int) { deleted.reset(); };
+    {
+        SettingsTransaction transaction;
+        setting.set(1);
+        deleted->set(1);
+    }
+    REQUIRE(setting.heard == std::vector<int>{ 1 });
+    REQUIRE_FALSE(deleted);
+}
+
+TEST_CASE("Settings changed by a listener notify right away") {
+    Setting derived;
+    Setting setting;
+    setting.listener = [&](int value) { derived.set(value * 10); };
+    {
+        SettingsTransaction transaction;
+        setting.set(1);
+    }
+    REQUIRE(derived.heard == std::vector<int>{ 10 });
+}
+
+TEST_CASE("A listener can open a transaction of its own") {
+    Setting derived;
+    Setting setting;
+    setting.listener = [&](int value) {
+        SettingsTransaction transaction;
+        derived.set(value);
+        derived.set(value * 10);
+        REQUIRE(derived.heard.empty());
+    };
+    {
+        SettingsTransaction transaction;
+        setting.set(1);
+    }
+    REQUIRE(derived.heard == std::vector<int>{ 10 });
+}
+
+// Follows source into derived like a stick mode sets its ring mode, unless derived was set since
+static void follow(JSMVariable<int> &source, JSMVariable<int> &derived) {
+    source.addOnCommitListener([&](int value) {
+        if (derived.setAt() < source.changedAt()) {
+            derived.set(value * 10);
+        }
+    });
+}
+
+TEST_CASE("A derived variable follows a change committed after it was set") {
+    JSMVariable<int> source(0), derived(0);
+    follow(source, derived);
+    {
+        SettingsTransaction transaction;
+        derived.set(5);
+        source.set(1);
+    }
+    REQUIRE(derived.value() == 10);
+}
+
+TEST_CASE("A derived variable set after the change keeps its value") {
+    JSMVariable<int> source(0), derived(0);
+    follow(source, derived);
+    {
+        SettingsTransaction transaction;
+        source.set(1);
+        derived.set(5);
+    }
+    REQUIRE(derived.value() == 5);
+}
+
+TEST_CASE("A derived variable set to the value it has after the change keeps it") {
+    JSMVariable<int> source(0), derived(5);
+    follow(source, derived);
+    {
+        SettingsTransaction transaction;
+        source.set(1);
+        derived.set(5);
+    }
+    REQUIRE(derived.value() == 5);
+}
@@ -0,0 +1,155 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+#include <vector>
+#include "Smoothing.h"
+
+using Catch::Approx;
+
+// Models under test:
+//
+//   RunningWindow<Capacity>::push(value, windowSize)
+//     -> mean of the last windowSize pushed values, with values never pushed counting as 0.
+//        windowSize is clamped to [1, Capacity].
+//
+//   ExponentialFilter::apply(value, timeConstant, deltaTime)
+//     -> y += (1 - exp(-dt/tau)) * (x - y), starting at the first value
+//
+//   OneEuroFilter::apply(value, minCutoff, beta, deltaTime)
+//     -> low pass whose cutoff is minCutoff + beta * |dx/dt|, starting at the first value
+
+
+// Reference: mean of the last windowSize entries of history
+static float windowMean(const std::vector<float> &history, int windowSize) {
+    double sum = 0.0;
+    for (int i = 0; i < windowSize; ++i) {
+        int index = int(history.size()) - 1 - i;
+        if (index >= 0) {
+            sum += history[index];
+        }
+    }
+    return float(sum / windowSize);
+}
+
+
+// ---------------------------------------------------------
+// 1. Running window
+// ---------------------------------------------------------
+
+TEST_CASE("RunningWindow matches a recomputed mean") {
+    RunningWindow<64> window;
+    std::vector<float> history;
+
+    for (int i = 0; i < 1000; ++i) {
+        float value = std::sin(i * 0.1f) * 100.0f + float(i % 5);
+        history.push_back(value);
+        REQUIRE(window.push(value, 20) == Approx(windowMean(history, 20)).margin(1e-3f));
+    }
+}
+
+TEST_CASE("RunningWindow counts unfilled slots as zero") {
+    RunningWindow<16> window;
+
+    REQUIRE(window.push(8.0f, 4) == Approx(2.0f));
+    REQUIRE(window.push(8.0f, 4) == Approx(4.0f));
+}
+
+TEST_CASE("RunningWindow follows window size changes") {
+    RunningWindow<32> window;
+    std::vector<float> history;
+
+    for (int i = 0; i < 200; ++i) {
+        float value = float(i);
+        history.push_back(value);
+        int size = i < 100 ? 10 : 25;
+        REQUIRE(window.push(value, size) == Approx(windowMean(history, size)).margin(1e-3f));
+    }
+}
+
+TEST_CASE("RunningWindow clamps the window to its capacity") {
+    RunningWindow<8> window;
+    std::vector<float> history;
+
+    for (int i = 0; i < 50; ++i) {
+        float value = float(i % 3);
+        history.push_back(value);
+        REQUIRE(window.push(value, 100) == Approx(windowMean(history, 8)).margin(1e-5f));
+    }
+    REQUIRE(window.push(5.0f, 0) == Approx(5.0f));
+}
+
+TEST_CASE("RunningWindow does not drift over long runs") {
+    RunningWindow<128> window;
+    std::vector<float> history;
+
+    float result = 0.0f;
+    for (int i = 0; i < 200000; ++i) {
+        float value = (i % 2 ? 1000.0f : -999.9f) + std::sin(i * 0.001f);
+        history.push_back(value);
+        result = window.push(value, 100);
+    }
+    REQUIRE(result == Approx(windowMean(history, 100)).margin(1e-3f));
+}
+
+TEST_CASE("RunningWindow reset clears the history") {
+    RunningWindow<16> window;
+    for (int i = 0; i < 20; ++i) {
+        window.push(10.0f, 4);
+    }
+    window.reset();
+    REQUIRE(window.push(4.0f, 4) == Approx(1.0f));
+}
+
+
+// ---------------------------------------------------------
+// 2. Exponential filter
+// ---------------------------------------------------------
+
+TEST_CASE("ExponentialFilter starts at the first value") {
+    ExponentialFilter filter;
+    REQUIRE(filter.apply(3.0f, 0.1f, 0.001f) == Approx(3.0f));
+}
+
+TEST_CASE("ExponentialFilter step response follows 1 - exp(-t/tau)") {
+    ExponentialFilter filter;
+    float tau = 0.05f;
+    float dt = 0.001f;
+
+    filter.apply(0.0f, tau, dt);
+    float y = 0.0f;
+    for (int i = 0; i < 50; ++i) {
+        y = filter.apply(1.0f, tau, dt);
+    }
+    REQUIRE(y == Approx(1.0f - std::exp(-50 * dt / tau)).margin(1e-4f));
+}
+
+
+// ---------------------------------------------------------
+// 3. One Euro filter
+// ---------------------------------------------------------
+
+TEST_CASE("OneEuroFilter settles on a constant input") {
+    OneEuroFilter filter;
+    filter.apply(0.0f, 1.0f, 0.01f, 0.001f);
+    float y = 0.0f;
+    for (int i = 0; i < 5000; ++i) {
+        y = filter.apply(2.0f, 1.0f, 0.01f, 0.001f);
+    }
+    REQUIRE(y == Approx(2.0f).margin(1e-3f));
+}
+
+TEST_CASE("OneEuroFilter with a higher beta lags less on fast movement") {
+    OneEuroFilter slow;
+    OneEuroFilter fast;
+    float dt = 0.001f;
+    float ySlow = 0.0f;
+    float yFast = 0.0f;
+
+    for (int i = 0; i < 100; ++i) {
+        float ramp = i * 1.0f;
+        ySlow = slow.apply(ramp, 1.0f, 0.0f, dt);
+        yFast = fast.apply(ramp, 1.0f, 0.1f, dt);
+    }
+    REQUIRE(yFast > ySlow);
+    REQUIRE(yFast <= 99.0f);
+}
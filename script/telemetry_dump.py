@@ -10,6 +10,7 @@ import argparse
 import json
 import signal
 import socket
+import struct
 import sys
 import time
 from typing import Optional
@@ -17,6 +18,57 @@ from typing import Optional
 
 stop_requested = False
 
+# Binary layout (protocol v3), see JoyShockMapper/include/Telemetry.h
+TELEMETRY_MAGIC = b"JSMT"
+PACKET_SAMPLE = 1
+PACKET_ROSTER = 2
+HEADER = struct.Struct("<4sHH")
+SAMPLE = struct.Struct("<Q10f16s")
+ROSTER = struct.Struct("<I")
+DEVICE = struct.Struct("<5i")
+
+
+def decode_devices(data: bytes) -> list:
+    (device_count,) = ROSTER.unpack_from(data, HEADER.size)
+    devices = []
+    offset = HEADER.size + ROSTER.size
+    for _ in range(device_count):
+        if offset + DEVICE.size > len(data):
+            break
+        handle, dev_type, split, vid, pid = DEVICE.unpack_from(data, offset)
+        devices.append({"handle": handle, "type": dev_type, "split": split, "vid": vid, "pid": pid})
+        offset += DEVICE.size
+    return devices
+
+
+def decode_packet(data: bytes) -> Optional[dict]:
+    """Decode a binary packet, falling back to the JSON format."""
+    if data[:4] != TELEMETRY_MAGIC:
+        return json.loads(data.decode("utf-8", errors="ignore"))
+
+    _, proto_ver, packet_type = HEADER.unpack_from(data)
+    if packet_type == PACKET_ROSTER:
+        return {"protoVer": proto_ver, "type": "roster", "devices": decode_devices(data)}
+    if packet_type != PACKET_SAMPLE:
+        return None
+    (ts, omega, t, sens_x, sens_y, min_thr, max_thr,
+     smin_x, smax_x, smin_y, smax_y, curve) = SAMPLE.unpack_from(data, HEADER.size)
+    return {
+        "protoVer": proto_ver,
+        "ts": ts,
+        "omega": omega,
+        "t": t,
+        "sensX": sens_x,
+        "sensY": sens_y,
+        "minThr": min_thr,
+        "maxThr": max_thr,
+        "SminX": smin_x,
+        "SmaxX": smax_x,
+        "SminY": smin_y,
+        "SmaxY": smax_y,
+        "curve": curve.split(b"\0", 1)[0].decode("ascii", errors="ignore"),
+    }
+
 
 def _handle_sigint(signum, frame):
     del signum, frame
@@ -50,11 +102,16 @@ def main() -> None:
         except KeyboardInterrupt:
             break
 
-        line = data.decode("utf-8", errors="ignore")
         try:
-            payload = json.loads(line)
-        except json.JSONDecodeError:
-            print(f"Malformed packet: {line[:120]}...", file=sys.stderr)
+            payload = decode_packet(data)
+        except (json.JSONDecodeError, struct.error):
+            print(f"Malformed packet: {data[:120]!r}...", file=sys.stderr)
+            continue
+        if payload is None:
+            continue
+        if payload.get("type") == "roster":
+            devices = ", ".join(f"{d.get('vid', 0):04x}:{d.get('pid', 0):04x}" for d in payload.get("devices", []))
+            print(f"[{time.strftime('%H:%M:%S')}] devices: {devices or 'none'}")
             continue
 
         omega = payload.get("omega")